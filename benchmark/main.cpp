@@ -0,0 +1,106 @@
+#include <memory_resource.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+
+namespace
+{
+  constexpr std::size_t batch_size = 256U;
+
+  // allocates and deallocates the batches of differently sized blocks
+  double measure(std::pmr::memory_resource& resource, std::size_t iterations)
+  {
+    void* blocks[batch_size];
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0U; i < iterations; ++i)
+    {
+      for (std::size_t j = 0U; j < batch_size; ++j)
+      {
+        blocks[j] = resource.allocate(8U + (j % 32U) * 8U, 8U);
+      }
+      for (std::size_t j = 0U; j < batch_size; ++j)
+      {
+        resource.deallocate(blocks[j], 8U + (j % 32U) * 8U, 8U);
+      }
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    const std::chrono::duration<double, std::nano> elapsed = stop - start;
+    return elapsed.count() / static_cast<double>(iterations * batch_size);
+  }
+
+  // the batches of equally sized blocks allocated and deallocated by the bulk requests
+  double measure_bulk(stdx::pmr::test_resource& resource, std::size_t iterations)
+  {
+    void* blocks[batch_size];
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0U; i < iterations; ++i)
+    {
+      const std::size_t size = 8U + (i % 32U) * 8U;
+      resource.allocate_bulk(blocks, batch_size, size, 8U);
+      resource.deallocate_bulk(blocks, batch_size, size, 8U);
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    const std::chrono::duration<double, std::nano> elapsed = stop - start;
+    return elapsed.count() / static_cast<double>(iterations * batch_size);
+  }
+
+  void run(const char* name, std::pmr::memory_resource& resource, std::size_t iterations, double baseline)
+  {
+    const double ns = measure(resource, iterations);
+    if (baseline > 0.0)
+    {
+      printf("%-32s %8.1f ns/op %6.2fx\n", name, ns, ns / baseline);
+    }
+    else
+    {
+      printf("%-32s %8.1f ns/op\n", name, ns);
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  const std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000U;
+
+  using single_thread_test_resource = stdx::pmr::basic_test_resource<
+    stdx::pmr::null_lock_policy,
+    stdx::pmr::padding_guard_policy,
+    stdx::pmr::scribble_policy,
+    stdx::pmr::list_tracking_policy,
+    stdx::pmr::sharded_stats_policy>;
+
+  auto* upstream = std::pmr::new_delete_resource();
+  stdx::pmr::stats_test_resource stats{ "stats", false, upstream };
+  single_thread_test_resource single{ "single_thread", false, upstream };
+  stdx::pmr::test_resource checked{ "checked", false, upstream };
+
+  // warm up the upstream
+  measure(*upstream, iterations / 10U + 1U);
+
+  const double baseline = measure(*upstream, iterations);
+  printf("%-32s %8.1f ns/op\n", "new_delete_resource", baseline);
+  run("stats_test_resource", stats, iterations, baseline);
+  run("basic_test_resource<null_lock>", single, iterations, baseline);
+  run("test_resource", checked, iterations, baseline);
+
+  const double bulk = measure_bulk(checked, iterations);
+  printf("%-32s %8.1f ns/op %6.2fx\n", "test_resource (bulk)", bulk, bulk / baseline);
+
+  {
+    const auto trace = std::filesystem::temp_directory_path() / "memory_resource_benchmark.trace";
+    stdx::pmr::test_resource_trace_recorder recorder{ trace };
+    checked.set_trace_recorder(&recorder);
+    run("test_resource (traced)", checked, iterations, baseline);
+    checked.set_trace_recorder(nullptr);
+    recorder.flush();
+    printf("%-32s %8lld events, %lld dropped\n", "", recorder.events(), recorder.dropped());
+  }
+
+  return 0;
+}
@@ -0,0 +1,143 @@
+#include <memory_resource.h>
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory_resource>
+
+// Replays an allocation trace written by test_resource_trace_recorder against
+// the standard resources and test_resource:
+//
+//   MemoryResourceReplay [--threads] [trace]
+//
+// Without a trace a synthetic one is recorded first.
+
+namespace
+{
+  // the blocks of the mixed sizes, some of them living long
+  void record_workload(const std::filesystem::path& path)
+  {
+    stdx::pmr::test_resource_trace_recorder recorder{ path, std::chrono::milliseconds(1), 1U << 20U };
+    stdx::pmr::test_resource resource{ "workload", false, std::pmr::new_delete_resource() };
+    resource.set_trace_recorder(&recorder);
+
+    const auto work = [&resource](unsigned seed) {
+      std::deque<std::pair<void*, std::size_t>> blocks;
+      for (unsigned i = 0U; i < 100000U; ++i)
+      {
+        seed = seed * 1103515245U + 12345U;
+        const std::size_t bytes = 0U == (seed >> 24U) % 16U ? 1024U + (seed >> 8U) % 8192U : 8U + (seed >> 8U) % 256U;
+        blocks.emplace_back(resource.allocate(bytes), bytes);
+        if (blocks.size() > 64U + (seed >> 16U) % 256U)
+        {
+          resource.deallocate(blocks.front().first, blocks.front().second);
+          blocks.pop_front();
+        }
+      }
+      for (const auto& [p, bytes] : blocks)
+      {
+        resource.deallocate(p, bytes);
+      }
+    };
+    std::thread other{ work, 7U };
+    work(1U);
+    other.join();
+  }
+
+  void print(const char* name, const stdx::pmr::test_resource_replay_result& result)
+  {
+    char footprint[24] = "-";
+    if (0LL != result.m_peakFootprint)
+    {
+      snprintf(footprint, sizeof(footprint), "%lld", result.m_peakFootprint / 1024LL);
+    }
+    printf("%-40s %8.2f %7llu %7llu %7llu %7llu %7llu %10zu %10s\n", name,
+      result.throughput() * 1e-6,
+      static_cast<unsigned long long>(result.m_allocationLatency.m_p50),
+      static_cast<unsigned long long>(result.m_allocationLatency.m_p99),
+      static_cast<unsigned long long>(result.m_allocationLatency.m_p999),
+      static_cast<unsigned long long>(result.m_deallocationLatency.m_p50),
+      static_cast<unsigned long long>(result.m_deallocationLatency.m_p99),
+      result.m_peakBytes / 1024U,
+      footprint);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  bool threaded = false;
+  std::filesystem::path path;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (0 == std::strcmp(argv[i], "--threads"))
+    {
+      threaded = true;
+    }
+    else
+    {
+      path = argv[i];
+    }
+  }
+
+  const bool synthetic = path.empty();
+  if (synthetic)
+  {
+    path = std::filesystem::temp_directory_path() / "memory_resource_replay.trace";
+    record_workload(path);
+  }
+
+  const stdx::pmr::test_resource_trace_replay replay{ path };
+  if (!replay.is_open())
+  {
+    fprintf(stderr, "%s is not an allocation trace\n", path.string().c_str());
+    return 1;
+  }
+  printf("%zu operations of %zu threads, %zu unmatched deallocations, replayed %s\n\n",
+    replay.operations(), replay.threads(), replay.unmatched(), threaded ? "by the threads" : "by one thread");
+  printf("%-40s %8s %7s %7s %7s %7s %7s %10s %10s\n",
+    "", "Mops/s", "a.p50", "a.p99", "a.p999", "d.p50", "d.p99", "live KiB", "peak KiB");
+
+  using upstream_t = std::pmr::memory_resource;
+  const std::pmr::pool_options small_pools{ 16U, 512U };
+  const std::pmr::pool_options large_pools{ 256U, 16384U };
+
+  const auto run = [&](const char* name, const stdx::pmr::test_resource_trace_replay::factory& make) {
+    print(name, replay.run(make, threaded));
+  };
+
+  // the footprint of new_delete_resource is not seen by the counting upstream
+  print("new_delete_resource", replay.run(*std::pmr::new_delete_resource(), threaded));
+  if (!threaded)
+  {
+    run("monotonic_buffer_resource", [](upstream_t& upstream) {
+      return std::make_unique<std::pmr::monotonic_buffer_resource>(&upstream);
+    });
+    run("unsynchronized_pool_resource", [](upstream_t& upstream) {
+      return std::make_unique<std::pmr::unsynchronized_pool_resource>(&upstream);
+    });
+    run("unsynchronized_pool_resource{16, 512}", [&small_pools](upstream_t& upstream) {
+      return std::make_unique<std::pmr::unsynchronized_pool_resource>(small_pools, &upstream);
+    });
+  }
+  run("synchronized_pool_resource", [](upstream_t& upstream) {
+    return std::make_unique<std::pmr::synchronized_pool_resource>(&upstream);
+  });
+  run("synchronized_pool_resource{16, 512}", [&small_pools](upstream_t& upstream) {
+    return std::make_unique<std::pmr::synchronized_pool_resource>(small_pools, &upstream);
+  });
+  run("synchronized_pool_resource{256, 16384}", [&large_pools](upstream_t& upstream) {
+    return std::make_unique<std::pmr::synchronized_pool_resource>(large_pools, &upstream);
+  });
+  run("stats_test_resource", [](upstream_t& upstream) {
+    return std::make_unique<stdx::pmr::stats_test_resource>("replay", false, &upstream);
+  });
+  run("test_resource", [](upstream_t& upstream) {
+    return std::make_unique<stdx::pmr::test_resource>("replay", false, &upstream);
+  });
+
+  if (synthetic)
+  {
+    std::filesystem::remove(path);
+  }
+  return 0;
+}
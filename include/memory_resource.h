@@ -2,24 +2,72 @@
 #define STDX_MEMORYRESOURCE_H
 
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
 #include <cstdarg>
 #include <cstddef>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <memory_resource>
 #include <mutex>
+#include <string>
 #include <string_view>
+#include <thread>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(__AVX2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 namespace stdx::pmr
 {
-  class test_resource;
+  struct mutex_lock_policy;
+  struct padding_guard_policy;
+  struct scribble_policy;
+  struct list_tracking_policy;
+  struct sharded_stats_policy;
+
+  template<typename LockPolicy, typename GuardPolicy, typename ScribblePolicy, typename TrackingPolicy, typename StatsPolicy>
+  class basic_test_resource;
+
+  // the basic_test_resource with every check enabled
+  using test_resource = basic_test_resource<
+    mutex_lock_policy,
+    padding_guard_policy,
+    scribble_policy,
+    list_tracking_policy,
+    sharded_stats_policy>;
 
   namespace detail
   {
@@ -61,6 +109,16 @@ namespace stdx::pmr
         overrunBy);
     }
 
+    void report_write_after_free(
+      const test_resource& tr,
+      const void* address,
+      std::size_t bytes,
+      std::size_t alignment,
+      std::size_t offset)
+    {
+      do_report_write_after_free(tr, address, bytes, alignment, offset);
+    }
+
     void report_print(const test_resource& tr)
     {
       do_report_print(tr);
@@ -78,6 +136,10 @@ namespace stdx::pmr
     [[nodiscard]]
     static const detail::test_resource_list* test_resource_list(const test_resource& tr) noexcept;
 
+    // the size of the padding after the user segment of the block allocated by 'tr'
+    [[nodiscard]]
+    static std::size_t tail_padding_size(const test_resource& tr, std::size_t bytes, std::size_t alignment) noexcept;
+
   private:
     virtual void do_report_allocation(const test_resource& tr) = 0;
 
@@ -92,6 +154,15 @@ namespace stdx::pmr
       int underrunBy,
       int overrunBy) = 0;
 
+    // not pure, so the reporters written before the write after free detection keep compiling;
+    // the default passes the report to do_report_log_msg
+    virtual void do_report_write_after_free(
+      const test_resource& tr,
+      const void* address,
+      std::size_t bytes,
+      std::size_t alignment,
+      std::size_t offset);
+
     virtual void do_report_print(const test_resource& tr) = 0;
 
     virtual void do_report_log_msg(const char* format, va_list args) = 0;
@@ -145,8 +216,159 @@ namespace stdx::pmr
     // byte (1011 0001) used to write over newly-allocated memory and padding
     inline constexpr std::byte padded_memory_byte{ 0xB1U };
 
+    /**
+     * \brief Finds the first byte of the range [first, last) which is not 'value'.
+     *        The range is compared by whole vectors (AVX2, SSE2 or 64-bit words);
+     *        bytes are scanned only within the first mismatching vector.
+     * \param first the beginning of the range
+     * \param last the end of the range
+     * \param value the expected value of the bytes
+     * \return the address of the first corrupted byte or 'last' if the range is intact
+     */
+    inline const std::byte* find_first_corrupted(
+      const std::byte* first,
+      const std::byte* last,
+      std::byte value = padded_memory_byte) noexcept
+    {
+      const std::uint64_t pattern64 = std::to_integer<std::uint64_t>(value) * 0x0101010101010101ULL;
+#if defined(__AVX2__)
+      const __m256i pattern256 = _mm256_set1_epi8(static_cast<char>(value));
+      for (; last - first >= 32; first += 32)
+      {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, pattern256)) != -1)
+        {
+          break;
+        }
+      }
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+      const __m128i pattern128 = _mm_set1_epi8(static_cast<char>(value));
+      for (; last - first >= 16; first += 16)
+      {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern128)) != 0xFFFF)
+        {
+          break;
+        }
+      }
+#endif
+      for (; last - first >= 8; first += 8)
+      {
+        std::uint64_t word;
+        memcpy(&word, first, sizeof(word));
+        if (word != pattern64)
+        {
+          break;
+        }
+      }
+      // locate the corrupted byte within the mismatching vector (or the tail)
+      for (; first < last; ++first)
+      {
+        if (value != *first)
+        {
+          return first;
+        }
+      }
+      return last;
+    }
+
+    /**
+     * \brief Finds the last byte of the range [first, last) which is not 'value'.
+     *        The range is compared backwards by whole vectors (AVX2, SSE2 or 64-bit words);
+     *        bytes are scanned only within the last mismatching vector.
+     * \param first the beginning of the range
+     * \param last the end of the range
+     * \param value the expected value of the bytes
+     * \return the address of the last corrupted byte or nullptr if the range is intact
+     */
+    inline const std::byte* find_last_corrupted(
+      const std::byte* first,
+      const std::byte* last,
+      std::byte value = padded_memory_byte) noexcept
+    {
+      const std::uint64_t pattern64 = std::to_integer<std::uint64_t>(value) * 0x0101010101010101ULL;
+#if defined(__AVX2__)
+      const __m256i pattern256 = _mm256_set1_epi8(static_cast<char>(value));
+      for (; last - first >= 32; last -= 32)
+      {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(last - 32));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, pattern256)) != -1)
+        {
+          break;
+        }
+      }
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+      const __m128i pattern128 = _mm_set1_epi8(static_cast<char>(value));
+      for (; last - first >= 16; last -= 16)
+      {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last - 16));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern128)) != 0xFFFF)
+        {
+          break;
+        }
+      }
+#endif
+      for (; last - first >= 8; last -= 8)
+      {
+        std::uint64_t word;
+        memcpy(&word, last - 8, sizeof(word));
+        if (word != pattern64)
+        {
+          break;
+        }
+      }
+      // locate the corrupted byte within the mismatching vector (or the head)
+      while (first < last)
+      {
+        if (value != *--last)
+        {
+          return last;
+        }
+      }
+      return nullptr;
+    }
+
+    /**
+     * \brief Fills the range [first, first + size) with 'scribbled_memory_byte'
+     *        by the non-temporal stores bypassing the cache (SSE2);
+     *        without SSE2 it falls back to memset.
+     * \param first the beginning of the range
+     * \param size the size of the range
+     */
+    inline void stream_scribble(void* first, std::size_t size) noexcept
+    {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+      auto* pc = static_cast<std::byte*>(first);
+      auto* const last = pc + size;
+      // the streaming stores require 16-byte aligned addresses
+      const auto misalignment = reinterpret_cast<std::uintptr_t>(pc) & 15U;
+      const std::size_t head = misalignment ? 16U - misalignment : 0U;
+      if (size < head + 16U)
+      {
+        memset(first, std::to_integer<unsigned char>(scribbled_memory_byte), size);
+        return;
+      }
+
+      memset(pc, std::to_integer<unsigned char>(scribbled_memory_byte), head);
+      pc += head;
+      const __m128i pattern = _mm_set1_epi8(static_cast<char>(scribbled_memory_byte));
+      for (; last - pc >= 16; pc += 16)
+      {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(pc), pattern);
+      }
+      memset(pc, std::to_integer<unsigned char>(scribbled_memory_byte), static_cast<std::size_t>(last - pc));
+      // order the streaming stores before the memory is given back
+      _mm_sfence();
+#else
+      memset(first, std::to_integer<unsigned char>(scribbled_memory_byte), size);
+#endif
+    }
+
     // Holds pointers to the next and preceding allocated
     // memory block in the allocated memory block list.
+    // The block is embedded in the header of each allocation.
     struct block
     {
       long long m_index;  // index of this allocation
@@ -174,13 +396,21 @@ namespace stdx::pmr
     struct header
     {
       std::uint32_t m_magic_number;  // allocated/deallocated/other identifier
+      std::uint32_t m_alignment_log2 : 8;  // log2 of the allocation alignment
+      std::uint32_t m_stack_id : 24;       // id of the allocation call stack (0 - not captured)
       std::size_t   m_bytes;         // number of available bytes in this block
-      std::size_t   m_alignment;     // the allocation alignment
-      long long     m_index;         // index of this memory allocation
-      block*        m_address;       // address of block in linked list
+      block         m_block;         // index of this memory allocation and
+                                     // the links of the list of allocated blocks
       void*         m_pmr;           // address of current PMR
       padding       m_padding;       // padding -- guaranteed to extend to the
                                      // end of the struct
+
+      [[nodiscard]]
+      std::size_t alignment() const noexcept
+      {
+        // the header of an invalid block may hold any value
+        return m_alignment_log2 < sizeof(std::size_t) * 8U ? std::size_t{ 1U } << m_alignment_log2 : 0U;
+      }
     };
 
     // let make the size of header structure be always 64B (on 32 and 64 bits OS)
@@ -199,91 +429,214 @@ namespace stdx::pmr
 
     using aligned_header_base = aligned_header_base_helper<header>;
 
-    // to suppress MSVC warning C4324:
-    // structure was padded due to alignment specifier
-    template<std::size_t Align>
-    struct aligned_header_with_additional_padding_base : aligned_header_base
+    /**
+     * \brief Returns the header embedding the specified memory block 'mblock'
+     * \param mblock address of the memory block embedded in the header of an allocation
+     * \return the address of the header
+     */
+    [[nodiscard]]
+    inline header* header_of(block* mblock) noexcept
+    {
+      return reinterpret_cast<header*>(reinterpret_cast<std::byte*>(mblock) - offsetof(header, m_block));
+    }
+
+    // the fields of an outstanding memory block copied by test_resource_list::for_each()
+    struct block_info
     {
-        std::byte _2[Align - sizeof(aligned_header_base)] = {};
+      long long     m_index;    // index of the allocation
+      std::size_t   m_bytes;    // size of the user segment
+      std::size_t   m_alignment;
+      std::uint32_t m_stackId;  // id of the allocation call stack (0 - not captured)
+      const void*   m_address;  // address of the user segment
     };
 
+    // The magic number is accessed atomically only where the threads deallocating
+    // the same block may race; the header lives in the raw memory of the block,
+    // so it is not a std::atomic (and std::atomic_ref needs C++20).
+    [[nodiscard]]
+    inline std::uint32_t load_magic_number(const header& head) noexcept
+    {
+#if defined(_MSC_VER)
+      return static_cast<std::uint32_t>(*reinterpret_cast<const volatile long*>(&head.m_magic_number));
+#else
+      return __atomic_load_n(&head.m_magic_number, __ATOMIC_ACQUIRE);
+#endif
+    }
+
+    inline void store_magic_number(header& head, std::uint32_t value) noexcept
+    {
+#if defined(_MSC_VER)
+      _InterlockedExchange(reinterpret_cast<volatile long*>(&head.m_magic_number), static_cast<long>(value));
+#else
+      __atomic_store_n(&head.m_magic_number, value, __ATOMIC_RELEASE);
+#endif
+    }
+
+    /**
+     * \brief Stamps the allocated block as deallocated unless another thread has done it
+     * \param head the header of the block
+     * \return true if the calling thread has claimed the deallocation of the block
+     */
+    [[nodiscard]]
+    inline bool claim_deallocation(header& head) noexcept
+    {
+#if defined(_MSC_VER)
+      return static_cast<long>(allocated_memory_pattern) == _InterlockedCompareExchange(
+        reinterpret_cast<volatile long*>(&head.m_magic_number),
+        static_cast<long>(deallocated_memory_pattern),
+        static_cast<long>(allocated_memory_pattern));
+#else
+      std::uint32_t expected = allocated_memory_pattern;
+      return __atomic_compare_exchange_n(&head.m_magic_number, &expected, deallocated_memory_pattern,
+        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+    }
+
     constexpr std::size_t checked_alignment(std::size_t alignment) noexcept
     {
       return std::max(alignment, max_natural_alignment);
     }
 
-    // Maximally-aligned raw buffer big enough for a header.
+    // The user segment aligned to more than the size of the header has the compact header:
+    //  ---------------------------------------------------------------------------------
+    //  | [SLACK] | OFFSET | HEADER + PADDING | USER SEGMENT | PADDING |
+    //  ---------------------------------------------------------------------------------
+    // The user segment is aligned inside the naturally aligned upstream block and the offset
+    // back to the beginning of the upstream block precedes the header of the fixed size.
+    constexpr bool is_compact_header(std::size_t alignment) noexcept
+    {
+      return alignment > sizeof(aligned_header_base);
+    }
+
     template<std::size_t Align>
-    struct aligned_header;
+    inline constexpr bool is_compact_header_v = is_compact_header(Align);
+
+    // log2 of the largest alignment having its own instantiation of the allocation functions
+    inline constexpr std::size_t max_static_alignment_log2 = 12U;
+    // log2 of the largest supported alignment (2 MiB huge page)
+    inline constexpr std::size_t max_alignment_log2 = 21U;
+    inline constexpr std::size_t max_alignment = std::size_t{ 1U } << max_alignment_log2;
+
+    // the alignment template argument of the allocation functions
+    // taking the alignment at runtime
+    inline constexpr std::size_t runtime_alignment = 0U;
+
+    template<std::size_t Log2>
+    inline constexpr std::size_t static_alignment_v =
+      Log2 <= max_static_alignment_log2 ? std::size_t{ 1U } << Log2 : runtime_alignment;
+
+    /**
+     * \brief Returns the number of consecutive 0 bits in the value of 'value',
+     *        starting from the least significant bit
+     * \param value the non-zero value
+     * \return the number of trailing zero bits
+     */
+    [[nodiscard]]
+    constexpr std::size_t countr_zero(std::size_t value) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<std::size_t>(__builtin_ctzll(value));
+#else
+      std::size_t count = 0U;
+      for (; 0U == (value & 1U); value >>= 1U)
+      {
+        ++count;
+      }
+      return count;
+#endif
+    }
+
+    /**
+     * \brief Returns the number of bits needed to represent the value of 'value'
+     * \param value the value
+     * \return 1 + the index of the most significant 1 bit, 0 if 'value' is 0
+     */
+    [[nodiscard]]
+    constexpr std::size_t bit_width(std::uint64_t value) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return 0U == value ? 0U : 64U - static_cast<std::size_t>(__builtin_clzll(value));
+#else
+      std::size_t width = 0U;
+      for (; 0U != value; value >>= 1U)
+      {
+        ++width;
+      }
+      return width;
+#endif
+    }
+
+    constexpr std::size_t header_alignment(std::size_t alignment) noexcept
+    {
+      return checked_alignment(std::min(alignment, sizeof(aligned_header_base)));
+    }
 
+    // Maximally-aligned raw buffer big enough for a header.
     template<std::size_t Align>
-    using base_type = std::conditional_t<
-        Align <= sizeof(aligned_header_base),
-        aligned_header_base,
-        aligned_header_with_additional_padding_base<checked_alignment(Align)>>;
+    struct aligned_header;
 
     template<>
-    struct alignas(checked_alignment(1U)) aligned_header<1U> : base_type<1U>
+    struct alignas(header_alignment(1U)) aligned_header<1U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(2U)) aligned_header<2U> : base_type<2U>
+    struct alignas(header_alignment(2U)) aligned_header<2U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(4U)) aligned_header<4U> : base_type<4U>
+    struct alignas(header_alignment(4U)) aligned_header<4U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(8U)) aligned_header<8U> : base_type<8U>
+    struct alignas(header_alignment(8U)) aligned_header<8U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(16U)) aligned_header<16U> : base_type<16U>
+    struct alignas(header_alignment(16U)) aligned_header<16U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(32U)) aligned_header<32U> : base_type<32U>
+    struct alignas(header_alignment(32U)) aligned_header<32U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(64U)) aligned_header<64U> : base_type<64U>
+    struct alignas(header_alignment(64U)) aligned_header<64U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(128U)) aligned_header<128U> : base_type<128U>
+    struct alignas(header_alignment(128U)) aligned_header<128U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(256U)) aligned_header<256U> : base_type<256U>
+    struct alignas(header_alignment(256U)) aligned_header<256U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(512U)) aligned_header<512U> : base_type<512U>
+    struct alignas(header_alignment(512U)) aligned_header<512U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(1024U)) aligned_header<1024U> : base_type<1024U>
+    struct alignas(header_alignment(1024U)) aligned_header<1024U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(2048U)) aligned_header<2048U> : base_type<2048U>
+    struct alignas(header_alignment(2048U)) aligned_header<2048U> : aligned_header_base
     {
     };
 
     template<>
-    struct alignas(checked_alignment(4096U)) aligned_header<4096U> : base_type<4096U>
+    struct alignas(header_alignment(4096U)) aligned_header<4096U> : aligned_header_base
     {
     };
 
@@ -293,60 +646,102 @@ namespace stdx::pmr
     template<std::size_t Align>
     inline constexpr auto aligned_header_align_v = alignof(aligned_header<Align>);
 
+    /**
+     * \brief Returns the size of the aligned header for the runtime 'alignment'
+     * \param alignment the alignment of the user segment
+     * \return the size of the aligned header or 0 if the alignment is not supported
+     * \note The header has the same size for all the supported alignments.
+     */
+    [[nodiscard]]
+    constexpr std::size_t aligned_header_size(std::size_t alignment) noexcept
+    {
+      return is_power_of_two(alignment) && alignment <= max_alignment ? sizeof(aligned_header_base) : 0U;
+    }
+
     inline header* get_header(void *p, std::size_t alignment)
     {
-      std::size_t aligned_header_size = 0;
-      switch (alignment)
+      const std::size_t aligned_header_size = detail::aligned_header_size(alignment);
+      return aligned_header_size ? reinterpret_cast<header*>(reinterpret_cast<std::intptr_t>(p) - aligned_header_size) : nullptr;
+    }
+
+    // the result of the checks of a memory block being deallocated
+    struct block_check
+    {
+      std::size_t m_size = 0U;
+      int m_underrunBy = 0;
+      int m_overrunBy = 0;
+      bool m_miscError = false;
+      bool m_paramError = false;
+
+      [[nodiscard]]
+      bool ok() const noexcept
       {
-      case 1U:
-        aligned_header_size = aligned_header_size_v<1U>;
-        break;
-      case 2U:
-        aligned_header_size = aligned_header_size_v<2U>;
-        break;
-      case 4U:
-        aligned_header_size = aligned_header_size_v<4U>;
-        break;
-      case 8U:
-        aligned_header_size = aligned_header_size_v<8U>;
-        break;
-      case 16U:
-        aligned_header_size = aligned_header_size_v<16U>;
-        break;
-      case 32U:
-        aligned_header_size = aligned_header_size_v<32U>;
-        break;
-      case 64U:
-        aligned_header_size = aligned_header_size_v<64U>;
-        break;
-      case 128U:
-        aligned_header_size = aligned_header_size_v<128U>;
-        break;
-      case 256U:
-        aligned_header_size = aligned_header_size_v<256U>;
-        break;
-      case 512U:
-        aligned_header_size = aligned_header_size_v<512U>;
-        break;
-      case 1024U:
-        aligned_header_size = aligned_header_size_v<1024U>;
-        break;
-      case 2048U:
-        aligned_header_size = aligned_header_size_v<2048U>;
-        break;
-      case 4096U:
-        aligned_header_size = aligned_header_size_v<4096U>;
-        break;
-      default:
-        break;
+        return !m_miscError && !m_paramError && !m_underrunBy && !m_overrunBy;
       }
+    };
 
-      return aligned_header_size ? reinterpret_cast<header*>(reinterpret_cast<std::intptr_t>(p) - aligned_header_size) : nullptr;
+    // the upstream memory block holding an allocation
+    struct upstream_block
+    {
+      void* m_address;
+      std::size_t m_bytes;
+      std::size_t m_alignment;
+    };
+
+    /**
+     * \brief Returns the size of the upstream memory block holding an allocation
+     * \param bytes the size of the user segment
+     * \param alignment the alignment of the user segment
+     * \return the size of the upstream memory block
+     */
+    [[nodiscard]]
+    constexpr std::size_t upstream_size(std::size_t bytes, std::size_t alignment) noexcept
+    {
+      // the compact header reserves the room for aligning the user segment
+      return (is_compact_header(alignment) ? alignment : 0U) + sizeof(aligned_header_base) + bytes + padding_size;
+    }
+
+    /**
+     * \brief Places the user segment with the compact header inside the upstream memory block
+     * \param address the beginning of the naturally aligned upstream memory block
+     * \param alignment the alignment of the user segment
+     * \return the address of the user segment
+     */
+    [[nodiscard]]
+    inline void* place_compact(void* address, std::size_t alignment) noexcept
+    {
+      const auto first = reinterpret_cast<std::uintptr_t>(address);
+      const auto payload = (first + sizeof(std::size_t) + sizeof(aligned_header_base) + alignment - 1U) & ~(alignment - 1U);
+      const std::size_t offset = payload - first;
+      memcpy(reinterpret_cast<std::byte*>(payload - sizeof(aligned_header_base) - sizeof(offset)), &offset, sizeof(offset));
+      return reinterpret_cast<void*>(payload);
+    }
+
+    /**
+     * \brief Returns the upstream memory block holding the user segment 'p'
+     * \param p the address of the user segment
+     * \param bytes the size of the user segment
+     * \param alignment the alignment of the user segment
+     * \return the upstream memory block
+     */
+    [[nodiscard]]
+    inline upstream_block upstream_block_of(void* p, std::size_t bytes, std::size_t alignment) noexcept
+    {
+      auto* payload = static_cast<std::byte*>(p);
+      const std::size_t aligned_header_size = detail::aligned_header_size(alignment);
+      if (!is_compact_header(alignment))
+      {
+        return { payload - aligned_header_size, aligned_header_size + bytes + padding_size, alignment };
+      }
+
+      std::size_t offset = 0U;
+      memcpy(&offset, payload - aligned_header_size - sizeof(offset), sizeof(offset));
+      return { payload - offset, alignment + aligned_header_size + bytes + padding_size, max_natural_alignment };
     }
 
     // Stores a head 'block' and a tail 'block' for list
     // manipulation
-    struct test_resource_list // intrusive list of memory blocks
+    struct block_list // intrusive list of memory blocks
     {
       block* m_head = nullptr;  // address of first block in list (or 'nullptr')
       block* m_tail = nullptr;  // address of last block in list (or 'nullptr')
@@ -391,1746 +786,7502 @@ namespace stdx::pmr
       }
 
       /**
-       * \brief Adds newly allocated memory block with the specified 'index' into the 'list of blocks'
-       *        The specified 'resource' polymorphic memory resource is used to allocated memory block;
-       * \param index the index of new memory block
-       * \param resource the memory_resource used to allocate a memory block
-       * \return the address of the allocated memory 'block'
+       * \brief Appends the specified memory block 'mblock' to the 'list of blocks'
+       * \param mblock address of the memory block embedded in the header of an allocation
+       * \return the address of the added memory 'block'
        * \note the head pointer of the 'list' will be updated if the 'list of blocks' is initially empty
        */
-      block* add_block(long long index, std::pmr::memory_resource* resource)
+      block* add_block(block* mblock) noexcept
       {
-        auto* mblock = static_cast<block*>(resource->allocate(sizeof(block), alignof(block)));
+        mblock->m_next = nullptr;
 
-        if (mblock)
+        if (!m_head)
         {
-          mblock->m_next = nullptr;
-          mblock->m_index = index;
-
-          if (!m_head)
-          {
-            //empty list
-            m_head = mblock;
-            m_tail = mblock;
-            mblock->m_prev = nullptr;
-          }
-          else
-          {
-            m_tail->m_next = mblock;
-            mblock->m_prev = m_tail;
-            m_tail = mblock;
-          }
-
-          return mblock;
+          //empty list
+          m_head = mblock;
+          m_tail = mblock;
+          mblock->m_prev = nullptr;
+        }
+        else
+        {
+          m_tail->m_next = mblock;
+          mblock->m_prev = m_tail;
+          m_tail = mblock;
         }
 
         return mblock;
       }
 
       /**
-       * \brief Erases all memory blocks from the list with the given resource
-       * \param resource pointer on the resource to be erased
+       * \brief Forgets all memory blocks of the list
+       * \note The blocks are owned by the headers of the allocations,
+       *       so there is nothing to be deallocated.
        */
-      void clear(std::pmr::memory_resource* resource)
+      void clear() noexcept
       {
-        block* mblock = m_head;
-        while (mblock)
-        {
-          block* block_to_free = mblock;
-          mblock = mblock->m_next;
-          resource->deallocate(block_to_free, sizeof(block), alignof(block));
-        }
         m_head = nullptr;
         m_tail = nullptr;
       }
     };
 
-    class local_memory
-    {
-      struct malloc_free_resource final : std::pmr::memory_resource
-      {
-        malloc_free_resource() noexcept = default;
+    // assumed size of the data cache line; the statistics updated by
+    // different threads are kept on separate cache lines of this size
+    inline constexpr std::size_t cache_line_size = 64U;
 
-        [[nodiscard]]
-        std::pmr::memory_resource* upstream_resource() const noexcept
-        {
-          return nullptr;
-        }
+    // number of shards the cumulative statistics of test_resource are spread over
+    inline constexpr std::size_t stats_shard_count = 16U;
 
-      private:
-        [[nodiscard]]
-        void* do_allocate(std::size_t bytes, [[maybe_unused]] std::size_t alignment) override
-        {
-          // C++ standard: requested size shall be a multiple of alignment
-          const auto div = bytes / alignment;
-          const auto rem = bytes - div * alignment;
-          bytes = rem == 0U ? bytes : (div + 1U) * alignment;
+    /**
+     * \brief Returns the index of the statistics shard assigned to the calling thread
+     * \return the shard index in the range [0, stats_shard_count)
+     * \note The threads are assigned to the shards in round-robin order
+     *       at the time of their first call of the function.
+     */
+    inline std::size_t this_thread_shard() noexcept
+    {
+      static std::atomic_size_t next_shard{ 0U };
+      thread_local const std::size_t shard = next_shard.fetch_add(1U, std::memory_order_relaxed) % stats_shard_count;
+      return shard;
+    }
 
-#ifdef _MSC_VER
-          // Windows-specific API:
-          void* p = ::_aligned_malloc(bytes, alignment);
-#else
-          // standard C++17 API:
-          void* p = std::aligned_alloc(alignment, bytes);
-#endif
+    // the monotonic time of the lifetime and the latency profiles in nanoseconds
+    [[nodiscard]]
+    inline std::uint64_t clock_nanoseconds() noexcept
+    {
+      return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
 
-          if (!p)
-          {
-            throw std::bad_alloc();
-          }
-          return p;
-        }
+    // The time the current allocation or deallocation of this thread has spent
+    // waiting for the locks and in the upstream resource.
+    struct operation_latency
+    {
+      std::uint64_t m_lockWait;
+      std::uint64_t m_upstream;
+    };
 
-        void do_deallocate(void* p, [[maybe_unused]] std::size_t bytes, [[maybe_unused]] std::size_t alignment) override
-        {
-#ifdef _MSC_VER
-          // Windows-specific API:
-          ::_aligned_free(p);
-#else
-          // standard C++17 API:
-          std::free(p);
-#endif
-        }
+    [[nodiscard]]
+    inline operation_latency& this_thread_latency() noexcept
+    {
+      thread_local operation_latency latency{};
+      return latency;
+    }
 
-        [[nodiscard]]
-        bool do_is_equal(const std::pmr::memory_resource& that) const noexcept override
-        {
-          //return nullptr != dynamic_cast<const malloc_free_resource*>(&that);
-          //return typeid(malloc_free_resource&) == typeid(that);
-          //there is only one instance of malloc_free_resource in the process
-          return this == &that;
-        }
-      };
-
-    public:
-      ~local_memory() = delete;
-
-      static std::pmr::memory_resource* resource() noexcept
+    /**
+     * \brief Raises the value of 'target' to 'value' if 'value' is greater
+     * \param target the atomic high-water mark
+     * \param value the candidate value
+     */
+    inline void atomic_store_max(std::atomic_llong& target, long long value) noexcept
+    {
+      long long current = target.load(std::memory_order_relaxed);
+      while (current < value &&
+        !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
       {
-        // immortalize the instance of malloc_free_resource type
-        // the instance 'r' is never destructed;
-        // the memory space where r is placed is deallocated,
-        // when main function is finished
-        using type = malloc_free_resource;
-        alignas(type) static std::uint8_t buffer[sizeof(type)];
-        static type* r = new (buffer) type;
-        return r;
       }
-    };
+    }
 
-    template<typename CharT>
-    class report_formater
+    // The counters updated by the threads assigned to one shard; the values
+    // of the resource are the sums of its shards. The counters updated by
+    // every allocation or deallocation fill the first cache line, the rare
+    // ones the second. The explicit padding keeps every shard on its own
+    // cache lines (and suppresses MSVC warning C4324).
+    struct alignas(cache_line_size) stats_shard
     {
-    public:
-      using char_type = CharT;
-      using traits_type = std::char_traits<char_type>;
-      using string_type = std::basic_string<char_type, traits_type>;
+      // the sequence lock of the updates of the shard, see begin_update()
+      std::atomic_llong m_updatesBegun{ 0LL };
+      std::atomic_llong m_updatesEnded{ 0LL };
+      std::atomic_llong m_blocksInUse{ 0LL };
+      std::atomic_llong m_bytesInUse{ 0LL };
+      // the parts of the in-use counters added to the shared usage_counters
+      std::atomic_llong m_blocksFlushed{ 0LL };
+      std::atomic_llong m_bytesFlushed{ 0LL };
+      std::atomic_llong m_totalBlocks{ 0LL };
+      std::atomic_llong m_totalBytes{ 0LL };
+
+      std::atomic_llong m_deallocations{ 0LL };
+      std::atomic_llong m_boundsErrors{ 0LL };
+      std::atomic_llong m_badDeallocateParams{ 0LL };
+      std::atomic_llong m_mismatches{ 0LL };
+      std::atomic_llong m_writesAfterFree{ 0LL };
+      std::byte _1[2U * cache_line_size - 13U * sizeof(std::atomic_llong)];
+    };
+    static_assert(sizeof(stats_shard) == 2U * cache_line_size);
 
-      /**
-       * \brief Format in hex to 'output' string, a block of memory starting at the specified
-       *        starting 'address' of the specified 'length' (in bytes). Each line of
-       *        formatted output will have a maximum of 16 bytes per line, where each
-       *        line starts with the address of that 16-byte chunk.
-       * \param address start address of memory block
-       * \param length the length of memory block in bytes
-       * \return string representation of specified memory block
-       */
-      static string_type mem2str(void* address, std::size_t length)
+    // The values of the counters of one shard read at once
+    struct stats_shard_values
+    {
+      long long m_blocksInUse = 0LL;
+      long long m_bytesInUse = 0LL;
+      long long m_totalBlocks = 0LL;
+      long long m_totalBytes = 0LL;
+      long long m_deallocations = 0LL;
+      long long m_boundsErrors = 0LL;
+      long long m_badDeallocateParams = 0LL;
+      long long m_mismatches = 0LL;
+      long long m_writesAfterFree = 0LL;
+
+      stats_shard_values& operator+=(const stats_shard_values& other) noexcept
       {
-        static constexpr std::size_t line_size = 128U;
-        static constexpr std::size_t buff_size = line_size - 1U;
-
-        char_type line[line_size] = { '\0' };
-        int line_index = 0;
-
-        auto* addr = static_cast<std::byte*>(address);
-        std::byte* endAddr = addr + length;
-
-        string_type output;
-        output.reserve(((length / 16U) + 1U) * line_size);
+        m_blocksInUse += other.m_blocksInUse;
+        m_bytesInUse += other.m_bytesInUse;
+        m_totalBlocks += other.m_totalBlocks;
+        m_totalBytes += other.m_totalBytes;
+        m_deallocations += other.m_deallocations;
+        m_boundsErrors += other.m_boundsErrors;
+        m_badDeallocateParams += other.m_badDeallocateParams;
+        m_mismatches += other.m_mismatches;
+        m_writesAfterFree += other.m_writesAfterFree;
+        return *this;
+      }
+    };
 
-        for (int i = 0; addr < endAddr; ++i)
-        {
-          if (0 == i % 4)
-          {
-            if (line_index != 0)
-            {
-              output.append(line);
-            }
-            line_index = 0;
-            line[line_index] = { '\0' };
-            if (i != 0)
-            {
-              line_index += snprintf(&line[line_index], buff_size - line_index, "\n");
-            }
-            line_index += snprintf(&line[line_index], buff_size - line_index, "%p:      ", static_cast<void*>(addr));
-          }
-          else
-          {
-            line_index += snprintf(&line[line_index], buff_size - line_index, "  ");
-          }
+    // to suppress MSVC warning C4324:
+    // structure was padded due to alignment specifier
+    template<typename T, typename = void>
+    struct alignas(cache_line_size) cache_line_padded
+    {
+      T m_object;
+    };
 
-          for (int j = 0; j < 4 && addr < endAddr; ++j)
-          {
-            line_index += snprintf(&line[line_index], buff_size - line_index, "%02x ", static_cast<int>(*addr));
-            ++addr;
-          }
-        }
+    template<typename T>
+    struct alignas(cache_line_size) cache_line_padded<T, std::enable_if_t<(sizeof(T) % cache_line_size != 0U)>>
+    {
+      T m_object;
+      std::byte _1[cache_line_size - sizeof(T) % cache_line_size];
+    };
 
-        output.append(line);
-        output.append("\n");
-        return output;
-      }
+    // number of the sub-buckets of every power of two of the size histogram
+    inline constexpr std::size_t size_histogram_sub_bucket_bits = 2U;
+    inline constexpr std::size_t size_histogram_sub_buckets = std::size_t{ 1U } << size_histogram_sub_bucket_bits;
+    // log2 of the smallest size counted in the last bucket of the size histogram
+    inline constexpr std::size_t size_histogram_max_log2 = 47U;
+    inline constexpr std::size_t size_histogram_bucket_count =
+      (size_histogram_max_log2 - size_histogram_sub_bucket_bits + 2U) * size_histogram_sub_buckets;
+    inline constexpr std::size_t alignment_histogram_bucket_count = max_alignment_log2 + 1U;
 
-      static string_type addr2str(void* address)
+    /**
+     * \brief Returns the bucket of the log-linear histogram counting 'value'
+     * \param value the counted value
+     * \param sub_bucket_bits log2 of the number of the equal buckets every power of two is split into
+     * \param max_log2 log2 of the smallest value counted in the last power of two of the histogram
+     * \return the index of the bucket
+     * \note The values below 2^sub_bucket_bits have their own buckets, the values
+     *       above the last power of two are counted in the last bucket.
+     */
+    [[nodiscard]]
+    constexpr std::size_t log_linear_bucket(std::uint64_t value, std::size_t sub_bucket_bits, std::size_t max_log2) noexcept
+    {
+      const std::uint64_t sub_buckets = std::uint64_t{ 1U } << sub_bucket_bits;
+      if (value < sub_buckets)
       {
-        static constexpr std::size_t hexdigit_count = sizeof(std::intptr_t) * 2U;
-        char_type line[hexdigit_count + 1U] = { '\0' };
-
-        snprintf(&line[0U], hexdigit_count, "%p", address);
-
-        return line;
+        return static_cast<std::size_t>(value);
       }
 
-      static string_type msg2str(const char* format, va_list args)
+      const std::size_t log2 = bit_width(value) - 1U;
+      if (log2 > max_log2)
       {
-        static constexpr std::size_t buffer_size = 4095U;
-        char_type buffer[buffer_size + 1U] = { '\0' };
-        return 0 <= vsnprintf(buffer, buffer_size, format, args) ? string_type(buffer) : string_type();
+        return static_cast<std::size_t>((max_log2 - sub_bucket_bits + 2U) * sub_buckets - 1U);
       }
-    };
-
-    class stream_test_resource_reporter
-      : public test_resource_reporter
-    {
-    public:
-      explicit stream_test_resource_reporter(std::ostream& os) noexcept
-        : m_stream(os)
-      {}
 
-    protected:
-      void do_report_allocation(const test_resource& tr) override;
-      void do_report_deallocation(const test_resource& tr) override;
-      void do_report_release(const test_resource& tr) override;
-      void do_report_invalid_memory_block(
-        const test_resource& tr,
-        std::size_t deallocatedBytes,
-        std::size_t deallocatedAlignment,
-        int underrunBy,
-        int overrunBy) override;
-      void do_report_print(const test_resource& tr) override;
-      void do_report_log_msg(const char* format, va_list args) override;
+      const std::size_t shift = log2 - sub_bucket_bits;
+      return static_cast<std::size_t>((shift + 1U) * sub_buckets + ((value >> shift) & (sub_buckets - 1U)));
+    }
 
-    private:
-      using char_type = std::ostream::char_type;
-      using formater_type = report_formater<char_type>;
-      using string_type = formater_type::string_type;
+    /**
+     * \brief Returns the smallest value counted in the bucket 'index' of the log-linear histogram
+     * \param index the index of the bucket
+     * \param sub_bucket_bits log2 of the number of the equal buckets every power of two is split into
+     * \return the smallest value of the bucket
+     */
+    [[nodiscard]]
+    constexpr std::uint64_t log_linear_bucket_min(std::size_t index, std::size_t sub_bucket_bits) noexcept
+    {
+      const std::size_t sub_buckets = std::size_t{ 1U } << sub_bucket_bits;
+      if (index < sub_buckets)
+      {
+        return index;
+      }
 
-      std::ostream& m_stream;
-    };
+      const std::size_t shift = index / sub_buckets - 1U;
+      return std::uint64_t{ sub_buckets + index % sub_buckets } << shift;
+    }
 
-    template<typename StreamReporter>
+    /**
+     * \brief Returns the bucket of the size histogram counting the requests of 'bytes'
+     * \param bytes the requested number of bytes
+     * \return the index of the bucket
+     * \note The sizes below size_histogram_sub_buckets have their own buckets, every
+     *       larger power of two is split into size_histogram_sub_buckets equal buckets.
+     */
     [[nodiscard]]
-    test_resource_reporter* _console_test_resource_reporter() noexcept
+    constexpr std::size_t size_histogram_bucket(std::size_t bytes) noexcept
     {
-      alignas(StreamReporter) static std::uint8_t buffer[sizeof(StreamReporter)];
-      static auto* reporter = new (buffer) StreamReporter(std::cout);
-      return reporter;
+      return log_linear_bucket(bytes, size_histogram_sub_bucket_bits, size_histogram_max_log2);
     }
 
+    /**
+     * \brief Returns the smallest size counted in the bucket 'index' of the size histogram
+     * \param index the index of the bucket
+     * \return the smallest number of bytes of the bucket
+     */
     [[nodiscard]]
-    inline std::atomic<test_resource_reporter*>& _default_test_resource_reporter() noexcept
+    constexpr std::size_t size_histogram_bucket_min(std::size_t index) noexcept
     {
-      using type = std::atomic<test_resource_reporter*>;
-      alignas(type) static std::uint8_t buffer[sizeof(type)];
-      static type* reporter = new (buffer) type(_console_test_resource_reporter<stream_test_resource_reporter>());
-      return *reporter;
+      return static_cast<std::size_t>(log_linear_bucket_min(index, size_histogram_sub_bucket_bits));
     }
 
-    template<
-      typename StreamReporter,
-      typename = std::enable_if_t<
-        std::is_base_of_v<test_resource_reporter, std::decay_t<StreamReporter>>>
-    >
-    class file_reporter : public StreamReporter
+    static_assert(size_histogram_bucket(size_histogram_bucket_min(size_histogram_bucket_count - 1U)) ==
+      size_histogram_bucket_count - 1U);
+
+    // The histograms of the requests counted by the threads assigned to one shard.
+    struct histogram_shard
     {
-    public:
-      file_reporter() noexcept
-        : stream_test_resource_reporter(m_fstream)
-      {
-      }
+      std::atomic_llong m_sizes[size_histogram_bucket_count]{};
+      std::atomic_llong m_alignments[alignment_histogram_bucket_count]{};
+    };
 
-      explicit file_reporter(
-        const std::filesystem::path& filename,
-        std::ios_base::openmode mode = std::ios_base::out)
-        : stream_test_resource_reporter(m_fstream)
-        , m_fstream(filename, mode)
-      {
-      }
+    // The in-use counters of a shard are added to the shared ones once they
+    // have changed by this many blocks or bytes since the last addition.
+    inline constexpr long long usage_flush_blocks = 16LL;
+    inline constexpr long long usage_flush_bytes = 16384LL;
+
+    // The counters which can't be split into shards. The allocation index
+    // has to be unique, so it is incremented by every allocation and has
+    // its own cache line. The high-water marks are compared against the
+    // sum of the in-use counters flushed by the shards, which changes once
+    // per usage_flush_blocks or usage_flush_bytes of a shard only.
+    struct alignas(cache_line_size) usage_counters
+    {
+      std::atomic_llong m_allocations{ 0LL };
+      std::byte _1[cache_line_size - sizeof(std::atomic_llong)];
+      std::atomic_llong m_blocksFlushed{ 0LL };
+      std::atomic_llong m_bytesFlushed{ 0LL };
+      std::atomic_llong m_maxBlocks{ 0LL };
+      std::atomic_llong m_maxBytes{ 0LL };
+      std::byte _2[cache_line_size - 4U * sizeof(std::atomic_llong)];
+    };
+    static_assert(sizeof(usage_counters) == 2U * cache_line_size);
 
-      void open(const std::filesystem::path& filename,
-        std::ios_base::openmode mode = std::ios_base::out)
+    /**
+     * \brief Reads the counters of the shard once, if no update of it is in progress
+     * \param shard the counters of the shard
+     * \param values the values read
+     * \return true if no update has overlapped the read
+     */
+    inline bool try_read_shard(const stats_shard& shard, stats_shard_values& values) noexcept
+    {
+      const long long ended = shard.m_updatesEnded.load(std::memory_order_acquire);
+      const long long begun = shard.m_updatesBegun.load(std::memory_order_relaxed);
+      if (begun != ended)
       {
-        m_fstream.open(filename, mode);
+        return false;
       }
 
-      void close()
-      {
-        m_fstream.close();
-      }
+      values.m_blocksInUse = shard.m_blocksInUse.load(std::memory_order_relaxed);
+      values.m_bytesInUse = shard.m_bytesInUse.load(std::memory_order_relaxed);
+      values.m_totalBlocks = shard.m_totalBlocks.load(std::memory_order_relaxed);
+      values.m_totalBytes = shard.m_totalBytes.load(std::memory_order_relaxed);
+      values.m_deallocations = shard.m_deallocations.load(std::memory_order_relaxed);
+      values.m_boundsErrors = shard.m_boundsErrors.load(std::memory_order_relaxed);
+      values.m_badDeallocateParams = shard.m_badDeallocateParams.load(std::memory_order_relaxed);
+      values.m_mismatches = shard.m_mismatches.load(std::memory_order_relaxed);
+      values.m_writesAfterFree = shard.m_writesAfterFree.load(std::memory_order_relaxed);
+
+      // any update overlapping the read has incremented the 'begun' counter
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return begun == shard.m_updatesBegun.load(std::memory_order_relaxed);
+    }
+
+    // The layout of the statistics page, version 2 (all the integers in the native byte order):
+    // the 64 bytes header followed by 'm_capacity' records of 2240 bytes.
+    inline constexpr char stats_page_magic[8] = { 'S', 'T', 'D', 'X', 'P', 'M', 'R', '\0' };
+    inline constexpr std::uint32_t stats_page_version = 2U;
+    inline constexpr std::size_t stats_page_name_size = 48U;
+
+    // the states of the record of the statistics page
+    inline constexpr std::uint32_t stats_record_free = 0U;
+    inline constexpr std::uint32_t stats_record_claimed = 1U;
+    inline constexpr std::uint32_t stats_record_live = 2U;
+
+    struct stats_page_header
+    {
+      char          m_magic[8];
+      std::uint32_t m_version;
+      std::uint32_t m_headerSize;
+      std::uint32_t m_recordSize;
+      std::uint32_t m_capacity;
+      std::int64_t  m_pid;
+      char          m_reserved[32];
+    };
+    static_assert(sizeof(stats_page_header) == 64U);
+
+    // The record of one test_resource; its usage counters and its statistics
+    // shards are updated in place by the resource, so publishing them costs
+    // nothing on the allocation path. The generation changes whenever
+    // the record is claimed by another resource.
+    struct stats_page_record
+    {
+      std::atomic<std::uint32_t> m_state;
+      std::uint32_t              m_reserved;
+      std::atomic<std::uint64_t> m_generation;
+      char                       m_name[stats_page_name_size];
+      usage_counters             m_usage;
+      stats_shard                m_shards[stats_shard_count];
+    };
+    static_assert(sizeof(stats_page_record) == 2240U);
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free && std::atomic_llong::is_always_lock_free,
+      "the records of the statistics page are shared between the processes");
 
+    /**
+     * \brief The statistics page of the process the new test_resource instances are published in
+     * \note A page stays mapped until the process exits even after it is closed,
+     *       since the resources published in it may still be updating their records.
+     */
+    class stats_page
+    {
+    public:
       [[nodiscard]]
-      bool good() const
+      static bool open([[maybe_unused]] const std::filesystem::path& path, [[maybe_unused]] std::size_t capacity)
       {
-        return m_fstream.good();
-      }
+#if defined(__linux__)
+        std::lock_guard<std::mutex> guard{ lock() };
+        if (nullptr != current().load(std::memory_order_relaxed) || 0U == capacity ||
+            capacity > (std::numeric_limits<std::uint32_t>::max)())
+        {
+          return false;
+        }
 
-    protected:
-      void do_report_allocation(const test_resource& tr) override
-      {
-        if (validate())
+        const std::size_t length = sizeof(stats_page_header) + capacity * sizeof(stats_page_record);
+        const int file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (file < 0)
         {
-          stream_test_resource_reporter::do_report_allocation(tr);
+          return false;
+        }
+        void* map = MAP_FAILED;
+        if (0 == ::ftruncate(file, static_cast<off_t>(length)))
+        {
+          map = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        }
+        ::close(file);
+        if (MAP_FAILED == map)
+        {
+          ::unlink(path.c_str());
+          return false;
         }
+
+        // the file is zero filled: all the records are free
+        auto* header = static_cast<stats_page_header*>(map);
+        header->m_version = stats_page_version;
+        header->m_headerSize = sizeof(stats_page_header);
+        header->m_recordSize = sizeof(stats_page_record);
+        header->m_capacity = static_cast<std::uint32_t>(capacity);
+        header->m_pid = static_cast<std::int64_t>(::getpid());
+        // the magic number is the last, a reader checks it first
+        std::memcpy(header->m_magic, stats_page_magic, sizeof(stats_page_magic));
+        path_name() = path;
+        current().store(header, std::memory_order_release);
+        return true;
+#else
+        return false;
+#endif
       }
 
-      void do_report_deallocation(const test_resource& tr) override
+      static void close() noexcept
       {
-        if (validate())
+#if defined(__linux__)
+        std::lock_guard<std::mutex> guard{ lock() };
+        if (nullptr != current().exchange(nullptr, std::memory_order_acq_rel))
         {
-          stream_test_resource_reporter::do_report_deallocation(tr);
+          ::unlink(path_name().c_str());
         }
+#endif
       }
 
-      void do_report_release(const test_resource& tr) override
+      [[nodiscard]]
+      static bool is_open() noexcept
       {
-        if (validate())
-        {
-          stream_test_resource_reporter::do_report_release(tr);
-        }
+        return nullptr != current().load(std::memory_order_acquire);
       }
 
-      void do_report_invalid_memory_block(
-        const test_resource& tr,
-        std::size_t deallocatedBytes,
-        std::size_t deallocatedAlignment,
-        int underrunBy,
-        int overrunBy) override
+      /**
+       * \brief Claims a free record of the open page for the resource 'name'
+       * \return the record with the zeroed counters or nullptr if no page is open or it is full
+       */
+      [[nodiscard]]
+      static stats_page_record* publish(std::string_view name) noexcept
       {
-        if (validate())
+        auto* header = current().load(std::memory_order_acquire);
+        if (nullptr == header)
         {
-          stream_test_resource_reporter::do_report_invalid_memory_block(
-            tr,
-            deallocatedBytes,
-            deallocatedAlignment,
-            underrunBy,
-            overrunBy
-          );
+          return nullptr;
         }
-      }
 
-      void do_report_print(const test_resource& tr) override
-      {
-        if (validate())
+        auto* records = reinterpret_cast<stats_page_record*>(header + 1);
+        for (std::uint32_t i = 0U; i < header->m_capacity; ++i)
         {
-          stream_test_resource_reporter::do_report_print(tr);
+          auto& record = records[i];
+          std::uint32_t state = stats_record_free;
+          if (record.m_state.compare_exchange_strong(state, stats_record_claimed, std::memory_order_acquire))
+          {
+            record.m_generation.fetch_add(1U, std::memory_order_relaxed);
+            new (&record.m_usage) usage_counters{};
+            for (auto& shard : record.m_shards)
+            {
+              new (&shard) stats_shard{};
+            }
+            const std::size_t length = (std::min)(name.size(), stats_page_name_size - 1U);
+            std::memcpy(record.m_name, name.data(), length);
+            std::memset(record.m_name + length, 0, stats_page_name_size - length);
+            record.m_state.store(stats_record_live, std::memory_order_release);
+            return &record;
+          }
         }
+        return nullptr;
       }
 
-      void do_report_log_msg(const char* format, va_list args) override
+      static void withdraw(stats_page_record* record) noexcept
       {
-        if (validate())
+        if (nullptr != record)
         {
-          stream_test_resource_reporter::do_report_log_msg(format, args);
+          record->m_state.store(stats_record_free, std::memory_order_release);
         }
       }
 
     private:
-      [[nodiscard]]
-      bool validate() const
+      static std::atomic<stats_page_header*>& current() noexcept
       {
-        return m_fstream.is_open();
+        static std::atomic<stats_page_header*> page{ nullptr };
+        return page;
       }
 
-      std::ofstream m_fstream;
+      static std::mutex& lock() noexcept
+      {
+        static std::mutex mutex;
+        return mutex;
+      }
+
+      static std::filesystem::path& path_name() noexcept
+      {
+        static std::filesystem::path path;
+        return path;
+      }
     };
-  }
 
-  using file_test_resource_reporter = detail::file_reporter<detail::stream_test_resource_reporter>;
+    // number of the attempts of a consistent read of a shard
+    // before the reader yields between the attempts
+    inline constexpr int optimistic_read_attempts = 64;
 
-  template<typename StreamReporter = detail::stream_test_resource_reporter,
-    typename = std::enable_if_t<
-      std::is_base_of_v<test_resource_reporter, std::decay_t<StreamReporter>>>
-  >
-  [[nodiscard]]
-  decltype(auto)
-  console_test_resource_reporter() noexcept
-  {
-    return detail::_console_test_resource_reporter<StreamReporter>();
-  }
+    /**
+     * \brief Reads the counters of the shard while no update of it is in progress
+     * \param shard the counters of the shard
+     * \param max_attempts the number of the attempts after which the counters
+     *        are read even if an update overlaps the read
+     * \return the values of the counters of the shard
+     * \note The reader only retries, it never holds off the updates.
+     */
+    inline stats_shard_values read_shard(const stats_shard& shard, int max_attempts) noexcept
+    {
+      stats_shard_values values{};
+      for (int attempt = 1; !try_read_shard(shard, values) && attempt < max_attempts; ++attempt)
+      {
+        if (attempt >= optimistic_read_attempts)
+        {
+          std::this_thread::yield();
+        }
+      }
+      return values;
+    }
 
-  [[nodiscard]]
-  inline test_resource_reporter*
-  null_test_resource_reporter() noexcept
-  {
-    class type final : public test_resource_reporter
+    /**
+     * \brief Statistics of test_resource; the counters are updated in the shard
+     *        of the calling thread and summed on read only.
+     * \note The usage counters and the shards are kept in the record of the statistics
+     *       page if the page was open when the resource was constructed.
+     */
+    struct test_resource_counters
     {
-    public:
-      type() noexcept = default;
+      explicit test_resource_counters(std::string_view name) noexcept
+        : m_record(stats_page::publish(name))
+        , m_usage(nullptr != m_record ? m_record->m_usage : m_localUsage)
+        , m_shards(nullptr != m_record ? m_record->m_shards : m_localShards)
+      {}
 
-    private:
-      void do_report_allocation(const test_resource&) override
+      ~test_resource_counters()
       {
+        stats_page::withdraw(m_record);
       }
 
-      void do_report_deallocation(const test_resource&) override
+      test_resource_counters(const test_resource_counters&) = delete;
+      test_resource_counters& operator=(const test_resource_counters&) = delete;
+
+      stats_page_record* m_record;
+      usage_counters&    m_usage;
+      stats_shard*       m_shards;
+      usage_counters     m_localUsage{};
+      stats_shard        m_localShards[stats_shard_count]{};
+      cache_line_padded<histogram_shard> m_histograms[stats_shard_count]{};
+
+      [[nodiscard]]
+      stats_shard& local_shard() noexcept
       {
+        return m_shards[this_thread_shard()];
       }
 
-      void do_report_release(const test_resource&) override
+      [[nodiscard]]
+      histogram_shard& local_histograms() noexcept
       {
+        return m_histograms[this_thread_shard()].m_object;
       }
 
-      void do_report_invalid_memory_block(
-        const test_resource&,
-        std::size_t,
-        std::size_t,
-        int,
-        int) override
+      [[nodiscard]]
+      long long sum(std::atomic_llong stats_shard::* counter) const noexcept
       {
+        long long result = 0LL;
+        for (std::size_t i = 0U; i < stats_shard_count; ++i)
+        {
+          result += (m_shards[i].*counter).load(std::memory_order_relaxed);
+        }
+        return result;
       }
 
-      void do_report_print(const test_resource&) override
+      /**
+       * \brief Opens the update of the counters of one (bulk) allocation or deallocation
+       *        in 'shard' (the sequence lock generalized for the concurrent writers)
+       * \note The updates of the threads sharing the shard may overlap.
+       */
+      static void begin_update(stats_shard& shard) noexcept
       {
+        shard.m_updatesBegun.fetch_add(1LL, std::memory_order_relaxed);
+        // the increment is visible to a reader seeing any store of this update
+        std::atomic_thread_fence(std::memory_order_release);
       }
 
-      void do_report_log_msg(const char*, va_list) override
+      /**
+       * \brief Closes the update opened by begin_update()
+       */
+      static void end_update(stats_shard& shard) noexcept
       {
+        shard.m_updatesEnded.fetch_add(1LL, std::memory_order_release);
       }
-    };
 
-    // immortalize -> no destructor called on top of reporter
-    alignas(type) static std::uint8_t buffer[sizeof(type)];
-    static type* reporter = new (buffer) type;
-    return reporter;
-  }
+      /**
+       * \brief Adds 'blocks' and 'bytes' to the in-use counters of 'shard'
+       *        and raises the high-water marks
+       * \note The high-water marks are compared against the flushed in-use counters
+       *       of the other shards, so they are exact if only one shard changes
+       *       and may be off by less than (stats_shard_count - 1) * usage_flush_blocks
+       *       blocks (usage_flush_bytes bytes) otherwise. The shared counters are
+       *       written only when a flush is due or the high-water marks grow.
+       */
+      void add_in_use(stats_shard& shard, long long blocks, long long bytes) noexcept
+      {
+        const long long blocksInUse = shard.m_blocksInUse.fetch_add(blocks, std::memory_order_relaxed) + blocks;
+        const long long bytesInUse = shard.m_bytesInUse.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        long long blocksFlushed = shard.m_blocksFlushed.load(std::memory_order_relaxed);
+        long long bytesFlushed = shard.m_bytesFlushed.load(std::memory_order_relaxed);
+        if (std::abs(blocksInUse - blocksFlushed) >= usage_flush_blocks ||
+            std::abs(bytesInUse - bytesFlushed) >= usage_flush_bytes)
+        {
+          // a failed exchange means that another thread of the shard has flushed
+          if (shard.m_blocksFlushed.compare_exchange_strong(blocksFlushed, blocksInUse, std::memory_order_relaxed))
+          {
+            m_usage.m_blocksFlushed.fetch_add(blocksInUse - blocksFlushed, std::memory_order_relaxed);
+            blocksFlushed = blocksInUse;
+          }
+          if (shard.m_bytesFlushed.compare_exchange_strong(bytesFlushed, bytesInUse, std::memory_order_relaxed))
+          {
+            m_usage.m_bytesFlushed.fetch_add(bytesInUse - bytesFlushed, std::memory_order_relaxed);
+            bytesFlushed = bytesInUse;
+          }
+        }
 
-  [[nodiscard]]
-  inline test_resource_reporter*
-  get_default_test_resource_reporter() noexcept
-  {
-    return detail::_default_test_resource_reporter().load();
-  }
+        if (blocks > 0LL)
+        {
+          atomic_store_max(m_usage.m_maxBlocks,
+            m_usage.m_blocksFlushed.load(std::memory_order_relaxed) + blocksInUse - blocksFlushed);
+          atomic_store_max(m_usage.m_maxBytes,
+            m_usage.m_bytesFlushed.load(std::memory_order_relaxed) + bytesInUse - bytesFlushed);
+        }
+      }
 
-  inline test_resource_reporter*
-  set_default_test_resource_reporter(test_resource_reporter* reporter = nullptr) noexcept
-  {
-    if (!reporter)
-    {
-        reporter = console_test_resource_reporter();
-    }
-    return detail::_default_test_resource_reporter().exchange(reporter);
-  }
+      /**
+       * \brief Reads the counters of every shard consistently and sums them
+       * \return the sums of the counters of the shards
+       * \note Every shard is read while no update of it is in progress, so every completed
+       *       (bulk) allocation or deallocation is either counted whole or not at all.
+       *       The shards are read one after another, not at a single instant.
+       */
+      [[nodiscard]]
+      stats_shard_values read_consistent() const noexcept
+      {
+        stats_shard_values result{};
+        for (std::size_t i = 0U; i < stats_shard_count; ++i)
+        {
+          result += read_shard(m_shards[i], (std::numeric_limits<int>::max)());
+        }
+        return result;
+      }
+    };
 
-  /**
-   * \brief The test_resource_exception is thrown by the test_resource
-   *        when its allocation limit is reached and there is an attempt
-   *        to allocate further memory. It is basically a special form of
-   *        std::bad_alloc that allows the exception tester algorithm
-   *        to differentiate between real out‐of‐memory situations from
-   *        the test‐induced limits.
-   * \note  The exception inherits from std::bad_alloc so that when it is thrown,
-   *        the same code path will be traveled like in case of a real allocation
-   *        failure. In other words: to ensure that we test the code that would
-   *        run in production, in case std::bad_alloc is thrown by a memory resource.
-   */
-  class test_resource_exception : public std::bad_alloc
-  {
-  public:
-    test_resource_exception(test_resource* originating, std::size_t size, std::size_t alignment) noexcept
-      : m_originating(originating)
-      , m_size(size)
-      , m_alignment(alignment)
-    {
-    }
+    // number of stripes of the list of allocated blocks; a power of two
+    inline constexpr std::size_t list_stripe_count = 64U;
 
-    [[nodiscard]]
-    const char* what() const noexcept override
+    // the lock guard of the disabled locking policy
+    struct null_lock_guard
     {
-      return "stdx::pmr::test_resource_exception";
-    }
+      template<typename Mutex>
+      explicit null_lock_guard(Mutex&) noexcept
+      {
+      }
+    };
 
-    [[nodiscard]]
-    test_resource* originating_resource() const noexcept
+    // The lock guard adding the time spent waiting for the contended lock
+    // to this_thread_latency(); the free lock costs no clock reads.
+    class timed_lock_guard
     {
-      return m_originating;
-    }
+    public:
+      explicit timed_lock_guard(std::mutex& lock)
+        : m_lock(lock)
+      {
+        if (!m_lock.try_lock())
+        {
+          const std::uint64_t start = clock_nanoseconds();
+          m_lock.lock();
+          this_thread_latency().m_lockWait += clock_nanoseconds() - start;
+        }
+      }
 
-    [[nodiscard]]
-    std::size_t size() const noexcept
+      ~timed_lock_guard()
+      {
+        m_lock.unlock();
+      }
+
+      timed_lock_guard(const timed_lock_guard&) = delete;
+      timed_lock_guard& operator=(const timed_lock_guard&) = delete;
+
+    private:
+      std::mutex& m_lock;
+    };
+
+    template<bool Locking>
+    using lock_guard_t = std::conditional_t<Locking, timed_lock_guard, null_lock_guard>;
+
+    // one stripe of the list of allocated blocks guarded by its own lock
+    struct block_list_stripe
     {
-      return m_size;
-    }
+      std::mutex m_lock;
+      block_list m_list;
+    };
 
-    [[nodiscard]]
-    std::size_t alignment() const noexcept
+    /**
+     * \brief The list of allocated memory blocks shared by all threads.
+     *        The blocks are spread over independently locked stripes selected
+     *        by the hash of the block address, so the allocations and
+     *        deallocations of different threads very rarely contend.
+     */
+    struct test_resource_list
     {
-      return m_alignment;
-    }
+      /**
+       * \brief Appends the specified memory block 'mblock' to the list
+       * \tparam Locking false if the list is never accessed concurrently
+       * \param mblock address of the memory block embedded in the header of an allocation
+       */
+      template<bool Locking = true>
+      void add_block(block* mblock)
+      {
+        auto& stripe = stripe_of(mblock);
+        lock_guard_t<Locking> guard{ stripe.m_lock };
+        stripe.m_list.add_block(mblock);
+      }
 
-  private:
-    test_resource* m_originating;
-    std::size_t m_size;
-    std::size_t m_alignment;
-  };
+      /**
+       * \brief Removes the specified memory block 'mblock' from the list
+       * \tparam Locking false if the list is never accessed concurrently
+       * \param mblock address of the memory block embedded in the header of an allocation
+       * \note The behavior is undefined unless 'mblock' is in the list.
+       */
+      template<bool Locking = true>
+      void remove_block(block* mblock)
+      {
+        auto& stripe = stripe_of(mblock);
+        lock_guard_t<Locking> guard{ stripe.m_lock };
+        stripe.m_list.remove_block(mblock);
+      }
 
-  /**
-   * \brief The test_resource is a thread‐safe, instrumented memory resource that
-   *        implements the standard std::pmr::memory_resource abstract interface
-   *        and can be used to track various aspects of memory allocated from it,
-   *        in addition to automatically detecting a number of memory management
-   *        violations that might otherwise go unnoticed.
-   * \note Features:
-   *      - a thread‐safe implementation of the polymorphic memory resource interface
-   *      - the detection of memory leaks
-   *      - the detection of double releasing of memory
-   *      - detection of writing before or beyond the allocated memory area (boundary violation)
-   *      - overwriting memory just before deallocating it to help detect use of deleted memory
-   *      - tracking of memory use statistics (number of outstanding blocks and bytes)
-   *        that are currently in use, the cumulative number of blocks (and bytes) that have
-   *        been allocated, and the maximum number of blocks (and bytes) that have been in use
-   *        at any one time
-   *      - monitoring of memory use changes (via the test_resource_monitor type)
-   *      - temporary replacement of the default memory resource using the default_resource_guard
-   *      - testing (exception safety) behavior in case of memory allocation failure
-   *        (when the resource throws) using the test_allocation_failure algorithm
-   */
-  class test_resource final : public std::pmr::memory_resource
-  {
-    friend class test_resource_reporter;
+      /**
+       * \brief Appends 'count' memory blocks to the list taking the lock
+       *        of every affected stripe once per batch of blocks
+       * \tparam Locking false if the list is never accessed concurrently
+       * \param count the number of memory blocks
+       * \param block_of the function object returning the address of i-th memory block
+       */
+      template<bool Locking, typename BlockOf>
+      void add_blocks(std::size_t count, BlockOf block_of)
+      {
+        for_each_by_stripe<Locking>(count, block_of, [](block_list& list, block* mblock) {
+          list.add_block(mblock);
+        });
+      }
 
-  public:
-    //constructors/destructors
+      /**
+       * \brief Removes 'count' memory blocks from the list taking the lock
+       *        of every affected stripe once per batch of blocks
+       * \tparam Locking false if the list is never accessed concurrently
+       * \param count the number of memory blocks
+       * \param block_of the function object returning the address of i-th memory block
+       * \note The behavior is undefined unless all the blocks are in the list.
+       */
+      template<bool Locking, typename BlockOf>
+      void remove_blocks(std::size_t count, BlockOf block_of)
+      {
+        for_each_by_stripe<Locking>(count, block_of, [](block_list& list, block* mblock) {
+          list.remove_block(mblock);
+        });
+      }
 
-    test_resource()
-      : test_resource("", false, detail::local_memory::resource(), get_default_test_resource_reporter())
-    {}
+      [[nodiscard]]
+      bool empty() const
+      {
+        for (auto& stripe : m_stripes)
+        {
+          std::lock_guard<std::mutex> guard{ stripe.m_object.m_lock };
+          if (!stripe.m_object.m_list.empty())
+          {
+            return false;
+          }
+        }
+        return true;
+      }
 
-    explicit test_resource(std::pmr::memory_resource* upstream)
-      : test_resource("", false, upstream, get_default_test_resource_reporter())
-    {}
+      /**
+       * \brief Invokes 'f' for each memory block of the list
+       * \param f the function object taking the 'const block_info&' argument
+       * \note The stripes are walked in groups of walk_width stripes locked at once
+       *       (in the order of the stripes, like by the other threads), one block of
+       *       each stripe in turn; the independent loads of the blocks of several
+       *       stripes overlap, so long lists are walked several times faster.
+       *       The fields of the blocks of a group are copied under the locks and
+       *       'f' is invoked after they are released, so a slow 'f' (e.g. a reporter
+       *       writing to a stream) doesn't hold off the allocations.
+       *       The blocks are not visited in the order of their allocation.
+       */
+      template<typename F>
+      void for_each(F&& f) const
+      {
+        std::vector<block_info> blocks;
+        for (std::size_t first = 0U; first < list_stripe_count; first += walk_width)
+        {
+          {
+            std::unique_lock<std::mutex> guards[walk_width];
+            const block* cursors[walk_width];
+            for (std::size_t i = 0U; i < walk_width; ++i)
+            {
+              auto& stripe = m_stripes[first + i].m_object;
+              guards[i] = std::unique_lock<std::mutex>{ stripe.m_lock };
+              cursors[i] = stripe.m_list.m_head;
+            }
 
-    explicit test_resource(const char* name)
-      : test_resource(std::string_view(name))
-    {}
+            for (bool any = true; any;)
+            {
+              any = false;
+              for (auto*& mblock : cursors)
+              {
+                if (mblock)
+                {
+                  const auto* head = header_of(const_cast<block*>(mblock));
+                  blocks.push_back({ mblock->m_index, head->m_bytes, head->alignment(), head->m_stack_id,
+                    reinterpret_cast<const aligned_header_base*>(head) + 1 });
+                  mblock = mblock->m_next;
+                  any = true;
+                }
+              }
+            }
+          }
 
-    explicit test_resource(std::string_view name)
-      : test_resource(name, false, detail::local_memory::resource(), get_default_test_resource_reporter())
-    {}
+          for (const auto& info : blocks)
+          {
+            f(info);
+          }
+          blocks.clear();
+        }
+      }
 
-    explicit test_resource(bool verbose, test_resource_reporter* reporter = get_default_test_resource_reporter())
-      : test_resource("", verbose, detail::local_memory::resource(), reporter)
-    {}
+      /**
+       * \brief Forgets all memory blocks of the list
+       */
+      void clear()
+      {
+        for (auto& stripe : m_stripes)
+        {
+          std::lock_guard<std::mutex> guard{ stripe.m_object.m_lock };
+          stripe.m_object.m_list.clear();
+        }
+      }
 
-    test_resource(std::string_view name, std::pmr::memory_resource* upstream)
-      : test_resource(name, false, upstream, get_default_test_resource_reporter())
-    {}
+    private:
+      [[nodiscard]]
+      static std::size_t stripe_index(const block* mblock) noexcept
+      {
+        // Fibonacci hashing spreads the (aligned) addresses over the stripes
+        constexpr std::size_t address_bits = sizeof(std::uintptr_t) * 8U;
+        constexpr auto multiplier = static_cast<std::uintptr_t>(0x9E3779B97F4A7C15ULL);
+        const auto hash = reinterpret_cast<std::uintptr_t>(mblock) * multiplier;
+        return (hash >> (address_bits - stripe_bits)) & (list_stripe_count - 1U);
+      }
 
-    test_resource(const char* name, std::pmr::memory_resource* upstream)
-      : test_resource(std::string_view(name), upstream)
-    {}
+      [[nodiscard]]
+      block_list_stripe& stripe_of(const block* mblock) noexcept
+      {
+        return m_stripes[stripe_index(mblock)].m_object;
+      }
 
-    test_resource(bool verbose, std::pmr::memory_resource* upstream, test_resource_reporter* reporter = get_default_test_resource_reporter())
-      : test_resource("", verbose, upstream, reporter)
-    {}
+      // Sorts every batch of the blocks by their stripes (counting sort),
+      // so 'f' is invoked for all the blocks of one stripe under a single lock.
+      template<bool Locking, typename BlockOf, typename F>
+      void for_each_by_stripe(std::size_t count, BlockOf& block_of, F f)
+      {
+        constexpr std::size_t batch_size = 256U;
 
-    test_resource(std::string_view name, bool verbose, test_resource_reporter* reporter = get_default_test_resource_reporter())
-      : test_resource(name, verbose, detail::local_memory::resource(), reporter)
-    {}
+        block* sorted[batch_size];
+        std::uint8_t stripes[batch_size];
+        std::size_t first[list_stripe_count];
+        std::size_t last[list_stripe_count];
 
-    test_resource(const char* name, bool verbose, test_resource_reporter* reporter = get_default_test_resource_reporter())
-      : test_resource(std::string_view(name), verbose, reporter)
-    {}
+        for (std::size_t offset = 0U; offset < count; offset += batch_size)
+        {
+          const std::size_t size = (std::min)(batch_size, count - offset);
 
-    test_resource(std::string_view name, bool verbose, std::pmr::memory_resource* upstream, test_resource_reporter* reporter = get_default_test_resource_reporter())
-      : m_name(name)
-      , m_verboseFlag(verbose)
-      , m_reporter(reporter)
-      , m_upstream(upstream)
-    {
-      //allocate and initialize the empty list of memory blocks
-      m_list = new (m_upstream->allocate(sizeof(detail::test_resource_list))) detail::test_resource_list{};
-    }
+          std::size_t counts[list_stripe_count]{};
+          for (std::size_t i = 0U; i < size; ++i)
+          {
+            stripes[i] = static_cast<std::uint8_t>(stripe_index(block_of(offset + i)));
+            ++counts[stripes[i]];
+          }
 
-    test_resource(const char* name, bool verbose, std::pmr::memory_resource* upstream, test_resource_reporter* reporter = get_default_test_resource_reporter())
-      : test_resource(std::string_view(name), verbose, upstream, reporter)
-    {}
+          for (std::size_t s = 0U, start = 0U; s < list_stripe_count; ++s)
+          {
+            first[s] = start;
+            last[s] = start;
+            start += counts[s];
+          }
 
-    ~test_resource() noexcept override
-    {
-      release();
-    }
+          for (std::size_t i = 0U; i < size; ++i)
+          {
+            sorted[last[stripes[i]]++] = block_of(offset + i);
+          }
+
+          for (std::size_t s = 0U; s < list_stripe_count; ++s)
+          {
+            if (first[s] != last[s])
+            {
+              auto& stripe = m_stripes[s].m_object;
+              lock_guard_t<Locking> guard{ stripe.m_lock };
+              for (std::size_t i = first[s]; i < last[s]; ++i)
+              {
+                f(stripe.m_list, sorted[i]);
+              }
+            }
+          }
+        }
+      }
+
+      static constexpr std::size_t stripe_bits = 6U;
+      static_assert((std::size_t{ 1U } << stripe_bits) == list_stripe_count);
 
-    test_resource(const test_resource&) = delete;
-    test_resource& operator=(const test_resource&) = delete;
+      // number of the stripes walked at once by for_each()
+      static constexpr std::size_t walk_width = 16U;
+      static_assert(list_stripe_count % walk_width == 0U);
+
+      mutable cache_line_padded<block_list_stripe> m_stripes[list_stripe_count];
+    };
+
+    // capacity of the set of sampled blocks; a power of two
+    inline constexpr std::size_t sampled_block_capacity = 4096U;
+    // number of slots probed by the set of sampled blocks
+    inline constexpr std::size_t sampled_block_probes = 16U;
 
     /**
-     * \brief Sets the allocation limit to the supplied limit.
-     * \param limit supplied allocation limit
-     * \note Any negative value for limit means there is no allocation
-     *       limit imposed by this test memory resource.
+     * \brief Returns the next number of the pseudo-random sequence of the calling thread
      */
-    void set_allocation_limit(long long limit) noexcept
+    inline std::uint64_t sampling_random() noexcept
     {
-      m_allocationLimit.store(limit, std::memory_order_relaxed);
+      thread_local std::uint64_t state{ 0U };
+      if (0U == state)
+      {
+        state = (reinterpret_cast<std::uintptr_t>(&state) | 1U) * 0x9E3779B97F4A7C15ULL;
+      }
+
+      // xorshift64
+      state ^= state << 13U;
+      state ^= state >> 7U;
+      state ^= state << 17U;
+      return state;
     }
 
     /**
-     * \brief Sets the no‐abort behavior.
-     * \param is_no_abort new value of no‐abort flag
-     * \note If flag is true, do not abort the program upon detecting errors.
-     *       The default value of the setting is false.
+     * \brief The set of the addresses of the sampled memory blocks.
+     *        The address is kept in one of 'sampled_block_probes' slots following
+     *        its hash, so the lookup takes constant time and never touches
+     *        the memory of the block itself. The address of a deallocated block
+     *        stays in its slot as a tombstone until the slot is reused, so the second
+     *        deallocation of a sampled block is checked, not passed to the upstream.
      */
-    void set_no_abort(bool is_no_abort) noexcept
+    struct sampled_blocks
     {
-      m_noAbortFlag.store(is_no_abort, std::memory_order_relaxed);
+      /**
+       * \brief Inserts the address 'p' into the set
+       * \param p the address of the sampled memory block
+       * \return false if there is no free slot for 'p'
+       */
+      bool insert(void* p) noexcept
+      {
+        const std::size_t first = slot_of(p);
+        // the tombstone of 'p' is revived, so the address is kept once
+        for (std::size_t i = 0U; i < sampled_block_probes; ++i)
+        {
+          void* expected = tombstone(p);
+          if (m_slots[(first + i) & (sampled_block_capacity - 1U)].compare_exchange_strong(
+            expected, p, std::memory_order_relaxed))
+          {
+            return true;
+          }
+        }
+        for (std::size_t i = 0U; i < sampled_block_probes; ++i)
+        {
+          auto& slot = m_slots[(first + i) & (sampled_block_capacity - 1U)];
+          void* expected = slot.load(std::memory_order_relaxed);
+          if ((nullptr == expected || is_tombstone(expected)) &&
+              slot.compare_exchange_strong(expected, p, std::memory_order_relaxed))
+          {
+            return true;
+          }
+        }
+        return false;
+      }
+
+      /**
+       * \brief Replaces the address 'p' in the set by its tombstone
+       * \param p the address of the deallocated sampled memory block
+       */
+      void erase(const void* p) noexcept
+      {
+        const std::size_t first = slot_of(p);
+        for (std::size_t i = 0U; i < sampled_block_probes; ++i)
+        {
+          auto& slot = m_slots[(first + i) & (sampled_block_capacity - 1U)];
+          if (slot.load(std::memory_order_relaxed) == p)
+          {
+            slot.store(tombstone(p), std::memory_order_relaxed);
+            return;
+          }
+        }
+      }
+
+      /**
+       * \brief Removes the tombstone of the address 'p' reused by a block which is not sampled
+       * \param p the address of the memory block passed through to the upstream
+       */
+      void forget(const void* p) noexcept
+      {
+        const std::size_t first = slot_of(p);
+        for (std::size_t i = 0U; i < sampled_block_probes; ++i)
+        {
+          void* expected = tombstone(p);
+          m_slots[(first + i) & (sampled_block_capacity - 1U)].compare_exchange_strong(
+            expected, nullptr, std::memory_order_relaxed);
+        }
+      }
+
+      /**
+       * \brief Checks whether 'p' is the address of a sampled block, allocated or deallocated
+       */
+      [[nodiscard]]
+      bool contains(const void* p) const noexcept
+      {
+        const std::size_t first = slot_of(p);
+        for (std::size_t i = 0U; i < sampled_block_probes; ++i)
+        {
+          const void* slot = m_slots[(first + i) & (sampled_block_capacity - 1U)].load(std::memory_order_relaxed);
+          if (slot == p || slot == tombstone(p))
+          {
+            return true;
+          }
+        }
+        return false;
+      }
+
+      /**
+       * \brief Decides whether the current allocation of the calling thread is sampled
+       * \param rate the mean number of allocations per one sampled allocation (at least 2)
+       * \return true for one of 'rate' allocations on average
+       * \note The distance between two sampled allocations is random (uniform
+       *       on [1, 2 * rate - 1]), so the periodic allocation patterns are
+       *       sampled evenly. The countdown is kept per statistics shard, so the
+       *       threads and the other resources do not disturb it.
+       */
+      bool sample(std::size_t rate) noexcept
+      {
+        auto& countdown = m_countdowns[this_thread_shard()].m_object;
+        const std::size_t value = countdown.load(std::memory_order_relaxed);
+        if (value > 0U)
+        {
+          countdown.store(value - 1U, std::memory_order_relaxed);
+          return false;
+        }
+
+        countdown.store(static_cast<std::size_t>(sampling_random() % (2U * rate - 1U)), std::memory_order_relaxed);
+        return true;
+      }
+
+      /**
+       * \brief Starts the countdowns of the sampling with the rate 'rate'
+       */
+      void reset(std::size_t rate) noexcept
+      {
+        for (auto& countdown : m_countdowns)
+        {
+          countdown.m_object.store(static_cast<std::size_t>(sampling_random() % rate), std::memory_order_relaxed);
+        }
+      }
+
+    private:
+      // the payload addresses are aligned, so the lowest bit marks the tombstone
+      [[nodiscard]]
+      static void* tombstone(const void* p) noexcept
+      {
+        return reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(p) | 1U);
+      }
+
+      [[nodiscard]]
+      static bool is_tombstone(const void* p) noexcept
+      {
+        return 0U != (reinterpret_cast<std::uintptr_t>(p) & 1U);
+      }
+
+      [[nodiscard]]
+      static std::size_t slot_of(const void* p) noexcept
+      {
+        constexpr std::size_t address_bits = sizeof(std::uintptr_t) * 8U;
+        constexpr auto multiplier = static_cast<std::uintptr_t>(0x9E3779B97F4A7C15ULL);
+        const auto hash = reinterpret_cast<std::uintptr_t>(p) * multiplier;
+        return static_cast<std::size_t>(hash >> (address_bits - slot_bits));
+      }
+
+      static constexpr std::size_t slot_bits = 12U;
+      static_assert((std::size_t{ 1U } << slot_bits) == sampled_block_capacity);
+
+      std::atomic<void*> m_slots[sampled_block_capacity]{};
+      cache_line_padded<std::atomic_size_t> m_countdowns[stats_shard_count]{};
+    };
+
+    // maximum number of the frames of a captured allocation call stack
+    inline constexpr std::size_t max_callsite_depth = 16U;
+    // capacity of the table of the call stacks; a power of two
+    // not exceeding the range of header::m_stack_id
+    inline constexpr std::size_t callsite_capacity = 4096U;
+    static_assert(callsite_capacity < (std::size_t{ 1U } << 24U));
+    // number of slots probed by the table of the call stacks
+    inline constexpr std::size_t callsite_probes = 32U;
+
+    // the call stack interned in the callsite_table
+    struct callsite
+    {
+      std::atomic_uint64_t m_hash{ 0U };  // 0 - free slot, 1 - slot being published
+      std::size_t          m_depth = 0U;
+      void*                m_frames[max_callsite_depth]{};
+    };
+
+    /**
+     * \brief The process wide table of the allocation call stacks. Every distinct
+     *        stack is stored once and identified by the 1-based index of its slot,
+     *        so the headers hold the id instead of the frames.
+     * \note The lookup and the insertion are lock-free and probe a bounded number
+     *       of slots; if they are all taken by other stacks, the stack gets no id.
+     */
+    class callsite_table
+    {
+    public:
+      /**
+       * \brief Returns the id of the call stack, inserts the stack if it is not in the table yet
+       * \param frames the return addresses of the stack, the innermost first
+       * \param depth the number of the frames
+       * \return the id of the stack or 0 if the table has no room for it
+       */
+      std::uint32_t intern(void* const* frames, std::size_t depth) noexcept
+      {
+        const std::uint64_t hash = hash_of(frames, depth);
+        for (std::size_t i = 0U; i < callsite_probes; ++i)
+        {
+          const std::size_t slot = (static_cast<std::size_t>(hash) + i) & (callsite_capacity - 1U);
+          auto& entry = m_callsites[slot];
+
+          std::uint64_t current = entry.m_hash.load(std::memory_order_acquire);
+          if (free_slot == current &&
+              entry.m_hash.compare_exchange_strong(current, publishing_slot, std::memory_order_acquire))
+          {
+            entry.m_depth = depth;
+            std::copy(frames, frames + depth, entry.m_frames);
+            entry.m_hash.store(hash, std::memory_order_release);
+            return static_cast<std::uint32_t>(slot + 1U);
+          }
+
+          // the same stack may be being published by another thread
+          while (publishing_slot == current)
+          {
+            std::this_thread::yield();
+            current = entry.m_hash.load(std::memory_order_acquire);
+          }
+
+          if (hash == current && depth == entry.m_depth && std::equal(frames, frames + depth, entry.m_frames))
+          {
+            return static_cast<std::uint32_t>(slot + 1U);
+          }
+        }
+        return 0U;
+      }
+
+      /**
+       * \brief Returns the call stack of the specified 'id'
+       * \param id the id returned by intern()
+       * \return the call stack or nullptr if there is no stack of the 'id'
+       */
+      [[nodiscard]]
+      const callsite* find(std::uint32_t id) const noexcept
+      {
+        if (0U == id || id > callsite_capacity)
+        {
+          return nullptr;
+        }
+        const auto& entry = m_callsites[id - 1U];
+        return entry.m_hash.load(std::memory_order_acquire) > publishing_slot ? &entry : nullptr;
+      }
+
+    private:
+      [[nodiscard]]
+      static std::uint64_t hash_of(void* const* frames, std::size_t depth) noexcept
+      {
+        // FNV-1a over the frame addresses, the reserved values are skipped
+        std::uint64_t hash = 0xCBF29CE484222325ULL;
+        for (std::size_t i = 0U; i < depth; ++i)
+        {
+          hash = (hash ^ reinterpret_cast<std::uintptr_t>(frames[i])) * 0x100000001B3ULL;
+        }
+        return hash > publishing_slot ? hash : hash + 2U;
+      }
+
+      static constexpr std::uint64_t free_slot = 0U;
+      static constexpr std::uint64_t publishing_slot = 1U;
+
+      callsite m_callsites[callsite_capacity]{};
+    };
+
+    [[nodiscard]]
+    inline callsite_table& callsites() noexcept
+    {
+      // never destroyed, the stacks are reported by the resources destroyed at exit too
+      alignas(callsite_table) static std::uint8_t buffer[sizeof(callsite_table)];
+      static auto* table = new (buffer) callsite_table{};
+      return *table;
     }
 
     /**
-     * \brief Sets the quiet behavior.
-     * \param is_quiet new value of quiet flag
-     * \note  If flag is true, do not report detected errors and imply is_no_abort() ==
-     *        true.  The default value of the setting is false.
+     * \brief Captures the call stack of the caller and interns it in the callsites()
+     * \param depth the number of the frames to keep
+     * \param skip the number of the innermost frames of the caller to omit
+     * \return the id of the stack or 0 if no stack is captured
+     * \note The stack is captured by the unwinder of glibc; elsewhere nothing is captured.
      */
-    void set_quiet(bool is_quiet) noexcept
+#if defined(__GNUC__) || defined(__clang__)
+    [[gnu::noinline]]
+#endif
+    inline std::uint32_t capture_callsite([[maybe_unused]] std::size_t depth, [[maybe_unused]] std::size_t skip) noexcept
+    {
+#if defined(__GLIBC__)
+      // this function is the first frame
+      constexpr std::size_t own_frames = 1U;
+      void* frames[own_frames + 2U * max_callsite_depth];
+      const std::size_t count = static_cast<std::size_t>(
+        ::backtrace(frames, static_cast<int>((std::min)(own_frames + skip + depth, std::size(frames)))));
+      const std::size_t first = (std::min)(own_frames + skip, count);
+      return callsites().intern(frames + first, (std::min)(count - first, depth));
+#else
+      return 0U;
+#endif
+    }
+
+    // number of the log2 buckets of the lifetime histograms
+    inline constexpr std::size_t lifetime_bucket_count = 32U;
+    // number of the log2 size classes of the lifetime profile
+    inline constexpr std::size_t lifetime_size_class_count = 32U;
+    // capacity of the call sites of the lifetime profile; a power of two
+    inline constexpr std::size_t lifetime_site_capacity = 256U;
+    // number of the latest allocations whose timestamps are kept; a power of two
+    inline constexpr std::size_t lifetime_stamp_capacity = 16384U;
+    // lifetime (in the intervening allocations) of the arena candidates by default
+    inline constexpr std::size_t default_short_lifetime = 1024U;
+
+    /**
+     * \brief Returns the log2 bucket of 'value': the bucket 0 counts 0,
+     *        the bucket i > 0 the values from 2^(i-1) to 2^i - 1
+     * \param value the counted value
+     * \param count the number of the buckets; the last one counts all the larger values too
+     * \return the index of the bucket
+     */
+    [[nodiscard]]
+    constexpr std::size_t log2_bucket(std::uint64_t value, std::size_t count) noexcept
+    {
+      return (std::min)(bit_width(value), count - 1U);
+    }
+
+    // The lifetimes of the deallocated blocks of one size class or one call site.
+    struct lifetime_histogram
+    {
+      std::atomic_llong m_nanoseconds[lifetime_bucket_count]{};
+      std::atomic_llong m_allocations[lifetime_bucket_count]{};  // the intervening allocations
+      std::atomic_llong m_bytes[lifetime_bucket_count]{};        // the bytes of m_allocations
+
+      void add(std::uint64_t nanoseconds, std::uint64_t allocations, std::size_t bytes) noexcept
+      {
+        m_nanoseconds[log2_bucket(nanoseconds, lifetime_bucket_count)].fetch_add(1LL, std::memory_order_relaxed);
+        const std::size_t bucket = log2_bucket(allocations, lifetime_bucket_count);
+        m_allocations[bucket].fetch_add(1LL, std::memory_order_relaxed);
+        m_bytes[bucket].fetch_add(static_cast<long long>(bytes), std::memory_order_relaxed);
+      }
+    };
+
+    struct lifetime_site
+    {
+      std::atomic_uint32_t m_key{ 0U };  // the stack id + 1, 0 - free slot
+      lifetime_histogram   m_lifetimes{};
+    };
+
+    /**
+     * \brief The lifetimes of the deallocated blocks of one test_resource
+     *        per size class and per allocation call site
+     * \note The allocation times are not kept in the headers, which have no room left,
+     *       but in the ring indexed by the allocation index; the time is known exactly
+     *       for the blocks outliving less than lifetime_stamp_capacity allocations,
+     *       for the older blocks it is the lower bound given by the oldest kept time.
+     */
+    class lifetime_profile
+    {
+    public:
+      /**
+       * \brief Keeps the time of the allocation of the index 'index'
+       * \param index the allocation index of the block
+       * \param now the clock_nanoseconds() of the allocation
+       */
+      void stamp(long long index, std::uint64_t now) noexcept
+      {
+        m_stamps[static_cast<std::size_t>(index) & (lifetime_stamp_capacity - 1U)].store(now, std::memory_order_relaxed);
+      }
+
+      /**
+       * \brief Counts the lifetime of the deallocated block
+       * \param index the allocation index of the block
+       * \param allocations the number of all the allocations so far
+       * \param bytes the size of the block
+       * \param stack_id the id of the allocation call stack of the block
+       * \param now the clock_nanoseconds() of the deallocation
+       */
+      void record(long long index, long long allocations, std::size_t bytes, std::uint32_t stack_id, std::uint64_t now) noexcept
+      {
+        const std::uint64_t stamp = m_stamps[static_cast<std::size_t>(index) & (lifetime_stamp_capacity - 1U)].load(std::memory_order_relaxed);
+        const auto intervening = static_cast<std::uint64_t>(allocations - index - 1LL);
+
+        std::uint64_t since = stamp;
+        if (intervening >= lifetime_stamp_capacity)
+        {
+          // overwritten by a later allocation; the oldest kept time is the bound
+          since = m_stamps[static_cast<std::size_t>(allocations) & (lifetime_stamp_capacity - 1U)].load(std::memory_order_relaxed);
+        }
+
+        if (0U == since)
+        {
+          // allocated before the profiling started
+          return;
+        }
+
+        const std::uint64_t nanoseconds = now > since ? now - since : 0U;
+        m_sizeClasses[log2_bucket(bytes, lifetime_size_class_count)].add(nanoseconds, intervening, bytes);
+        if (auto* site = site_of(stack_id))
+        {
+          site->m_lifetimes.add(nanoseconds, intervening, bytes);
+        }
+      }
+
+      [[nodiscard]]
+      const lifetime_histogram& size_class(std::size_t index) const noexcept
+      {
+        return m_sizeClasses[index];
+      }
+
+      [[nodiscard]]
+      const lifetime_site& site(std::size_t index) const noexcept
+      {
+        return m_sites[index];
+      }
+
+    private:
+      // the site of the 'stack_id' or nullptr if the table is full
+      [[nodiscard]]
+      lifetime_site* site_of(std::uint32_t stack_id) noexcept
+      {
+        const std::uint32_t key = stack_id + 1U;
+        for (std::size_t i = 0U; i < lifetime_site_capacity; ++i)
+        {
+          auto& site = m_sites[(stack_id + i) & (lifetime_site_capacity - 1U)];
+          std::uint32_t current = site.m_key.load(std::memory_order_relaxed);
+          if (0U == current &&
+              site.m_key.compare_exchange_strong(current, key, std::memory_order_relaxed))
+          {
+            return &site;
+          }
+          if (key == current)
+          {
+            return &site;
+          }
+        }
+        return nullptr;
+      }
+
+      std::atomic_uint64_t m_stamps[lifetime_stamp_capacity]{};
+      lifetime_histogram   m_sizeClasses[lifetime_size_class_count]{};
+      lifetime_site        m_sites[lifetime_site_capacity]{};
+    };
+
+    // number of the sub-buckets of every power of two of the latency histograms
+    inline constexpr std::size_t latency_histogram_sub_bucket_bits = 3U;
+    // log2 of the nanoseconds of the last power of two of the latency histograms (~18 minutes)
+    inline constexpr std::size_t latency_histogram_max_log2 = 40U;
+    inline constexpr std::size_t latency_histogram_bucket_count =
+      (latency_histogram_max_log2 - latency_histogram_sub_bucket_bits + 2U) << latency_histogram_sub_bucket_bits;
+
+    // the operations measured by the latency histograms
+    inline constexpr std::size_t allocation_operation = 0U;
+    inline constexpr std::size_t deallocation_operation = 1U;
+    inline constexpr std::size_t latency_operation_count = 2U;
+
+    // the phases of an operation measured by the latency histograms
+    inline constexpr std::size_t lock_wait_phase = 0U;
+    inline constexpr std::size_t bookkeeping_phase = 1U;
+    inline constexpr std::size_t upstream_phase = 2U;
+    inline constexpr std::size_t total_phase = 3U;
+    inline constexpr std::size_t latency_phase_count = 4U;
+
+    // the percentiles of the latencies of one phase of one operation in nanoseconds
+    struct latency_percentiles
+    {
+      long long     m_count = 0LL;
+      std::uint64_t m_p50 = 0U;
+      std::uint64_t m_p99 = 0U;
+      std::uint64_t m_p999 = 0U;
+      std::uint64_t m_max = 0U;
+    };
+
+    // The latency histograms of the operations of the threads assigned to one shard.
+    struct latency_shard
+    {
+      std::atomic_llong m_buckets[latency_operation_count][latency_phase_count][latency_histogram_bucket_count]{};
+      std::atomic_llong m_max[latency_operation_count][latency_phase_count]{};
+    };
+
+    /**
+     * \brief The HDR-style histograms of the latencies of the allocations and the deallocations
+     *        of one test_resource split into the lock waits, the bookkeeping of the resource
+     *        and the time spent in the upstream resource
+     */
+    class latency_profile
+    {
+    public:
+      /**
+       * \brief Counts the latencies of one operation
+       * \param operation allocation_operation or deallocation_operation
+       * \param latency the time the operation has waited for the locks and spent in the upstream
+       * \param total the duration of the whole operation
+       */
+      void record(std::size_t operation, const operation_latency& latency, std::uint64_t total) noexcept
+      {
+        const std::uint64_t waited = (std::min)(latency.m_lockWait, total);
+        const std::uint64_t upstream = (std::min)(latency.m_upstream, total - waited);
+        const std::uint64_t values[latency_phase_count] = { waited, total - waited - upstream, upstream, total };
+
+        auto& shard = m_shards[this_thread_shard()].m_object;
+        for (std::size_t phase = 0U; phase < latency_phase_count; ++phase)
+        {
+          const std::size_t bucket = log_linear_bucket(values[phase], latency_histogram_sub_bucket_bits, latency_histogram_max_log2);
+          shard.m_buckets[operation][phase][bucket].fetch_add(1LL, std::memory_order_relaxed);
+          atomic_store_max(shard.m_max[operation][phase], static_cast<long long>(values[phase]));
+        }
+      }
+
+      /**
+       * \brief Returns the percentiles of the latencies of the 'phase' of the 'operation'
+       * \return the percentiles; every percentile is the upper bound of its bucket, at most the maximum
+       */
+      [[nodiscard]]
+      latency_percentiles percentiles(std::size_t operation, std::size_t phase) const noexcept
+      {
+        long long buckets[latency_histogram_bucket_count]{};
+        latency_percentiles result{};
+        for (const auto& shard : m_shards)
+        {
+          for (std::size_t i = 0U; i < latency_histogram_bucket_count; ++i)
+          {
+            buckets[i] += shard.m_object.m_buckets[operation][phase][i].load(std::memory_order_relaxed);
+          }
+          result.m_max = (std::max)(result.m_max,
+            static_cast<std::uint64_t>(shard.m_object.m_max[operation][phase].load(std::memory_order_relaxed)));
+        }
+
+        for (const auto count : buckets)
+        {
+          result.m_count += count;
+        }
+        result.m_p50 = quantile(buckets, result.m_count, 500LL, result.m_max);
+        result.m_p99 = quantile(buckets, result.m_count, 990LL, result.m_max);
+        result.m_p999 = quantile(buckets, result.m_count, 999LL, result.m_max);
+        return result;
+      }
+
+    private:
+      [[nodiscard]]
+      static std::uint64_t quantile(const long long* buckets, long long count, long long per_mille, std::uint64_t max) noexcept
+      {
+        // the rank of the quantile rounded up
+        const long long rank = (count * per_mille + 999LL) / 1000LL;
+        long long below = 0LL;
+        for (std::size_t i = 0U; 0LL != rank && i < latency_histogram_bucket_count; ++i)
+        {
+          below += buckets[i];
+          if (below >= rank)
+          {
+            return (std::min)(log_linear_bucket_min(i + 1U, latency_histogram_sub_bucket_bits) - 1U, max);
+          }
+        }
+        return 0LL == rank ? 0U : max;
+      }
+
+      cache_line_padded<latency_shard> m_shards[stats_shard_count]{};
+    };
+
+    // Measures one operation of the resource profiling the latencies.
+    class latency_scope
+    {
+    public:
+      latency_scope(latency_profile* profile, std::size_t operation) noexcept
+        : m_profile(profile)
+        , m_operation(operation)
+      {
+        if (m_profile)
+        {
+          // the operation may run within the upstream call of another resource
+          m_outer = std::exchange(this_thread_latency(), operation_latency{});
+          m_start = clock_nanoseconds();
+        }
+      }
+
+      ~latency_scope()
+      {
+        if (m_profile)
+        {
+          m_profile->record(m_operation, this_thread_latency(), clock_nanoseconds() - m_start);
+          this_thread_latency() = m_outer;
+        }
+      }
+
+      latency_scope(const latency_scope&) = delete;
+      latency_scope& operator=(const latency_scope&) = delete;
+
+    private:
+      latency_profile*  m_profile;
+      std::size_t       m_operation;
+      operation_latency m_outer{};
+      std::uint64_t     m_start = 0U;
+    };
+
+    // Adds the lifetime of the scope to the upstream time of this_thread_latency().
+    class upstream_timer
+    {
+    public:
+      explicit upstream_timer(bool enabled) noexcept
+        : m_start(enabled ? clock_nanoseconds() : 0U)
+      {}
+
+      ~upstream_timer()
+      {
+        if (0U != m_start)
+        {
+          this_thread_latency().m_upstream += clock_nanoseconds() - m_start;
+        }
+      }
+
+      upstream_timer(const upstream_timer&) = delete;
+      upstream_timer& operator=(const upstream_timer&) = delete;
+
+    private:
+      std::uint64_t m_start;
+    };
+
+    // FIFO of the deallocated blocks of the threads of one shard
+    struct quarantine_shard
+    {
+      std::mutex m_lock;
+      block_list m_list;
+      std::size_t m_bytes;
+      std::size_t m_blocks;
+    };
+
+    /**
+     * \brief The quarantine holding the deallocated blocks back from the upstream
+     *        resource. Every thread shard has its own FIFO bounded by 'm_maxBytes'
+     *        and 'm_maxBlocks', so the threads don't contend on the quarantine.
+     *        The blocks are linked through the list node of their headers.
+     */
+    struct quarantine
+    {
+      quarantine(std::size_t max_bytes, std::size_t max_blocks) noexcept
+        : m_maxBytes(max_bytes)
+        , m_maxBlocks(max_blocks)
+      {
+      }
+
+      /**
+       * \brief Appends the header 'h' to the FIFO of the calling thread and moves
+       *        the blocks exceeding the bounds of the FIFO to 'evicted'
+       * \tparam Locking false if the quarantine is never accessed concurrently
+       * \param h the header of the deallocated block
+       * \param evicted the list receiving the evicted blocks
+       */
+      template<bool Locking = true>
+      void push(header& h, block_list& evicted)
+      {
+        auto& shard = m_shards[this_thread_shard()].m_object;
+        lock_guard_t<Locking> guard{ shard.m_lock };
+        shard.m_list.add_block(&h.m_block);
+        shard.m_bytes += h.m_bytes;
+        ++shard.m_blocks;
+
+        while (shard.m_blocks > m_maxBlocks || shard.m_bytes > m_maxBytes)
+        {
+          block* oldest = shard.m_list.remove_block(shard.m_list.m_head);
+          shard.m_bytes -= header_of(oldest)->m_bytes;
+          --shard.m_blocks;
+          evicted.add_block(oldest);
+        }
+      }
+
+      /**
+       * \brief Moves all the blocks of the quarantine to 'evicted'
+       * \param evicted the list receiving the evicted blocks
+       */
+      void drain(block_list& evicted)
+      {
+        for (auto& padded : m_shards)
+        {
+          auto& shard = padded.m_object;
+          std::lock_guard<std::mutex> guard{ shard.m_lock };
+          while (!shard.m_list.empty())
+          {
+            evicted.add_block(shard.m_list.remove_block(shard.m_list.m_head));
+          }
+          shard.m_bytes = 0U;
+          shard.m_blocks = 0U;
+        }
+      }
+
+    private:
+      std::size_t m_maxBytes;
+      std::size_t m_maxBlocks;
+      cache_line_padded<quarantine_shard> m_shards[stats_shard_count]{};
+    };
+
+    //  ----------------------------------------------------------------------------
+    //  | [GUARD PAGE] | ... | HEADER + PADDING | USER SEGMENT | [SLACK] | GUARD PAGE |
+    //  ----------------------------------------------------------------------------
+
+    /**
+     * \brief The layout of the memory block placed in its own mapping
+     *        with the user segment ending at the inaccessible guard page
+     */
+    struct guarded_layout
+    {
+      std::size_t m_length;         // length of the mapping including the guard pages
+      std::size_t m_payloadOffset;  // offset of the user segment from the beginning of the mapping
+      std::size_t m_slack;          // bytes between the user segment and the trailing guard page
+      bool m_leadingGuard;          // whether the first page of the mapping is a guard page
+    };
+
+    [[nodiscard]]
+    inline std::size_t page_size() noexcept
+    {
+#if defined(__linux__)
+      static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      return size;
+#else
+      return 4096U;
+#endif
+    }
+
+    [[nodiscard]]
+    constexpr std::size_t align_up(std::size_t value, std::size_t alignment) noexcept
+    {
+      return (value + alignment - 1U) & ~(alignment - 1U);
+    }
+
+    /**
+     * \brief Computes the layout of the guarded memory block
+     * \param header_size the size of the header (and the padding) preceding the user segment
+     * \param bytes the size of the user segment
+     * \param alignment the alignment of the user segment; at most page_size()
+     * \param leading_guard whether the page in front of the header is a guard page
+     * \return the layout of the guarded memory block
+     */
+    [[nodiscard]]
+    inline guarded_layout make_guarded_layout(
+      std::size_t header_size,
+      std::size_t bytes,
+      std::size_t alignment,
+      bool leading_guard) noexcept
+    {
+      const std::size_t page = page_size();
+      const std::size_t segment = align_up(bytes, alignment);
+      const std::size_t lead = leading_guard ? page : 0U;
+      const std::size_t data = align_up(header_size + segment, page);
+      return { lead + data + page, lead + data - segment, segment - bytes, leading_guard };
+    }
+
+    /**
+     * \brief Maps the memory of the guarded memory block and protects its guard pages
+     * \param layout the layout of the guarded memory block
+     * \return the beginning of the mapping or nullptr if the mapping failed
+     */
+    [[nodiscard]]
+    inline std::byte* map_guarded([[maybe_unused]] const guarded_layout& layout) noexcept
+    {
+#if defined(__linux__)
+      void* map = ::mmap(nullptr, layout.m_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (MAP_FAILED == map)
+      {
+        return nullptr;
+      }
+
+      auto* first = static_cast<std::byte*>(map);
+      const std::size_t page = page_size();
+      if (0 != ::mprotect(first + layout.m_length - page, page, PROT_NONE) ||
+          (layout.m_leadingGuard && 0 != ::mprotect(first, page, PROT_NONE)))
+      {
+        ::munmap(map, layout.m_length);
+        return nullptr;
+      }
+      return first;
+#else
+      return nullptr;
+#endif
+    }
+
+    /**
+     * \brief Unmaps the memory of the guarded memory block
+     * \param map the beginning of the mapping returned by map_guarded
+     * \param layout the layout of the guarded memory block
+     */
+    inline void unmap_guarded([[maybe_unused]] std::byte* map, [[maybe_unused]] const guarded_layout& layout) noexcept
+    {
+#if defined(__linux__)
+      ::munmap(map, layout.m_length);
+#endif
+    }
+
+    class local_memory
+    {
+      struct malloc_free_resource final : std::pmr::memory_resource
+      {
+        malloc_free_resource() noexcept = default;
+
+        [[nodiscard]]
+        std::pmr::memory_resource* upstream_resource() const noexcept
+        {
+          return nullptr;
+        }
+
+      private:
+        [[nodiscard]]
+        void* do_allocate(std::size_t bytes, [[maybe_unused]] std::size_t alignment) override
+        {
+          // C++ standard: requested size shall be a multiple of alignment
+          const auto div = bytes / alignment;
+          const auto rem = bytes - div * alignment;
+          bytes = rem == 0U ? bytes : (div + 1U) * alignment;
+
+#ifdef _MSC_VER
+          // Windows-specific API:
+          void* p = ::_aligned_malloc(bytes, alignment);
+#else
+          // standard C++17 API:
+          void* p = std::aligned_alloc(alignment, bytes);
+#endif
+
+          if (!p)
+          {
+            throw std::bad_alloc();
+          }
+          return p;
+        }
+
+        void do_deallocate(void* p, [[maybe_unused]] std::size_t bytes, [[maybe_unused]] std::size_t alignment) override
+        {
+#ifdef _MSC_VER
+          // Windows-specific API:
+          ::_aligned_free(p);
+#else
+          // standard C++17 API:
+          std::free(p);
+#endif
+        }
+
+        [[nodiscard]]
+        bool do_is_equal(const std::pmr::memory_resource& that) const noexcept override
+        {
+          //return nullptr != dynamic_cast<const malloc_free_resource*>(&that);
+          //return typeid(malloc_free_resource&) == typeid(that);
+          //there is only one instance of malloc_free_resource in the process
+          return this == &that;
+        }
+      };
+
+    public:
+      ~local_memory() = delete;
+
+      static std::pmr::memory_resource* resource() noexcept
+      {
+        // immortalize the instance of malloc_free_resource type
+        // the instance 'r' is never destructed;
+        // the memory space where r is placed is deallocated,
+        // when main function is finished
+        using type = malloc_free_resource;
+        alignas(type) static std::uint8_t buffer[sizeof(type)];
+        static type* r = new (buffer) type;
+        return r;
+      }
+    };
+
+    // the two lower case hexadecimal digits of every byte value
+    constexpr std::array<char, 512U> make_hex_byte_table() noexcept
+    {
+      std::array<char, 512U> table{};
+      for (std::size_t i = 0U; i < 256U; ++i)
+      {
+        table[2U * i] = "0123456789abcdef"[i >> 4U];
+        table[2U * i + 1U] = "0123456789abcdef"[i & 15U];
+      }
+      return table;
+    }
+
+    inline constexpr std::array<char, 512U> hex_byte_table = make_hex_byte_table();
+
+    template<typename CharT>
+    class report_formater
+    {
+    public:
+      using char_type = CharT;
+      using traits_type = std::char_traits<char_type>;
+      using string_type = std::basic_string<char_type, traits_type>;
+
+      /**
+       * \brief Format in hex to 'output' string, a block of memory starting at the specified
+       *        starting 'address' of the specified 'length' (in bytes). Each line of
+       *        formatted output will have a maximum of 16 bytes per line, where each
+       *        line starts with the address of that 16-byte chunk.
+       * \param address start address of memory block
+       * \param length the length of memory block in bytes
+       * \return string representation of specified memory block
+       */
+      static string_type mem2str(void* address, std::size_t length)
+      {
+        // the longest line: the line break, the address, the separator, 16 bytes and 3 group gaps
+        static constexpr std::size_t line_size = 1U + 2U + 2U * sizeof(void*) + 7U + 16U * 3U + 3U * 2U;
+
+        const auto* addr = static_cast<const unsigned char*>(address);
+
+        string_type output(((length + 15U) / 16U) * line_size + 1U, char_type());
+        char_type* out = output.data();
+
+        for (std::size_t offset = 0U; offset < length; offset += 16U)
+        {
+          if (0U != offset)
+          {
+            *out++ = '\n';
+          }
+          out = write_pointer(out, addr + offset);
+          for (const char c : std::string_view(":      "))
+          {
+            *out++ = c;
+          }
+
+          const std::size_t count = (std::min)(length - offset, std::size_t{ 16U });
+          for (std::size_t j = 0U; j < count; ++j)
+          {
+            if (0U != j && 0U == j % 4U)
+            {
+              *out++ = ' ';
+              *out++ = ' ';
+            }
+            const char* digits = &hex_byte_table[2U * addr[offset + j]];
+            *out++ = digits[0];
+            *out++ = digits[1];
+            *out++ = ' ';
+          }
+        }
+
+        *out++ = '\n';
+        output.resize(static_cast<std::size_t>(out - output.data()));
+        return output;
+      }
+
+      static string_type addr2str(void* address)
+      {
+        static constexpr std::size_t hexdigit_count = sizeof(std::intptr_t) * 2U;
+        char_type line[hexdigit_count + 1U] = { '\0' };
+
+        snprintf(&line[0U], hexdigit_count, "%p", address);
+
+        return line;
+      }
+
+      static string_type msg2str(const char* format, va_list args)
+      {
+        static constexpr std::size_t buffer_size = 4095U;
+        char_type buffer[buffer_size + 1U] = { '\0' };
+        return 0 <= vsnprintf(buffer, buffer_size, format, args) ? string_type(buffer) : string_type();
+      }
+
+    private:
+      // writes 'address' in the format of "%p"
+      static char_type* write_pointer(char_type* out, const void* address)
+      {
+        char text[2U + 2U * sizeof(void*) + 1U];
+        char* end = text;
+        if (nullptr == address)
+        {
+          end += (std::max)(0, snprintf(text, sizeof(text), "%p", address));
+        }
+        else
+        {
+          auto value = reinterpret_cast<std::uintptr_t>(address);
+#if defined(_WIN32)
+          // the Microsoft C runtime writes all the upper case digits without the prefix
+          for (std::size_t i = 2U * sizeof(void*); 0U != i; --i, value >>= 4U)
+          {
+            text[i - 1U] = "0123456789ABCDEF"[value & 15U];
+          }
+          end += 2U * sizeof(void*);
+#else
+          *end++ = '0';
+          *end++ = 'x';
+          end = std::to_chars(end, std::end(text), value, 16).ptr;
+#endif
+        }
+        return std::copy(text, end, out);
+      }
+    };
+
+    // the integer written by report_buffer right aligned to 'm_width' characters
+    template<typename T>
+    struct report_number
+    {
+      T           m_value;
+      std::size_t m_width;
+      int         m_base;
+    };
+
+    template<typename T>
+    [[nodiscard]]
+    report_number<T> number(T value, std::size_t width, int base = 10) noexcept
+    {
+      return { value, width, base };
+    }
+
+    // the address written by report_buffer as a hexadecimal number
+    struct report_address
+    {
+      const void* m_address;
+    };
+
+    /**
+     * \brief The writer of the long reports formatting the numbers by std::to_chars
+     *        into the preallocated buffer, which is written to the stream when full
+     */
+    template<std::size_t Capacity>
+    class basic_report_buffer
+    {
+    public:
+      static constexpr std::size_t capacity = Capacity;
+
+      explicit basic_report_buffer(std::ostream& os) noexcept
+        : m_stream(os)
+      {}
+
+      ~basic_report_buffer()
+      {
+        flush();
+      }
+
+      basic_report_buffer(const basic_report_buffer&) = delete;
+      basic_report_buffer& operator=(const basic_report_buffer&) = delete;
+
+      basic_report_buffer& operator<<(std::string_view text)
+      {
+        if (m_size + text.size() > capacity)
+        {
+          flush();
+          if (text.size() > capacity)
+          {
+            m_stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+            return *this;
+          }
+        }
+        std::copy(text.begin(), text.end(), m_buffer + m_size);
+        m_size += text.size();
+        return *this;
+      }
+
+      basic_report_buffer& operator<<(char c)
+      {
+        return *this << std::string_view(&c, 1U);
+      }
+
+      template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+      basic_report_buffer& operator<<(T value)
+      {
+        return *this << report_number<T>{ value, 0U, 10 };
+      }
+
+      template<typename T>
+      basic_report_buffer& operator<<(report_number<T> value)
+      {
+        char digits[8U * sizeof(T) + 1U];
+        const auto result = std::to_chars(std::begin(digits), std::end(digits), value.m_value, value.m_base);
+        const auto length = static_cast<std::size_t>(result.ptr - digits);
+        static constexpr std::string_view spaces = "                                ";
+        for (std::size_t padding = value.m_width > length ? value.m_width - length : 0U; 0U != padding;)
+        {
+          const std::size_t count = (std::min)(padding, spaces.size());
+          *this << spaces.substr(0U, count);
+          padding -= count;
+        }
+        return *this << std::string_view(digits, length);
+      }
+
+      basic_report_buffer& operator<<(report_address value)
+      {
+        return *this << "0x" << report_number<std::uintptr_t>{ reinterpret_cast<std::uintptr_t>(value.m_address), 0U, 16 };
+      }
+
+      void flush()
+      {
+        if (0U != m_size)
+        {
+          m_stream.write(m_buffer, static_cast<std::streamsize>(m_size));
+          m_size = 0U;
+        }
+      }
+
+    private:
+      std::ostream& m_stream;
+      std::size_t   m_size = 0U;
+      char          m_buffer[capacity];
+    };
+
+    using report_buffer = basic_report_buffer<16384U>;
+
+    /**
+     * \brief Writes the call site column of test_resource::dump_blocks()
+     */
+    inline void write_stack_id(report_buffer& out, std::uint32_t stack_id)
+    {
+      if (0U != stack_id)
+      {
+        out << number(stack_id, 11U);
+      }
+      else
+      {
+        out << "          -";
+      }
+    }
+
+    /**
+     * \brief Writes the frames of the call stack 'site', one per line
+     */
+    inline void write_frames(report_buffer& out, const callsite& site)
+    {
+#if defined(__GLIBC__)
+      if (char** symbols = ::backtrace_symbols(site.m_frames, static_cast<int>(site.m_depth)))
+      {
+        for (std::size_t i = 0U; i < site.m_depth; ++i)
+        {
+          out << "     #" << i << ' ' << symbols[i] << '\n';
+        }
+        ::free(symbols);
+        return;
+      }
+#endif
+      for (std::size_t i = 0U; i < site.m_depth; ++i)
+      {
+        out << "     #" << i << ' ' << report_address{ site.m_frames[i] } << '\n';
+      }
+    }
+
+    class stream_test_resource_reporter
+      : public test_resource_reporter
+    {
+    public:
+      explicit stream_test_resource_reporter(std::ostream& os) noexcept
+        : m_stream(os)
+      {}
+
+    protected:
+      void do_report_allocation(const test_resource& tr) override;
+      void do_report_deallocation(const test_resource& tr) override;
+      void do_report_release(const test_resource& tr) override;
+      void do_report_invalid_memory_block(
+        const test_resource& tr,
+        std::size_t deallocatedBytes,
+        std::size_t deallocatedAlignment,
+        int underrunBy,
+        int overrunBy) override;
+      void do_report_write_after_free(
+        const test_resource& tr,
+        const void* address,
+        std::size_t bytes,
+        std::size_t alignment,
+        std::size_t offset) override;
+      void do_report_print(const test_resource& tr) override;
+      void do_report_log_msg(const char* format, va_list args) override;
+
+    private:
+      using char_type = std::ostream::char_type;
+      using formater_type = report_formater<char_type>;
+      using string_type = formater_type::string_type;
+
+      void print_callsites(const test_resource& tr);
+      void print_lifetimes(const test_resource& tr);
+      void print_latencies(const test_resource& tr);
+      void print_frames(std::uint32_t stack_id);
+
+      std::ostream& m_stream;
+    };
+
+    template<typename StreamReporter>
+    [[nodiscard]]
+    test_resource_reporter* _console_test_resource_reporter() noexcept
+    {
+      alignas(StreamReporter) static std::uint8_t buffer[sizeof(StreamReporter)];
+      static auto* reporter = new (buffer) StreamReporter(std::cout);
+      return reporter;
+    }
+
+    [[nodiscard]]
+    inline std::atomic<test_resource_reporter*>& _default_test_resource_reporter() noexcept
+    {
+      using type = std::atomic<test_resource_reporter*>;
+      alignas(type) static std::uint8_t buffer[sizeof(type)];
+      static type* reporter = new (buffer) type(_console_test_resource_reporter<stream_test_resource_reporter>());
+      return *reporter;
+    }
+
+    template<
+      typename StreamReporter,
+      typename = std::enable_if_t<
+        std::is_base_of_v<test_resource_reporter, std::decay_t<StreamReporter>>>
+    >
+    class file_reporter : public StreamReporter
+    {
+    public:
+      file_reporter() noexcept
+        : stream_test_resource_reporter(m_fstream)
+      {
+      }
+
+      explicit file_reporter(
+        const std::filesystem::path& filename,
+        std::ios_base::openmode mode = std::ios_base::out)
+        : stream_test_resource_reporter(m_fstream)
+        , m_fstream(filename, mode)
+      {
+      }
+
+      void open(const std::filesystem::path& filename,
+        std::ios_base::openmode mode = std::ios_base::out)
+      {
+        m_fstream.open(filename, mode);
+      }
+
+      void close()
+      {
+        m_fstream.close();
+      }
+
+      [[nodiscard]]
+      bool good() const
+      {
+        return m_fstream.good();
+      }
+
+    protected:
+      void do_report_allocation(const test_resource& tr) override
+      {
+        if (validate())
+        {
+          stream_test_resource_reporter::do_report_allocation(tr);
+        }
+      }
+
+      void do_report_deallocation(const test_resource& tr) override
+      {
+        if (validate())
+        {
+          stream_test_resource_reporter::do_report_deallocation(tr);
+        }
+      }
+
+      void do_report_release(const test_resource& tr) override
+      {
+        if (validate())
+        {
+          stream_test_resource_reporter::do_report_release(tr);
+        }
+      }
+
+      void do_report_invalid_memory_block(
+        const test_resource& tr,
+        std::size_t deallocatedBytes,
+        std::size_t deallocatedAlignment,
+        int underrunBy,
+        int overrunBy) override
+      {
+        if (validate())
+        {
+          stream_test_resource_reporter::do_report_invalid_memory_block(
+            tr,
+            deallocatedBytes,
+            deallocatedAlignment,
+            underrunBy,
+            overrunBy
+          );
+        }
+      }
+
+      void do_report_write_after_free(
+        const test_resource& tr,
+        const void* address,
+        std::size_t bytes,
+        std::size_t alignment,
+        std::size_t offset) override
+      {
+        if (validate())
+        {
+          stream_test_resource_reporter::do_report_write_after_free(tr, address, bytes, alignment, offset);
+        }
+      }
+
+      void do_report_print(const test_resource& tr) override
+      {
+        if (validate())
+        {
+          stream_test_resource_reporter::do_report_print(tr);
+        }
+      }
+
+      void do_report_log_msg(const char* format, va_list args) override
+      {
+        if (validate())
+        {
+          stream_test_resource_reporter::do_report_log_msg(format, args);
+        }
+      }
+
+    private:
+      [[nodiscard]]
+      bool validate() const
+      {
+        return m_fstream.is_open();
+      }
+
+      std::ofstream m_fstream;
+    };
+  }
+
+  using file_test_resource_reporter = detail::file_reporter<detail::stream_test_resource_reporter>;
+
+  template<typename StreamReporter = detail::stream_test_resource_reporter,
+    typename = std::enable_if_t<
+      std::is_base_of_v<test_resource_reporter, std::decay_t<StreamReporter>>>
+  >
+  [[nodiscard]]
+  decltype(auto)
+  console_test_resource_reporter() noexcept
+  {
+    return detail::_console_test_resource_reporter<StreamReporter>();
+  }
+
+  [[nodiscard]]
+  inline test_resource_reporter*
+  null_test_resource_reporter() noexcept
+  {
+    class type final : public test_resource_reporter
+    {
+    public:
+      type() noexcept = default;
+
+    private:
+      void do_report_allocation(const test_resource&) override
+      {
+      }
+
+      void do_report_deallocation(const test_resource&) override
+      {
+      }
+
+      void do_report_release(const test_resource&) override
+      {
+      }
+
+      void do_report_invalid_memory_block(
+        const test_resource&,
+        std::size_t,
+        std::size_t,
+        int,
+        int) override
+      {
+      }
+
+      void do_report_write_after_free(
+        const test_resource&,
+        const void*,
+        std::size_t,
+        std::size_t,
+        std::size_t) override
+      {
+      }
+
+      void do_report_print(const test_resource&) override
+      {
+      }
+
+      void do_report_log_msg(const char*, va_list) override
+      {
+      }
+    };
+
+    // immortalize -> no destructor called on top of reporter
+    alignas(type) static std::uint8_t buffer[sizeof(type)];
+    static type* reporter = new (buffer) type;
+    return reporter;
+  }
+
+  [[nodiscard]]
+  inline test_resource_reporter*
+  get_default_test_resource_reporter() noexcept
+  {
+    return detail::_default_test_resource_reporter().load();
+  }
+
+  inline test_resource_reporter*
+  set_default_test_resource_reporter(test_resource_reporter* reporter = nullptr) noexcept
+  {
+    if (!reporter)
+    {
+        reporter = console_test_resource_reporter();
+    }
+    return detail::_default_test_resource_reporter().exchange(reporter);
+  }
+
+  /**
+   * \brief The test_resource_exception is thrown by the test_resource
+   *        when its allocation limit is reached and there is an attempt
+   *        to allocate further memory. It is basically a special form of
+   *        std::bad_alloc that allows the exception tester algorithm
+   *        to differentiate between real out‐of‐memory situations from
+   *        the test‐induced limits.
+   * \note  The exception inherits from std::bad_alloc so that when it is thrown,
+   *        the same code path will be traveled like in case of a real allocation
+   *        failure. In other words: to ensure that we test the code that would
+   *        run in production, in case std::bad_alloc is thrown by a memory resource.
+   */
+  class test_resource_exception : public std::bad_alloc
+  {
+  public:
+    template<typename LockPolicy, typename GuardPolicy, typename ScribblePolicy, typename TrackingPolicy, typename StatsPolicy>
+    test_resource_exception(
+      basic_test_resource<LockPolicy, GuardPolicy, ScribblePolicy, TrackingPolicy, StatsPolicy>* originating,
+      std::size_t size,
+      std::size_t alignment) noexcept
+      : m_originating(originating)
+      , m_originatingName(originating->name())
+      , m_size(size)
+      , m_alignment(alignment)
+    {
+    }
+
+    [[nodiscard]]
+    const char* what() const noexcept override
+    {
+      return "stdx::pmr::test_resource_exception";
+    }
+
+    [[nodiscard]]
+    std::pmr::memory_resource* originating_resource() const noexcept
+    {
+      return m_originating;
+    }
+
+    [[nodiscard]]
+    std::string_view originating_name() const noexcept
+    {
+      return m_originatingName;
+    }
+
+    [[nodiscard]]
+    std::size_t size() const noexcept
+    {
+      return m_size;
+    }
+
+    [[nodiscard]]
+    std::size_t alignment() const noexcept
+    {
+      return m_alignment;
+    }
+
+  private:
+    std::pmr::memory_resource* m_originating;
+    std::string_view m_originatingName;
+    std::size_t m_size;
+    std::size_t m_alignment;
+  };
+
+  /**
+   * \brief The statistics of test_resource read at once by test_resource::snapshot()
+   * \note The counters of every completed allocation and deallocation are either
+   *       all included or all excluded, so e.g. m_blocksInUse and m_bytesInUse
+   *       always belong together. The error counters and the number of requests
+   *       are counted independently of the outcome of the requests.
+   */
+  struct test_resource_stats
+  {
+    long long m_allocations = 0LL;
+    long long m_deallocations = 0LL;
+    long long m_blocksInUse = 0LL;
+    long long m_maxBlocks = 0LL;
+    long long m_totalBlocks = 0LL;
+    long long m_bytesInUse = 0LL;
+    long long m_maxBytes = 0LL;
+    long long m_totalBytes = 0LL;
+    long long m_mismatches = 0LL;
+    long long m_boundsErrors = 0LL;
+    long long m_badDeallocateParams = 0LL;
+    long long m_writesAfterFree = 0LL;
+
+    void*       m_lastAllocatedAddress = nullptr;
+    std::size_t m_lastAllocatedBytes = 0U;
+    std::size_t m_lastAllocatedAlignment = 0U;
+    void*       m_lastDeallocatedAddress = nullptr;
+    std::size_t m_lastDeallocatedBytes = 0U;
+    std::size_t m_lastDeallocatedAlignment = 0U;
+
+    [[nodiscard]]
+    long long errors() const noexcept
+    {
+      return m_mismatches + m_boundsErrors + m_badDeallocateParams + m_writesAfterFree;
+    }
+
+    [[nodiscard]]
+    bool has_errors() const noexcept
+    {
+      return errors() != 0LL;
+    }
+
+    [[nodiscard]]
+    bool has_allocations() const noexcept
+    {
+      return m_blocksInUse > 0LL || m_bytesInUse > 0LL;
+    }
+
+    /**
+     * \brief Get the status of the statistics in the sense of test_resource::status()
+     * \return the number of errors, -1 if there are active allocations (but no errors), 0 otherwise
+     */
+    [[nodiscard]]
+    long long status() const noexcept
+    {
+      if (const long long numErrors = errors(); numErrors > 0LL)
+      {
+        return numErrors;
+      }
+
+      return has_allocations() ? -1LL : 0LL;
+    }
+  };
+
+  /**
+   * \brief The histograms of the sizes and the alignments of the successful
+   *        allocations of test_resource returned by test_resource::histograms()
+   * \note The sizes are counted in log2 buckets split into sub_buckets linear
+   *       sub-buckets each (the sizes below sub_buckets have their own buckets),
+   *       the alignments in log2 buckets.
+   */
+  struct test_resource_histograms
+  {
+    static constexpr std::size_t sub_buckets = detail::size_histogram_sub_buckets;
+    static constexpr std::size_t size_bucket_count = detail::size_histogram_bucket_count;
+    static constexpr std::size_t alignment_bucket_count = detail::alignment_histogram_bucket_count;
+
+    std::array<long long, size_bucket_count>      m_sizes{};
+    std::array<long long, alignment_bucket_count> m_alignments{};
+
+    /**
+     * \brief Returns the index of the size bucket counting the allocations of 'bytes'
+     * \param bytes the requested number of bytes
+     * \return the index into m_sizes
+     */
+    [[nodiscard]]
+    static constexpr std::size_t size_bucket(std::size_t bytes) noexcept
+    {
+      return detail::size_histogram_bucket(bytes);
+    }
+
+    /**
+     * \brief Returns the smallest size counted in the size bucket 'index'
+     * \param index the index into m_sizes
+     * \return the smallest number of bytes of the bucket
+     */
+    [[nodiscard]]
+    static constexpr std::size_t size_bucket_min(std::size_t index) noexcept
+    {
+      return detail::size_histogram_bucket_min(index);
+    }
+
+    /**
+     * \brief Returns the alignment counted in the alignment bucket 'index'
+     * \param index the index into m_alignments
+     * \return the alignment of the bucket; the last bucket counts all the larger alignments too
+     */
+    [[nodiscard]]
+    static constexpr std::size_t alignment_of_bucket(std::size_t index) noexcept
+    {
+      return std::size_t{ 1U } << index;
+    }
+  };
+
+  /**
+   * \brief The lifetimes of the deallocated blocks of test_resource
+   *        returned by test_resource::lifetimes()
+   * \note The lifetimes are counted in log2 buckets both in nanoseconds and in the
+   *       number of the allocations made while the block was allocated.
+   */
+  struct test_resource_lifetimes
+  {
+    static constexpr std::size_t bucket_count = detail::lifetime_bucket_count;
+    static constexpr std::size_t size_class_count = detail::lifetime_size_class_count;
+
+    struct histogram
+    {
+      std::array<long long, bucket_count> m_nanoseconds{};
+      std::array<long long, bucket_count> m_allocations{};  // by the intervening allocations
+      std::array<long long, bucket_count> m_bytes{};        // the bytes of m_allocations
+    };
+
+    // the lifetimes of the blocks of one allocation call site
+    struct site
+    {
+      std::uint32_t m_stackId = 0U;          // 0 - the blocks allocated without the capture
+      long long     m_blocks = 0LL;
+      long long     m_bytes = 0LL;
+      long long     m_shortLivedBytes = 0LL; // the bytes of the blocks shorter lived than the threshold
+      histogram     m_lifetimes{};
+    };
+
+    std::array<histogram, size_class_count> m_sizeClasses{};
+    std::vector<site> m_sites;  // the arena candidates, the most short lived bytes first
+
+    /**
+     * \brief Returns the index of the size class of the blocks of 'bytes'
+     * \param bytes the size of the block
+     * \return the index into m_sizeClasses
+     */
+    [[nodiscard]]
+    static constexpr std::size_t size_class(std::size_t bytes) noexcept
+    {
+      return detail::log2_bucket(bytes, size_class_count);
+    }
+
+    /**
+     * \brief Returns the smallest value counted in the bucket 'index' of a histogram or a size class
+     * \param index the index of the bucket
+     * \return the smallest value of the bucket; the last bucket counts all the larger values too
+     */
+    [[nodiscard]]
+    static constexpr std::uint64_t bucket_min(std::size_t index) noexcept
+    {
+      return 0U == index ? 0U : std::uint64_t{ 1U } << (index - 1U);
+    }
+  };
+
+  /**
+   * \brief The outstanding blocks of one size allocated at one call site
+   *        returned by test_resource::top_blocks()
+   */
+  struct test_resource_block_group
+  {
+    std::uint32_t m_stackId = 0U;  // 0 - the blocks allocated without the capture
+    std::size_t   m_size = 0U;
+    long long     m_blocks = 0LL;
+    std::size_t   m_bytes = 0U;
+  };
+
+  /**
+   * \brief The percentiles of the latencies of the allocations and the deallocations
+   *        of test_resource in nanoseconds returned by test_resource::latencies()
+   * \note The latencies are counted in the buckets of 1/8 of a power of two;
+   *       a percentile is the upper bound of its bucket, at most the maximum.
+   */
+  struct test_resource_latencies
+  {
+    using percentiles = detail::latency_percentiles;
+
+    // the latencies of the operations of one kind split by their phases
+    struct operation
+    {
+      percentiles m_lockWait;     // waiting for the locks of the resource
+      percentiles m_bookkeeping;  // the checks and the bookkeeping of the resource itself
+      percentiles m_upstream;     // in the upstream resource
+      percentiles m_total;
+    };
+
+    operation m_allocations;
+    operation m_deallocations;
+  };
+
+  /**
+   * \brief The operation of the event of the allocation trace
+   */
+  enum class trace_operation : std::uint8_t
+  {
+    allocation,
+    deallocation
+  };
+
+  /**
+   * \brief One event of the allocation trace
+   */
+  struct test_resource_trace_event
+  {
+    trace_operation m_operation = trace_operation::allocation;
+    std::uint32_t   m_thread = 0U;      // index of the recording thread, in the order of the first events
+    std::uint64_t   m_timestamp = 0U;   // see test_resource_trace_reader::ticks_per_second()
+    long long       m_index = 0LL;      // allocation index of the block; -1 if unknown
+    std::size_t     m_bytes = 0U;
+    std::size_t     m_alignment = 0U;
+    std::uintptr_t  m_address = 0U;
+    std::uint32_t   m_stackId = 0U;     // call site of the allocation; 0 if unknown
+  };
+
+  namespace detail
+  {
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__x86_64__) || defined(__i386__)
+    inline constexpr bool trace_tsc_timestamps = true;
+#else
+    inline constexpr bool trace_tsc_timestamps = false;
+#endif
+
+    // the time stamp counter where available, otherwise the monotonic clock in nanoseconds
+    [[nodiscard]]
+    inline std::uint64_t trace_timestamp() noexcept
+    {
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || defined(__x86_64__) || defined(__i386__)
+      return __rdtsc();
+#else
+      return clock_nanoseconds();
+#endif
+    }
+
+    // The event kept in the ring of the recording thread.
+    struct trace_record
+    {
+      std::uint64_t m_timestamp;
+      std::uint64_t m_address;
+      std::uint64_t m_bytes;
+      std::int64_t  m_index;
+      std::uint32_t m_stackId;
+      std::uint8_t  m_operation;
+      std::uint8_t  m_alignmentLog2;
+      std::uint16_t m_reserved;
+    };
+    static_assert(sizeof(trace_record) == 40U);
+
+    /**
+     * \brief The single producer, single consumer ring of the events of one thread
+     * \note A full ring drops the new events, the producer never waits for the drainer;
+     *       instead push() tells when the ring passes half full so the drainer is woken early.
+     */
+    class trace_ring
+    {
+    public:
+      trace_ring(std::size_t capacity, std::uint32_t thread)
+        : m_records(new trace_record[capacity])
+        , m_mask(capacity - 1U)
+        , m_half(capacity / 2U)
+        , m_thread(thread)
+        , m_owner(std::this_thread::get_id())
+      {}
+
+      // stamps the record and appends it; the time stamp of a dropped record is not read
+      // returns true if the record fills the ring up to its half
+      bool push(trace_record record) noexcept
+      {
+        const std::uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tailCache > m_mask)
+        {
+          m_tailCache = m_tail.load(std::memory_order_acquire);
+          if (head - m_tailCache > m_mask)
+          {
+            m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1LL, std::memory_order_relaxed);
+            return false;
+          }
+        }
+        record.m_timestamp = trace_timestamp();
+        m_records[head & m_mask] = record;
+        m_head.store(head + 1U, std::memory_order_release);
+        if (head + 1U - m_tailCache != m_half)
+        {
+          return false;
+        }
+        // the cached tail may be behind the drainer
+        m_tailCache = m_tail.load(std::memory_order_acquire);
+        return head + 1U - m_tailCache == m_half;
+      }
+
+      // passes the records pushed so far to 'consume'; called by the consumer only
+      template<typename Consume>
+      void drain(Consume consume)
+      {
+        std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const std::uint64_t head = m_head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail)
+        {
+          consume(m_records[tail & m_mask]);
+        }
+        m_tail.store(tail, std::memory_order_release);
+      }
+
+      [[nodiscard]]
+      std::uint32_t thread() const noexcept
+      {
+        return m_thread;
+      }
+
+      [[nodiscard]]
+      std::thread::id owner() const noexcept
+      {
+        return m_owner;
+      }
+
+      [[nodiscard]]
+      long long dropped() const noexcept
+      {
+        return m_dropped.load(std::memory_order_relaxed);
+      }
+
+    private:
+      // the producer's line
+      alignas(cache_line_size) std::atomic<std::uint64_t> m_head{ 0U };
+      std::uint64_t m_tailCache{ 0U };
+      std::atomic_llong m_dropped{ 0LL };
+      // the consumer's line
+      alignas(cache_line_size) std::atomic<std::uint64_t> m_tail{ 0U };
+
+      std::unique_ptr<trace_record[]> m_records;
+      std::uint64_t m_mask;
+      std::uint64_t m_half;
+      std::uint32_t m_thread;
+      std::thread::id m_owner;
+    };
+
+    // The layout of the trace file, version 1 (all the integers in the native byte order):
+    // the 64 bytes header followed by the events, each encoded as
+    //   the byte of the operation (bit 0) and the log2 of the alignment (bits 1-7),
+    //   the varints of the thread, the timestamp delta (zigzag), the allocation index
+    //   delta (zigzag), the size, the address delta (zigzag) and the stack id.
+    // The deltas are taken from the previous event; the first timestamp from the header.
+    inline constexpr char trace_file_magic[8] = { 'S', 'T', 'D', 'X', 'T', 'R', 'C', '\0' };
+    inline constexpr std::uint32_t trace_file_version = 1U;
+    // the timestamps are the ticks of the time stamp counter (otherwise nanoseconds)
+    inline constexpr std::uint32_t trace_file_tsc = 1U;
+
+    struct trace_file_header
+    {
+      char          m_magic[8];
+      std::uint32_t m_version;
+      std::uint32_t m_headerSize;
+      std::uint32_t m_flags;
+      std::uint32_t m_threads;
+      std::uint64_t m_ticksPerSecond;
+      std::uint64_t m_firstTimestamp;
+      std::uint64_t m_events;
+      std::uint64_t m_dropped;
+      char          m_reserved[8];
+    };
+    static_assert(sizeof(trace_file_header) == 64U);
+
+    // the longest varint of a 64-bit value
+    inline constexpr std::size_t max_varint_size = 10U;
+
+    inline char* write_varint(char* out, std::uint64_t value) noexcept
+    {
+      while (value >= 0x80U)
+      {
+        *out++ = static_cast<char>(value | 0x80U);
+        value >>= 7U;
+      }
+      *out++ = static_cast<char>(value);
+      return out;
+    }
+
+    [[nodiscard]]
+    constexpr std::uint64_t zigzag(std::int64_t value) noexcept
+    {
+      return (static_cast<std::uint64_t>(value) << 1U) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    [[nodiscard]]
+    constexpr std::int64_t unzigzag(std::uint64_t value) noexcept
+    {
+      return static_cast<std::int64_t>(value >> 1U) ^ -static_cast<std::int64_t>(value & 1U);
+    }
+  }
+
+  /**
+   * \brief Records the allocations and the deallocations of the test_resource instances
+   *        it is attached to (see test_resource::set_trace_recorder) into a binary trace file
+   * \note Every thread appends fixed size records to its own lock-free ring; a background
+   *       thread drains the rings every 'interval' and whenever a ring passes half full,
+   *       orders the drained events by their time stamps and writes them delta encoded.
+   *       The events not fitting into a full ring are dropped and counted. The trace is
+   *       complete when the recorder is destroyed.
+   * \note The rings are kept until the recorder is destroyed; a new thread reuses the ring
+   *       of an exited thread with the same std::thread::id. The trace is read by
+   *       test_resource_trace_reader.
+   */
+  class test_resource_trace_recorder
+  {
+  public:
+    // default number of the events of the ring of a thread (2.5 MB)
+    static constexpr std::size_t default_ring_capacity = 65536U;
+
+    /**
+     * \param path the path of the trace file
+     * \param interval the period of the draining of the rings
+     * \param ring_capacity the number of the events of every ring; rounded up to a power of two
+     */
+    explicit test_resource_trace_recorder(const std::filesystem::path& path,
+      std::chrono::milliseconds interval = std::chrono::milliseconds(1),
+      std::size_t ring_capacity = default_ring_capacity)
+      : m_file(path, std::ios::binary | std::ios::trunc)
+      , m_interval(interval)
+      , m_ringCapacity(std::size_t{ 1U } << detail::bit_width((std::max)(ring_capacity, std::size_t{ 2U }) - 1U))
+      , m_startTimestamp(detail::trace_timestamp())
+      , m_startNanoseconds(detail::clock_nanoseconds())
+      , m_previousTimestamp(m_startTimestamp)
+    {
+      write_header();
+      m_thread = std::thread([this] { run(); });
+    }
+
+    ~test_resource_trace_recorder()
+    {
+      {
+        std::lock_guard<std::mutex> guard{ m_wakeupLock };
+        m_stopped = true;
+      }
+      m_wakeup.notify_one();
+      m_thread.join();
+      flush();
+      write_header();
+    }
+
+    test_resource_trace_recorder(const test_resource_trace_recorder&) = delete;
+    test_resource_trace_recorder& operator=(const test_resource_trace_recorder&) = delete;
+
+    /**
+     * \brief Checks whether the trace file is being written
+     */
+    [[nodiscard]]
+    bool is_open() const noexcept
+    {
+      return m_file.is_open() && !m_file.fail();
+    }
+
+    /**
+     * \brief Records one event in the ring of the calling thread
+     * \param operation the operation of the event
+     * \param index the allocation index of the block or -1
+     * \param address the address of the block
+     * \param bytes the size of the block
+     * \param alignment the alignment of the block
+     * \param stack_id the call site of the allocation or 0
+     */
+    void record(trace_operation operation, long long index, const void* address,
+      std::size_t bytes, std::size_t alignment, std::uint32_t stack_id) noexcept
+    {
+      detail::trace_ring* ring = local_ring();
+      if (nullptr != ring && ring->push({ 0U, reinterpret_cast<std::uintptr_t>(address), bytes, index, stack_id,
+        static_cast<std::uint8_t>(operation), static_cast<std::uint8_t>(detail::countr_zero(alignment)), 0U }))
+      {
+        // the notification is not taken under the lock of the drainer; should it arrive
+        // before the drainer waits, the request is seen at the end of the interval
+        m_drainRequested.store(true, std::memory_order_relaxed);
+        m_wakeup.notify_one();
+      }
+    }
+
+    /**
+     * \brief Writes the events recorded so far to the trace file
+     */
+    void flush()
+    {
+      std::lock_guard<std::mutex> guard{ m_drainLock };
+      {
+        std::lock_guard<std::mutex> rings{ m_ringsLock };
+        for (auto& ring : m_rings)
+        {
+          ring->drain([this, thread = ring->thread()](const detail::trace_record& record) {
+            m_drained.emplace_back(thread, record);
+          });
+        }
+      }
+      std::stable_sort(m_drained.begin(), m_drained.end(), [](const auto& left, const auto& right) noexcept {
+        return left.second.m_timestamp < right.second.m_timestamp;
+      });
+
+      m_encoded.resize(m_drained.size() * (1U + 6U * detail::max_varint_size));
+      char* out = m_encoded.data();
+      for (const auto& [thread, record] : m_drained)
+      {
+        *out++ = static_cast<char>(record.m_operation | (record.m_alignmentLog2 << 1U));
+        out = detail::write_varint(out, thread);
+        out = detail::write_varint(out, detail::zigzag(static_cast<std::int64_t>(record.m_timestamp - m_previousTimestamp)));
+        out = detail::write_varint(out, detail::zigzag(record.m_index - m_previousIndex));
+        out = detail::write_varint(out, record.m_bytes);
+        out = detail::write_varint(out, detail::zigzag(static_cast<std::int64_t>(record.m_address - m_previousAddress)));
+        out = detail::write_varint(out, record.m_stackId);
+        m_previousTimestamp = record.m_timestamp;
+        m_previousIndex = record.m_index;
+        m_previousAddress = record.m_address;
+      }
+      m_file.write(m_encoded.data(), out - m_encoded.data());
+      m_file.flush();
+      m_events.fetch_add(static_cast<long long>(m_drained.size()), std::memory_order_relaxed);
+      m_drained.clear();
+    }
+
+    /**
+     * \brief Returns the number of the events written to the trace file
+     */
+    [[nodiscard]]
+    long long events() const noexcept
+    {
+      return m_events.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the number of the events dropped since the ring of their thread was full
+     */
+    [[nodiscard]]
+    long long dropped() const noexcept
+    {
+      std::lock_guard<std::mutex> guard{ m_ringsLock };
+      long long result = 0LL;
+      for (const auto& ring : m_rings)
+      {
+        result += ring->dropped();
+      }
+      return result;
+    }
+
+  private:
+    // the ring of the calling thread, created by its first event
+    detail::trace_ring* local_ring() noexcept
+    {
+      struct cached_ring
+      {
+        std::uint64_t       m_recorder = 0U;
+        detail::trace_ring* m_ring = nullptr;
+      };
+      thread_local cached_ring cache;
+      if (cache.m_recorder == m_id)
+      {
+        return cache.m_ring;
+      }
+
+      std::lock_guard<std::mutex> guard{ m_ringsLock };
+      const auto thread = std::this_thread::get_id();
+      detail::trace_ring* ring = nullptr;
+      for (auto& candidate : m_rings)
+      {
+        if (candidate->owner() == thread)
+        {
+          ring = candidate.get();
+        }
+      }
+      if (nullptr == ring)
+      {
+        try
+        {
+          m_rings.push_back(std::make_unique<detail::trace_ring>(m_ringCapacity, static_cast<std::uint32_t>(m_rings.size())));
+          ring = m_rings.back().get();
+        }
+        catch (const std::bad_alloc&)
+        {
+          return nullptr;
+        }
+      }
+      cache = { m_id, ring };
+      return ring;
+    }
+
+    void run()
+    {
+      std::unique_lock<std::mutex> guard{ m_wakeupLock };
+      while (!m_stopped)
+      {
+        m_wakeup.wait_for(guard, m_interval, [this] {
+          return m_stopped || m_drainRequested.exchange(false, std::memory_order_relaxed);
+        });
+        guard.unlock();
+        flush();
+        guard.lock();
+      }
+    }
+
+    void write_header()
+    {
+      detail::trace_file_header header{};
+      std::memcpy(header.m_magic, detail::trace_file_magic, sizeof(header.m_magic));
+      header.m_version = detail::trace_file_version;
+      header.m_headerSize = sizeof(header);
+      header.m_flags = detail::trace_tsc_timestamps ? detail::trace_file_tsc : 0U;
+      header.m_firstTimestamp = m_startTimestamp;
+      header.m_events = static_cast<std::uint64_t>(events());
+      header.m_dropped = static_cast<std::uint64_t>(dropped());
+      {
+        std::lock_guard<std::mutex> guard{ m_ringsLock };
+        header.m_threads = static_cast<std::uint32_t>(m_rings.size());
+      }
+      header.m_ticksPerSecond = 1000000000U;
+      if constexpr (detail::trace_tsc_timestamps)
+      {
+        // the frequency of the counter is measured over the whole recording
+        const std::uint64_t nanoseconds = detail::clock_nanoseconds() - m_startNanoseconds;
+        const std::uint64_t ticks = detail::trace_timestamp() - m_startTimestamp;
+        header.m_ticksPerSecond = 0U == nanoseconds ? 0U
+          : static_cast<std::uint64_t>(static_cast<double>(ticks) * 1e9 / static_cast<double>(nanoseconds));
+      }
+
+      const auto position = m_file.tellp();
+      m_file.seekp(0);
+      m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      if (position > static_cast<std::streamoff>(sizeof(header)))
+      {
+        m_file.seekp(position);
+      }
+      m_file.flush();
+    }
+
+    static std::uint64_t next_id() noexcept
+    {
+      static std::atomic<std::uint64_t> id{ 0U };
+      return id.fetch_add(1U, std::memory_order_relaxed) + 1U;
+    }
+
+    // tells the recorders apart in the thread local cache even if one is constructed at the address of another
+    const std::uint64_t m_id = next_id();
+    std::ofstream m_file;
+    std::chrono::milliseconds m_interval;
+    std::size_t m_ringCapacity;
+    std::uint64_t m_startTimestamp;
+    std::uint64_t m_startNanoseconds;
+
+    mutable std::mutex m_ringsLock;
+    std::vector<std::unique_ptr<detail::trace_ring>> m_rings;
+
+    // the state of the drainer
+    std::mutex m_drainLock;
+    std::vector<std::pair<std::uint32_t, detail::trace_record>> m_drained;
+    std::vector<char> m_encoded;
+    std::uint64_t m_previousTimestamp;
+    std::int64_t m_previousIndex = 0;
+    std::uint64_t m_previousAddress = 0U;
+    std::atomic_llong m_events{ 0LL };
+
+    std::mutex m_wakeupLock;
+    std::condition_variable m_wakeup;
+    // set by a ring passing half full
+    std::atomic_bool m_drainRequested{ false };
+    bool m_stopped = false;
+    std::thread m_thread;
+  };
+
+  /**
+   * \brief Reads the events of the trace file written by test_resource_trace_recorder
+   */
+  class test_resource_trace_reader
+  {
+  public:
+    /**
+     * \param path the path of the trace file
+     * \note is_open() is false if the file is missing or its layout is unknown.
+     */
+    explicit test_resource_trace_reader(const std::filesystem::path& path)
+      : m_file(path, std::ios::binary)
+    {
+      m_file.read(reinterpret_cast<char*>(&m_header), sizeof(m_header));
+      m_valid = m_file.good() &&
+        0 == std::memcmp(m_header.m_magic, detail::trace_file_magic, sizeof(detail::trace_file_magic)) &&
+        detail::trace_file_version == m_header.m_version &&
+        sizeof(m_header) == m_header.m_headerSize;
+      m_timestamp = m_header.m_firstTimestamp;
+    }
+
+    [[nodiscard]]
+    bool is_open() const noexcept
+    {
+      return m_valid;
+    }
+
+    /**
+     * \brief Returns the number of the events of the trace
+     */
+    [[nodiscard]]
+    std::uint64_t events() const noexcept
+    {
+      return m_header.m_events;
+    }
+
+    /**
+     * \brief Returns the number of the events dropped by the recorder
+     */
+    [[nodiscard]]
+    std::uint64_t dropped() const noexcept
+    {
+      return m_header.m_dropped;
+    }
+
+    /**
+     * \brief Returns the number of the recording threads
+     */
+    [[nodiscard]]
+    std::uint32_t threads() const noexcept
+    {
+      return m_header.m_threads;
+    }
+
+    /**
+     * \brief Returns the frequency of the timestamps of the events
+     */
+    [[nodiscard]]
+    std::uint64_t ticks_per_second() const noexcept
+    {
+      return m_header.m_ticksPerSecond;
+    }
+
+    /**
+     * \brief Reads the next event
+     * \param event the event read
+     * \return false at the end of the trace or if the trace is corrupted
+     */
+    bool next(test_resource_trace_event& event)
+    {
+      if (!m_valid || m_read == m_header.m_events)
+      {
+        return false;
+      }
+
+      const int code = m_file.rdbuf()->sbumpc();
+      std::uint64_t thread = 0U;
+      std::uint64_t timestamp = 0U;
+      std::uint64_t index = 0U;
+      std::uint64_t bytes = 0U;
+      std::uint64_t address = 0U;
+      std::uint64_t stack_id = 0U;
+      if (std::char_traits<char>::eof() == code ||
+          !read_varint(thread) || !read_varint(timestamp) || !read_varint(index) ||
+          !read_varint(bytes) || !read_varint(address) || !read_varint(stack_id))
+      {
+        m_valid = false;
+        return false;
+      }
+
+      m_timestamp += static_cast<std::uint64_t>(detail::unzigzag(timestamp));
+      m_index += detail::unzigzag(index);
+      m_address += static_cast<std::uint64_t>(detail::unzigzag(address));
+
+      event.m_operation = static_cast<trace_operation>(code & 1);
+      event.m_alignment = std::size_t{ 1U } << ((code >> 1) & 0x7F);
+      event.m_thread = static_cast<std::uint32_t>(thread);
+      event.m_timestamp = m_timestamp;
+      event.m_index = m_index;
+      event.m_bytes = static_cast<std::size_t>(bytes);
+      event.m_address = static_cast<std::uintptr_t>(m_address);
+      event.m_stackId = static_cast<std::uint32_t>(stack_id);
+      ++m_read;
+      return true;
+    }
+
+  private:
+    bool read_varint(std::uint64_t& value)
+    {
+      value = 0U;
+      for (unsigned shift = 0U; shift < 64U; shift += 7U)
+      {
+        const int code = m_file.rdbuf()->sbumpc();
+        if (std::char_traits<char>::eof() == code)
+        {
+          return false;
+        }
+        value |= static_cast<std::uint64_t>(code & 0x7F) << shift;
+        if (0 == (code & 0x80))
+        {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    std::ifstream m_file;
+    detail::trace_file_header m_header{};
+    bool m_valid = false;
+    std::uint64_t m_read = 0U;
+    std::uint64_t m_timestamp = 0U;
+    std::int64_t m_index = 0;
+    std::uint64_t m_address = 0U;
+  };
+
+  /**
+   * \brief Defines how the test_resource overwrites the deallocated memory
+   */
+  enum class scribble_mode
+  {
+    full,       // the whole block is scribbled (default)
+    off,        // the memory is left as is
+    edges,      // the first and the last N bytes of the block are scribbled
+    streaming   // the whole block is scribbled by the non-temporal stores
+  };
+
+  // policies of the basic_test_resource; every policy has its null counterpart
+  // which removes the feature from the allocation and deallocation paths
+
+  // the reporting and the list of allocated blocks are guarded by mutexes
+  struct mutex_lock_policy { static constexpr bool enabled = true; };
+  // no locking at all; the resource must not be shared by threads
+  struct null_lock_policy { static constexpr bool enabled = false; };
+
+  // the paddings around each allocated block are checked on deallocation
+  struct padding_guard_policy { static constexpr bool enabled = true; };
+  struct null_guard_policy { static constexpr bool enabled = false; };
+
+  // the deallocated memory is overwritten by the scribbled_memory_byte
+  struct scribble_policy { static constexpr bool enabled = true; };
+  struct null_scribble_policy { static constexpr bool enabled = false; };
+
+  // the outstanding blocks are kept in the list (reported as leaks by print/release)
+  struct list_tracking_policy { static constexpr bool enabled = true; };
+  struct null_tracking_policy { static constexpr bool enabled = false; };
+
+  // the statistics (blocks, bytes, errors) are counted
+  struct sharded_stats_policy { static constexpr bool enabled = true; };
+  struct null_stats_policy { static constexpr bool enabled = false; };
+
+  namespace detail
+  {
+    template<typename LockPolicy, typename GuardPolicy, typename ScribblePolicy, typename TrackingPolicy, typename StatsPolicy>
+    struct test_resource_policies
+    {
+      static constexpr bool locking = LockPolicy::enabled;
+      static constexpr bool guard = GuardPolicy::enabled;
+      static constexpr bool scribble = ScribblePolicy::enabled;
+      static constexpr bool tracking = TrackingPolicy::enabled;
+      static constexpr bool stats = StatsPolicy::enabled;
+      // the header is needed to check the paddings and to link the block into the list;
+      // without it the allocation is passed to the upstream resource as is
+      static constexpr bool header = guard || tracking;
+      // the diagnostics and the reporter are test_resource's, i.e. need every check
+      static constexpr bool diagnostics = locking && guard && scribble && tracking && stats;
+    };
+
+    // the state of the diagnostics of test_resource
+    struct test_resource_diagnostics
+    {
+      // the depth of the captured allocation call stacks (0 - off)
+      std::atomic_size_t m_callsiteDepth{ 0U };
+      std::atomic_size_t m_callsiteSkip{ 0U };
+
+      // set of the checked blocks if the allocations are sampled
+      sampled_blocks* m_sampledBlocks{ nullptr };
+      lifetime_profile* m_lifetimes{ nullptr };
+      latency_profile* m_latencies{ nullptr };
+      std::size_t m_samplingRate{ 0U };
+
+      // the blocks of at least this size are placed in front of a guard page
+      std::size_t m_guardPageThreshold{ 0U };
+      bool m_leadingGuardPage{ false };
+
+      // deallocated blocks held back from the upstream
+      quarantine* m_quarantine{ nullptr };
+    };
+
+    // the diagnostics of the other instantiations of basic_test_resource are off
+    // for good; the constants let the compiler drop their checks
+    struct null_test_resource_diagnostics
+    {
+      static constexpr sampled_blocks* m_sampledBlocks = nullptr;
+      static constexpr lifetime_profile* m_lifetimes = nullptr;
+      static constexpr latency_profile* m_latencies = nullptr;
+      static constexpr std::size_t m_samplingRate = 0U;
+      static constexpr std::size_t m_guardPageThreshold = 0U;
+      static constexpr bool m_leadingGuardPage = false;
+      static constexpr quarantine* m_quarantine = nullptr;
+    };
+
+    template<bool Diagnostics>
+    using test_resource_diagnostics_t =
+      std::conditional_t<Diagnostics, test_resource_diagnostics, null_test_resource_diagnostics>;
+
+    // the mutex of the disabled locking policy
+    struct null_mutex
+    {
+      void lock() noexcept
+      {
+      }
+
+      void unlock() noexcept
+      {
+      }
+    };
+
+    template<bool Locking>
+    using mutex_t = std::conditional_t<Locking, std::mutex, null_mutex>;
+  }
+
+  /**
+   * \brief The basic_test_resource is a thread‐safe, instrumented memory resource that
+   *        implements the standard std::pmr::memory_resource abstract interface
+   *        and can be used to track various aspects of memory allocated from it,
+   *        in addition to automatically detecting a number of memory management
+   *        violations that might otherwise go unnoticed. Its checks are selected
+   *        at compile time; a null policy removes its feature and its state
+   *        from the resource, so the cheaper instantiations can stay enabled
+   *        in the long running (e.g. integration or performance) tests.
+   * \tparam LockPolicy mutex_lock_policy or null_lock_policy (a single thread only)
+   * \tparam GuardPolicy padding_guard_policy or null_guard_policy
+   * \tparam ScribblePolicy scribble_policy or null_scribble_policy
+   * \tparam TrackingPolicy list_tracking_policy or null_tracking_policy
+   * \tparam StatsPolicy sharded_stats_policy or null_stats_policy
+   * \note Features:
+   *      - a thread‐safe implementation of the polymorphic memory resource interface
+   *      - the detection of memory leaks
+   *      - the detection of double releasing of memory
+   *      - detection of writing before or beyond the allocated memory area (boundary violation)
+   *      - overwriting memory just before deallocating it to help detect use of deleted memory
+   *      - tracking of memory use statistics (number of outstanding blocks and bytes)
+   *        that are currently in use, the cumulative number of blocks (and bytes) that have
+   *        been allocated, and the maximum number of blocks (and bytes) that have been in use
+   *        at any one time
+   *      - monitoring of memory use changes (via the test_resource_monitor type)
+   *      - temporary replacement of the default memory resource using the default_resource_guard
+   *      - testing (exception safety) behavior in case of memory allocation failure
+   *        (when the resource throws) using the test_allocation_failure algorithm
+   * \note The allocations and deallocations of different threads don't serialize
+   *       on the test_resource (only the reporting does), so the upstream
+   *       resource has to be thread-safe if the test_resource is shared by threads.
+   * \note The test_resource is the instantiation with every check enabled. Only it
+   *       has the diagnostics (the sampling, the guard pages, the quarantine, the call
+   *       sites, the lifetime and the latency profiles, the verbose mode) and is passed
+   *       to the reporter; the other instantiations report their errors and leaks
+   *       by test_resource_reporter::report_log_msg.
+   * \note Without both the guard and the tracking policy the memory blocks have
+   *       no header and the requests are passed to the upstream resource as is.
+   *       Without the tracking policy print() reports no outstanding blocks,
+   *       without the stats policy all the statistics stay zero.
+   */
+  template<typename LockPolicy, typename GuardPolicy, typename ScribblePolicy, typename TrackingPolicy, typename StatsPolicy>
+  class basic_test_resource final : public std::pmr::memory_resource
+  {
+    friend class test_resource_reporter;
+
+    using policies = detail::test_resource_policies<LockPolicy, GuardPolicy, ScribblePolicy, TrackingPolicy, StatsPolicy>;
+
+  public:
+    //constructors/destructors
+
+    basic_test_resource()
+      : basic_test_resource("", false, detail::local_memory::resource(), get_default_test_resource_reporter())
+    {}
+
+    explicit basic_test_resource(std::pmr::memory_resource* upstream)
+      : basic_test_resource("", false, upstream, get_default_test_resource_reporter())
+    {}
+
+    explicit basic_test_resource(const char* name)
+      : basic_test_resource(std::string_view(name))
+    {}
+
+    explicit basic_test_resource(std::string_view name)
+      : basic_test_resource(name, false, detail::local_memory::resource(), get_default_test_resource_reporter())
+    {}
+
+    explicit basic_test_resource(bool verbose, test_resource_reporter* reporter = get_default_test_resource_reporter())
+      : basic_test_resource("", verbose, detail::local_memory::resource(), reporter)
+    {}
+
+    basic_test_resource(std::string_view name, std::pmr::memory_resource* upstream)
+      : basic_test_resource(name, false, upstream, get_default_test_resource_reporter())
+    {}
+
+    basic_test_resource(const char* name, std::pmr::memory_resource* upstream)
+      : basic_test_resource(std::string_view(name), upstream)
+    {}
+
+    basic_test_resource(bool verbose, std::pmr::memory_resource* upstream, test_resource_reporter* reporter = get_default_test_resource_reporter())
+      : basic_test_resource("", verbose, upstream, reporter)
+    {}
+
+    basic_test_resource(std::string_view name, bool verbose, test_resource_reporter* reporter = get_default_test_resource_reporter())
+      : basic_test_resource(name, verbose, detail::local_memory::resource(), reporter)
+    {}
+
+    basic_test_resource(const char* name, bool verbose, test_resource_reporter* reporter = get_default_test_resource_reporter())
+      : basic_test_resource(std::string_view(name), verbose, reporter)
+    {}
+
+    basic_test_resource(std::string_view name, bool verbose, std::pmr::memory_resource* upstream, test_resource_reporter* reporter = get_default_test_resource_reporter())
+      : m_name(name)
+      , m_verboseFlag(verbose)
+      , m_reporter(reporter)
+      , m_upstream(upstream)
+    {
+      if constexpr (policies::stats)
+      {
+        //allocate and initialize the statistics
+        m_counters = new (m_upstream->allocate(
+          sizeof(detail::test_resource_counters),
+          alignof(detail::test_resource_counters))) detail::test_resource_counters{ m_name };
+      }
+
+      if constexpr (policies::tracking)
+      {
+        //allocate and initialize the empty list of memory blocks
+        m_list = new (m_upstream->allocate(
+          sizeof(detail::test_resource_list),
+          alignof(detail::test_resource_list))) detail::test_resource_list{};
+      }
+    }
+
+    basic_test_resource(const char* name, bool verbose, std::pmr::memory_resource* upstream, test_resource_reporter* reporter = get_default_test_resource_reporter())
+      : basic_test_resource(std::string_view(name), verbose, upstream, reporter)
+    {}
+
+    ~basic_test_resource() noexcept override
+    {
+      release();
+      if constexpr (policies::diagnostics)
+      {
+        set_sampling_rate(0U);
+        set_lifetime_profiling(false);
+        set_latency_profiling(false);
+        set_quarantine(0U, 0U);
+      }
+
+      if constexpr (policies::stats)
+      {
+        m_counters->~test_resource_counters();
+        m_upstream->deallocate(m_counters,
+          sizeof(detail::test_resource_counters),
+          alignof(detail::test_resource_counters));
+      }
+    }
+
+    basic_test_resource(const basic_test_resource&) = delete;
+    basic_test_resource& operator=(const basic_test_resource&) = delete;
+
+    /**
+     * \brief Allocates 'count' memory blocks of the same size and alignment
+     * \param blocks the array receiving the addresses of the memory blocks
+     * \param count the number of memory blocks
+     * \param bytes the size of every memory block
+     * \param alignment the alignment of every memory block
+     * \throw std::bad_alloc if any of the memory blocks can't be allocated,
+     *        in which case none of them stays allocated
+     * \note Every block is checked as if it were allocated by allocate(), but
+     *       the statistics are updated once and the blocks are added to the list
+     *       of the allocated blocks taking the lock of every stripe once.
+     *       With the sampling, the verbose mode, the allocation limit or
+     *       the guard pages the blocks are allocated one by one.
+     */
+    void allocate_bulk(void** blocks, std::size_t count, std::size_t bytes, std::size_t alignment = detail::max_natural_alignment)
+    {
+      allocate_bulk_with(blocks, count, bytes, alignment);
+    }
+
+    /**
+     * \brief Deallocates 'count' memory blocks of the same size and alignment
+     * \param blocks the array of the addresses of the memory blocks
+     * \param count the number of memory blocks
+     * \param bytes the size of every memory block
+     * \param alignment the alignment of every memory block
+     * \note All the blocks are checked first; if any of them is invalid, the blocks
+     *       are deallocated one by one, so the error is counted and reported as by
+     *       deallocate(). The quarantine also deallocates the blocks one by one.
+     */
+    void deallocate_bulk(void* const* blocks, std::size_t count, std::size_t bytes, std::size_t alignment = detail::max_natural_alignment)
+    {
+      deallocate_bulk_with(blocks, count, bytes, alignment);
+    }
+
+    /**
+     * \brief Sets the allocation limit to the supplied limit.
+     * \param limit supplied allocation limit
+     * \note Any negative value for limit means there is no allocation
+     *       limit imposed by this test memory resource.
+     */
+    void set_allocation_limit(long long limit) noexcept
+    {
+      m_allocationLimit.store(limit, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Sets the no‐abort behavior.
+     * \param is_no_abort new value of no‐abort flag
+     * \note If flag is true, do not abort the program upon detecting errors.
+     *       The default value of the setting is false.
+     */
+    void set_no_abort(bool is_no_abort) noexcept
+    {
+      m_noAbortFlag.store(is_no_abort, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Sets the quiet behavior.
+     * \param is_quiet new value of quiet flag
+     * \note  If flag is true, do not report detected errors and imply is_no_abort() ==
+     *        true.  The default value of the setting is false.
+     */
+    void set_quiet(bool is_quiet) noexcept
+    {
+      m_quietFlag.store(is_quiet, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Sets the verbose behavior.
+     * \param is_verbose new value of verbose flag
+     * \note If flag is true, report all allocations and deallocations to the standard output.
+     *       The default value of the setting is false or what is specified in the constructor.
+     *       Only the test_resource reports them.
+     */
+    void set_verbose(bool is_verbose) noexcept
+    {
+      m_verboseFlag.store(is_verbose, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Sets the sampling of the allocations.
+     * \param rate the mean number of allocations per one checked allocation;
+     *        0 and 1 mean that every allocation is checked
+     * \note Only the sampled allocations get the header, the guard paddings
+     *       and the tracking. The other allocations are passed to the upstream
+     *       resource as they are and only the statistics are counted for them.
+     *       The default value of the setting is 0.
+     * \note The behavior is undefined unless the resource has no outstanding
+     *       blocks and is not used by another thread.
+     */
+    void set_sampling_rate(std::size_t rate)
+    {
+      static_assert(policies::diagnostics, "the sampling is a diagnostic of test_resource");
+      if (rate > 1U && !m_diagnostics.m_sampledBlocks)
+      {
+        m_diagnostics.m_sampledBlocks = new (m_upstream->allocate(
+          sizeof(detail::sampled_blocks),
+          alignof(detail::sampled_blocks))) detail::sampled_blocks{};
+      }
+      else if (rate <= 1U && m_diagnostics.m_sampledBlocks)
+      {
+        m_diagnostics.m_sampledBlocks->~sampled_blocks();
+        m_upstream->deallocate(m_diagnostics.m_sampledBlocks,
+          sizeof(detail::sampled_blocks),
+          alignof(detail::sampled_blocks));
+        m_diagnostics.m_sampledBlocks = nullptr;
+      }
+      if (m_diagnostics.m_sampledBlocks)
+      {
+        m_diagnostics.m_sampledBlocks->reset(rate);
+      }
+      m_diagnostics.m_samplingRate = rate > 1U ? rate : 0U;
+    }
+
+    /**
+     * \brief Places the blocks of at least 'threshold' bytes in their own memory
+     *        mappings with the user segment ending at an inaccessible guard page,
+     *        so an overrun faults immediately at the offending instruction.
+     * \param threshold the minimal size of a guarded block; 0 turns the guard pages off
+     * \param leading_guard if true, the page in front of the header is a guard page too
+     * \note The guarded blocks are mapped directly (mmap), not allocated from the
+     *       upstream resource. The overrun into the alignment slack between the user
+     *       segment and the guard page is still detected on deallocation.
+     * \note The guard pages are supported on Linux only; elsewhere the setting is ignored.
+     * \note The behavior is undefined unless the resource has no outstanding
+     *       blocks and is not used by another thread.
+     */
+    void set_guard_pages([[maybe_unused]] std::size_t threshold, [[maybe_unused]] bool leading_guard = false) noexcept
+    {
+      static_assert(policies::diagnostics, "the guard pages are a diagnostic of test_resource");
+#if defined(__linux__)
+      m_diagnostics.m_guardPageThreshold = threshold;
+      m_diagnostics.m_leadingGuardPage = leading_guard;
+#endif
+    }
+
+    /**
+     * \brief Sets the quarantine of the deallocated memory blocks.
+     * \param max_bytes the maximal number of quarantined bytes per thread shard
+     * \param max_blocks the maximal number of quarantined blocks per thread shard;
+     *        0 turns the quarantine off
+     * \note The scribbled blocks are held back from the upstream resource in the
+     *       FIFO of the deallocating thread. When a block leaves the quarantine,
+     *       its scribble is verified and a write after free is reported via
+     *       test_resource_reporter::report_write_after_free. The release()
+     *       empties the quarantine.
+     * \note The behavior is undefined unless the resource has no outstanding
+     *       blocks and is not used by another thread.
+     */
+    void set_quarantine(std::size_t max_bytes, std::size_t max_blocks)
+    {
+      static_assert(policies::diagnostics, "the quarantine is a diagnostic of test_resource");
+      if (m_diagnostics.m_quarantine)
+      {
+        detail::block_list evicted{};
+        m_diagnostics.m_quarantine->drain(evicted);
+        release_quarantined<true>(evicted);
+
+        m_diagnostics.m_quarantine->~quarantine();
+        m_upstream->deallocate(m_diagnostics.m_quarantine,
+          sizeof(detail::quarantine),
+          alignof(detail::quarantine));
+        m_diagnostics.m_quarantine = nullptr;
+      }
+
+      if (0U != max_blocks)
+      {
+        m_diagnostics.m_quarantine = new (m_upstream->allocate(
+          sizeof(detail::quarantine),
+          alignof(detail::quarantine))) detail::quarantine{ max_bytes, max_blocks };
+      }
+    }
+
+    /**
+     * \brief Sets how the deallocated memory is overwritten.
+     * \param mode new scribble mode
+     * \param edge_size the number of bytes scribbled at each end of the block
+     *        in the scribble_mode::edges mode
+     * \note The default mode is scribble_mode::full. The cheaper modes keep
+     *       the deallocation of large blocks fast at the cost of a weaker
+     *       detection of the use of deleted memory.
+     */
+    void set_scribble(scribble_mode mode, std::size_t edge_size = 0U) noexcept
+    {
+      m_scribbleEdgeSize.store(edge_size, std::memory_order_relaxed);
+      m_scribbleMode.store(mode, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Sets the capture of the call stacks of the allocations
+     * \param depth the number of the frames to keep (at most detail::max_callsite_depth),
+     *        0 turns the capture off
+     * \param skip the number of the innermost frames to omit (at most detail::max_callsite_depth),
+     *        e.g. the frames of test_resource itself or of an allocator wrapping it
+     * \note The default depth is 0. Every distinct stack is stored once in the process wide
+     *       table and the header of an allocation holds just its id, so print() and the leak
+     *       report group the outstanding blocks by their call stacks.
+     * \note The capture costs an unwinding of depth + skip frames per allocation;
+     *       only the checked (e.g. sampled) allocations are captured.
+     */
+    void set_callsite_capture(std::size_t depth, std::size_t skip = 0U) noexcept
+    {
+      static_assert(policies::diagnostics, "the call sites are a diagnostic of test_resource");
+      m_diagnostics.m_callsiteSkip.store((std::min)(skip, detail::max_callsite_depth), std::memory_order_relaxed);
+      m_diagnostics.m_callsiteDepth.store((std::min)(depth, detail::max_callsite_depth), std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the depth of the captured allocation call stacks
+     * \return the number of the captured frames or 0 if the capture is off
+     */
+    [[nodiscard]]
+    std::size_t callsite_depth() const noexcept
+    {
+      if constexpr (policies::diagnostics)
+      {
+        return m_diagnostics.m_callsiteDepth.load(std::memory_order_relaxed);
+      }
+      else
+      {
+        return 0U;
+      }
+    }
+
+    /**
+     * \brief Sets the profiling of the lifetimes of the allocated blocks
+     * \param enabled if true, the lifetime of every checked block is counted
+     *        on its deallocation by its size class and by its call site
+     * \note The call sites are known only with set_callsite_capture().
+     *       The default value of the setting is false.
+     * \note The behavior is undefined unless the resource is not used by another thread.
+     */
+    void set_lifetime_profiling(bool enabled)
+    {
+      static_assert(policies::diagnostics, "the lifetime profile is a diagnostic of test_resource");
+      if (enabled && !m_diagnostics.m_lifetimes)
+      {
+        m_diagnostics.m_lifetimes = new (m_upstream->allocate(
+          sizeof(detail::lifetime_profile),
+          alignof(detail::lifetime_profile))) detail::lifetime_profile{};
+      }
+      else if (!enabled && m_diagnostics.m_lifetimes)
+      {
+        m_diagnostics.m_lifetimes->~lifetime_profile();
+        m_upstream->deallocate(m_diagnostics.m_lifetimes,
+          sizeof(detail::lifetime_profile),
+          alignof(detail::lifetime_profile));
+        m_diagnostics.m_lifetimes = nullptr;
+      }
+    }
+
+    /**
+     * \brief Checks the profiling of the lifetimes
+     * \return true if the lifetimes are profiled
+     */
+    [[nodiscard]]
+    bool is_lifetime_profiling() const noexcept
+    {
+      return nullptr != m_diagnostics.m_lifetimes;
+    }
+
+    /**
+     * \brief Sets the profiling of the latencies of the allocations and the deallocations
+     * \param enabled if true, the duration of every allocate() and deallocate() is counted
+     *        along with the time it has waited for the locks and spent in the upstream resource
+     * \note The profiling costs four clock reads per operation, plus two per contended lock.
+     *       The bulk requests are not measured. The default value of the setting is false.
+     * \note The behavior is undefined unless the resource is not used by another thread.
+     */
+    void set_latency_profiling(bool enabled)
+    {
+      static_assert(policies::diagnostics, "the latency profile is a diagnostic of test_resource");
+      if (enabled && !m_diagnostics.m_latencies)
+      {
+        m_diagnostics.m_latencies = new (m_upstream->allocate(
+          sizeof(detail::latency_profile),
+          alignof(detail::latency_profile))) detail::latency_profile{};
+      }
+      else if (!enabled && m_diagnostics.m_latencies)
+      {
+        m_diagnostics.m_latencies->~latency_profile();
+        m_upstream->deallocate(m_diagnostics.m_latencies,
+          sizeof(detail::latency_profile),
+          alignof(detail::latency_profile));
+        m_diagnostics.m_latencies = nullptr;
+      }
+    }
+
+    /**
+     * \brief Checks the profiling of the latencies
+     * \return true if the latencies are profiled
+     */
+    [[nodiscard]]
+    bool is_latency_profiling() const noexcept
+    {
+      return nullptr != m_diagnostics.m_latencies;
+    }
+
+    /**
+     * \brief Attaches the recorder of the allocation trace
+     * \param recorder the recorder of every successful allocation and deallocation,
+     *        or nullptr to stop the recording; it must outlive its attachment
+     * \note Unlike the verbose mode, the recording neither formats the events nor takes
+     *       the lock: an event costs a time stamp and a store into the ring of the thread.
+     *       The deallocations of the blocks without the header have the index -1.
+     * \note The behavior is undefined unless the resource is not used by another thread.
+     */
+    void set_trace_recorder(test_resource_trace_recorder* recorder) noexcept
+    {
+      m_trace = recorder;
+    }
+
+    /**
+     * \brief Returns the attached recorder of the allocation trace
+     * \return the recorder or nullptr
+     */
+    [[nodiscard]]
+    test_resource_trace_recorder* trace_recorder() const noexcept
+    {
+      return m_trace;
+    }
+
+    /**
+     * \brief Returns the number of allocation requests permitted before throwing
+     *        test_resource_exception or a negative value if this test memory resource
+     *        does not impose a limit on the number of allocations
+     * \return number of allowed allocation requests
+     * \note This value will decrement with every call to do_allocate.
+     */
+    [[nodiscard]]
+    long long allocation_limit() const noexcept
+    {
+      return m_allocationLimit.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the current no‐abort flag
+     * \return the current no‐abort flag
+     */
+    [[nodiscard]]
+    bool is_no_abort() const noexcept
+    {
+      return m_noAbortFlag.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the current quiet flag
+     * \return the current quiet flag
+     */
+    [[nodiscard]]
+    bool is_quiet() const noexcept
+    {
+      return m_quietFlag.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the current verbosity flag
+     * \return the current verbosity flag
+     */
+    [[nodiscard]]
+    bool is_verbose() const noexcept
+    {
+      return m_verboseFlag.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the current sampling rate
+     * \return the mean number of allocations per one checked allocation
+     *         or 0 if every allocation is checked
+     */
+    [[nodiscard]]
+    std::size_t sampling_rate() const noexcept
+    {
+      return m_diagnostics.m_samplingRate;
+    }
+
+    /**
+     * \brief Returns the minimal size of the block guarded by the guard page
+     * \return the minimal size of the guarded block or 0 if the guard pages are off
+     */
+    [[nodiscard]]
+    std::size_t guard_page_threshold() const noexcept
+    {
+      return m_diagnostics.m_guardPageThreshold;
+    }
+
+    /**
+     * \brief Returns the current scribble mode
+     * \return the current scribble mode
+     */
+    [[nodiscard]]
+    scribble_mode scribble() const noexcept
+    {
+      return m_scribbleMode.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the number of bytes scribbled at each end of the block
+     *        in the scribble_mode::edges mode
+     * \return the scribbled edge size
+     */
+    [[nodiscard]]
+    std::size_t scribble_edge_size() const noexcept
+    {
+      return m_scribbleEdgeSize.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the name supplied to this test_resource at construction
+     * \return the name of this test_resource
+     */
+    [[nodiscard]]
+    std::string_view name() const noexcept
+    {
+      return m_name;
+    }
+
+    /**
+     * \brief Returns the pointer to the upstream memory_resource supplied
+     *        to this test_resource at construction
+     * \return pointer to the upstream memory_resource
+     */
+    [[nodiscard]]
+    std::pmr::memory_resource* upstream_resource() const noexcept
+    {
+      return m_upstream;
+    }
+
+    /**
+     * \brief Returns the pointer to the last memory block successfully
+     *        allocated by this test_resource
+     * \return pointer to the last allocated memory block
+     */
+    [[nodiscard]]
+    void* last_allocated_address() const noexcept
+    {
+      return m_lastAllocatedAddress.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the requested number of bytes of the last memory
+     *        block successfully allocated by this test_resource
+     * \return requested number of bytes of the last memory block
+     */
+    [[nodiscard]]
+    std::size_t last_allocated_bytes() const noexcept
+    {
+      return m_lastAllocatedNumBytes.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the requested alignment of the last memory block
+     *        successfully allocated by this test_resource
+     * \return the requested alignment of the last memory block
+     */
+    [[nodiscard]]
+    std::size_t last_allocated_alignment() const noexcept
+    {
+      return m_lastAllocatedAlignment.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the pointer to the last memory block successfully
+     *        deallocated by this test_resource
+     * \return pointer to the last deallocated memory block
+     */
+    [[nodiscard]]
+    void* last_deallocated_address() const noexcept
+    {
+      return m_lastDeallocatedAddress.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the requested number of bytes of the last memory block
+     *        successfully deallocated by this test_resource
+     * \return number of bytes of the last requested memory block
+     */
+    [[nodiscard]]
+    std::size_t last_deallocated_bytes() const noexcept
+    {
+      return m_lastDeallocatedNumBytes.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the requested alignment of the last memory block successfully
+     *        deallocated by this test_resource
+     * \return the requested alignment of the last deallocated memory block
+     */
+    [[nodiscard]]
+    std::size_t last_deallocated_alignment() const noexcept
+    {
+      return m_lastDeallocatedAlignment.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Returns the total number of allocations requested from this test_resource
+     * \return total number of allocations
+     * \note This number includes failed allocations too.
+     */
+    [[nodiscard]]
+    long long allocations() const noexcept
+    {
+      return usage_counter(&detail::usage_counters::m_allocations);
+    }
+
+    /**
+     * \brief Returns the number of total deallocations requested from this test_resource
+     * \return total number of deallocations
+     * \note This number includes failed deallocations too.
+     */
+    [[nodiscard]]
+    long long deallocations() const noexcept
+    {
+      return sum_shards(&detail::stats_shard::m_deallocations);
+    }
+
+    /**
+     * \brief Returns the number of memory blocks still allocated by this test_resource
+     * \return the number of still used memory blocks
+     */
+    [[nodiscard]]
+    long long blocks_in_use() const noexcept
+    {
+      return sum_shards(&detail::stats_shard::m_blocksInUse);
+    }
+
+    /**
+     * \brief Returns the largest number of memory blocks allocated at
+     *        any given time by this test_resource
+     * \return the largest number of allocated memory blocks
+     * \note The value is exact unless several threads allocate and deallocate
+     *       concurrently, see detail::test_resource_counters::add_in_use().
+     */
+    [[nodiscard]]
+    long long max_blocks() const noexcept
+    {
+      return usage_counter(&detail::usage_counters::m_maxBlocks);
+    }
+
+    /**
+     * \brief Returns the total number of memory blocks ever
+     *        successfully allocated by this test_resource
+     * \return total number of successfully allocated memory blocks
+     */
+    [[nodiscard]]
+    long long total_blocks() const noexcept
+    {
+      return sum_shards(&detail::stats_shard::m_totalBlocks);
+    }
+
+    /**
+     * \brief Returns the number of buffer overruns and underruns detected
+     *        by this test_resource.
+     * \return the number of buffer overruns and underruns
+     */
+    [[nodiscard]]
+    long long bounds_errors() const noexcept
+    {
+      return sum_shards(&detail::stats_shard::m_boundsErrors);
+    }
+
+    /**
+     * \brief Returns the number of mismatched deallocation size and
+     *        alignment parameters detected by this test_resource
+     * \return the number of mismatched deallocation size and
+     *         alignment parameters
+     */
+    [[nodiscard]]
+    long long bad_deallocate_params() const noexcept
+    {
+      return sum_shards(&detail::stats_shard::m_badDeallocateParams);
+    }
+
+    /**
+     * \brief Returns the number of quarantined memory blocks written
+     *        after their deallocation detected by this test_resource
+     * \return the number of writes after free
+     */
+    [[nodiscard]]
+    long long writes_after_free() const noexcept
+    {
+      return sum_shards(&detail::stats_shard::m_writesAfterFree);
+    }
+
+    /**
+     * \brief Returns the number of mismatched deallocations detected by
+     *       this test_resource
+     * \return the number of mismatched deallocations
+     * \note Mismatched deallocations are deallocation attempts of memory
+     *       blocks not obtained from this test_resource.
+     */
+    [[nodiscard]]
+    long long mismatches() const noexcept
+    {
+      return sum_shards(&detail::stats_shard::m_mismatches);
+    }
+
+    /**
+     * \brief Returns the number of bytes currently allocated by this test_resource
+     * \return the number of bytes currently allocated
+     */
+    [[nodiscard]]
+    long long bytes_in_use() const noexcept
+    {
+      return sum_shards(&detail::stats_shard::m_bytesInUse);
+    }
+
+    /**
+     * \brief Returns the largest number of bytes allocated at
+     *        any given time by this test_resource
+     * \return the largest number of allocated bytes
+     * \note The value is exact unless several threads allocate and deallocate
+     *       concurrently, see detail::test_resource_counters::add_in_use().
+     */
+    [[nodiscard]]
+    long long max_bytes() const noexcept
+    {
+      return usage_counter(&detail::usage_counters::m_maxBytes);
+    }
+
+    /**
+     * \brief Returns the total number of bytes ever successfully
+     *        allocated by this test_resource
+     * \return total number of successfully allocated bytes
+     */
+    [[nodiscard]]
+    long long total_bytes() const noexcept
+    {
+      return sum_shards(&detail::stats_shard::m_totalBytes);
+    }
+
+    /**
+     * \brief Returns the reporter assigned to the test_resource
+     * \return total number of successfully allocated bytes
+     */
+    [[nodiscard]]
+    test_resource_reporter* reporter() const noexcept
+    {
+      return m_reporter;
+    }
+
+    /**
+     * \brief Reads all the statistics consistently without taking the lock
+     * \return the statistics of this test_resource
+     * \note The individual accessors may observe a half-done update of the other
+     *       counters; the snapshot reads every statistics shard while it is not
+     *       being updated, so it counts every completed allocation and deallocation
+     *       of the shard as a whole. The reader only retries, it never holds off
+     *       the allocating threads, so it can be polled from a monitoring thread
+     *       at a high frequency.
+     * \note The allocation count, the high-water marks and the last allocation and
+     *       deallocation are not kept in the shards and are read with relaxed loads.
+     */
+    [[nodiscard]]
+    test_resource_stats snapshot() const noexcept
+    {
+      test_resource_stats stats{};
+      if constexpr (policies::stats)
+      {
+        const detail::stats_shard_values values = m_counters->read_consistent();
+        const auto& usage = m_counters->m_usage;
+
+        stats.m_allocations = usage.m_allocations.load(std::memory_order_relaxed);
+        stats.m_deallocations = values.m_deallocations;
+        stats.m_blocksInUse = values.m_blocksInUse;
+        stats.m_maxBlocks = usage.m_maxBlocks.load(std::memory_order_relaxed);
+        stats.m_totalBlocks = values.m_totalBlocks;
+        stats.m_bytesInUse = values.m_bytesInUse;
+        stats.m_maxBytes = usage.m_maxBytes.load(std::memory_order_relaxed);
+        stats.m_totalBytes = values.m_totalBytes;
+        stats.m_mismatches = values.m_mismatches;
+        stats.m_boundsErrors = values.m_boundsErrors;
+        stats.m_badDeallocateParams = values.m_badDeallocateParams;
+        stats.m_writesAfterFree = values.m_writesAfterFree;
+      }
+
+      stats.m_lastAllocatedAddress = last_allocated_address();
+      stats.m_lastAllocatedBytes = last_allocated_bytes();
+      stats.m_lastAllocatedAlignment = last_allocated_alignment();
+      stats.m_lastDeallocatedAddress = last_deallocated_address();
+      stats.m_lastDeallocatedBytes = last_deallocated_bytes();
+      stats.m_lastDeallocatedAlignment = last_deallocated_alignment();
+      return stats;
+    }
+
+    /**
+     * \brief Returns the histograms of the sizes and the alignments of the successful allocations
+     * \return the histograms of this test_resource
+     * \note The buckets are read one by one with relaxed loads, the concurrent allocations
+     *       may be counted in some of them only; the sum of the buckets of either histogram
+     *       is total_blocks() if no allocation is in progress.
+     */
+    [[nodiscard]]
+    test_resource_histograms histograms() const noexcept
+    {
+      test_resource_histograms result{};
+      if constexpr (policies::stats)
+      {
+        for (const auto& shard : m_counters->m_histograms)
+        {
+          for (std::size_t i = 0U; i < result.m_sizes.size(); ++i)
+          {
+            result.m_sizes[i] += shard.m_object.m_sizes[i].load(std::memory_order_relaxed);
+          }
+          for (std::size_t i = 0U; i < result.m_alignments.size(); ++i)
+          {
+            result.m_alignments[i] += shard.m_object.m_alignments[i].load(std::memory_order_relaxed);
+          }
+        }
+      }
+      return result;
+    }
+
+    /**
+     * \brief Returns the percentiles of the latencies of the allocations and the deallocations
+     * \return the latencies; zeros unless the latencies are profiled
+     * \note The bookkeeping is the time of the operation neither waiting for the locks
+     *       nor spent in the upstream resource, i.e. the overhead of the resource itself.
+     */
+    [[nodiscard]]
+    test_resource_latencies latencies() const noexcept
+    {
+      test_resource_latencies result{};
+      if (m_diagnostics.m_latencies)
+      {
+        const auto read = [this](std::size_t operation) noexcept {
+          return test_resource_latencies::operation{
+            m_diagnostics.m_latencies->percentiles(operation, detail::lock_wait_phase),
+            m_diagnostics.m_latencies->percentiles(operation, detail::bookkeeping_phase),
+            m_diagnostics.m_latencies->percentiles(operation, detail::upstream_phase),
+            m_diagnostics.m_latencies->percentiles(operation, detail::total_phase) };
+        };
+        result.m_allocations = read(detail::allocation_operation);
+        result.m_deallocations = read(detail::deallocation_operation);
+      }
+      return result;
+    }
+
+    /**
+     * \brief Returns the groups of the outstanding blocks of the same size and call site
+     *        holding the most bytes
+     * \param count the maximal number of the returned groups
+     * \return the groups, the most bytes first
+     */
+    [[nodiscard]]
+    std::vector<test_resource_block_group> top_blocks(std::size_t count) const
+    {
+      static_assert(policies::diagnostics, "the block groups are a diagnostic of test_resource");
+      // the blocks are many, the distinct sizes and call sites usually few
+      struct key_hash
+      {
+        std::size_t operator()(const std::pair<std::uint32_t, std::size_t>& key) const noexcept
+        {
+          return std::hash<std::size_t>{}(key.second * 0x9E3779B97F4A7C15ULL + key.first);
+        }
+      };
+      std::unordered_map<std::pair<std::uint32_t, std::size_t>, std::size_t, key_hash> indices;
+      std::vector<test_resource_block_group> groups;
+      m_list->for_each([&indices, &groups](const detail::block_info& info) {
+        const auto [it, inserted] = indices.try_emplace({ info.m_stackId, info.m_bytes }, groups.size());
+        if (inserted)
+        {
+          groups.push_back({ info.m_stackId, info.m_bytes, 0LL, 0U });
+        }
+        ++groups[it->second].m_blocks;
+        groups[it->second].m_bytes += info.m_bytes;
+      });
+
+      const auto last = groups.begin() + static_cast<std::ptrdiff_t>((std::min)(count, groups.size()));
+      std::partial_sort(groups.begin(), last, groups.end(), [](const auto& lhs, const auto& rhs) noexcept {
+        return lhs.m_bytes > rhs.m_bytes;
+      });
+      groups.erase(last, groups.end());
+      return groups;
+    }
+
+    /**
+     * \brief Writes the index, the size, the alignment, the address and the call site
+     *        of every outstanding block to 'os', then the top_blocks() and the frames
+     *        of the call sites of the blocks
+     * \param os the output stream
+     * \param top the number of the largest groups of the blocks of the summary
+     * \note The lines are formatted into a preallocated buffer written to 'os' when full;
+     *       the stripes of the list of the blocks are locked one after another.
+     */
+    void dump_blocks(std::ostream& os, std::size_t top = 10U) const
+    {
+      static_assert(policies::diagnostics, "the block dump is a diagnostic of test_resource");
+      std::vector<bool> stack_ids(detail::callsite_capacity + 1U);
+      {
+        detail::report_buffer out{ os };
+        out << "OUTSTANDING MEMORY BLOCKS";
+        if (!m_name.empty())
+        {
+          out << " OF " << m_name;
+        }
+        out << "\n               Index                Bytes  Alignment  Call Site  Address\n";
+
+        m_list->for_each([&out, &stack_ids](const detail::block_info& info) {
+          out << detail::number(info.m_index, 20U) << detail::number(info.m_bytes, 21U)
+            << detail::number(info.m_alignment, 11U);
+          detail::write_stack_id(out, info.m_stackId);
+          out << "  " << detail::report_address{ info.m_address } << '\n';
+          stack_ids[info.m_stackId] = true;
+        });
+
+        out << "TOP " << top << " BY BYTES"
+          "\n               Bytes               Blocks                 Size  Call Site\n";
+        for (const auto& group : top_blocks(top))
+        {
+          out << detail::number(group.m_bytes, 20U) << detail::number(group.m_blocks, 21U)
+            << detail::number(group.m_size, 21U);
+          detail::write_stack_id(out, group.m_stackId);
+          out << '\n';
+        }
+
+        for (std::uint32_t id = 1U; id < stack_ids.size(); ++id)
+        {
+          if (const auto* site = stack_ids[id] ? detail::callsites().find(id) : nullptr)
+          {
+            out << "CALL SITE " << id << ":\n";
+            detail::write_frames(out, *site);
+          }
+        }
+      }
+      os.flush();
+    }
+
+    /**
+     * \brief Returns the lifetimes of the deallocated blocks with the arena candidates:
+     *        the call sites ranked by the bytes of their short lived blocks
+     * \param short_lifetime the number of the intervening allocations (rounded up to
+     *        a power of two) the short lived block is deallocated within
+     * \return the lifetimes; empty unless the lifetimes are profiled
+     * \note The buckets are read one by one with relaxed loads.
+     */
+    [[nodiscard]]
+    test_resource_lifetimes lifetimes(std::size_t short_lifetime = detail::default_short_lifetime) const
+    {
+      test_resource_lifetimes result{};
+      if (!m_diagnostics.m_lifetimes)
+      {
+        return result;
+      }
+
+      const auto copy = [](const detail::lifetime_histogram& from, test_resource_lifetimes::histogram& to) noexcept {
+        for (std::size_t i = 0U; i < test_resource_lifetimes::bucket_count; ++i)
+        {
+          to.m_nanoseconds[i] = from.m_nanoseconds[i].load(std::memory_order_relaxed);
+          to.m_allocations[i] = from.m_allocations[i].load(std::memory_order_relaxed);
+          to.m_bytes[i] = from.m_bytes[i].load(std::memory_order_relaxed);
+        }
+      };
+
+      for (std::size_t i = 0U; i < result.m_sizeClasses.size(); ++i)
+      {
+        copy(m_diagnostics.m_lifetimes->size_class(i), result.m_sizeClasses[i]);
+      }
+
+      for (std::size_t i = 0U; i < detail::lifetime_site_capacity; ++i)
+      {
+        const auto& from = m_diagnostics.m_lifetimes->site(i);
+        if (const std::uint32_t key = from.m_key.load(std::memory_order_relaxed); 0U != key)
+        {
+          auto& site = result.m_sites.emplace_back();
+          site.m_stackId = key - 1U;
+          copy(from.m_lifetimes, site.m_lifetimes);
+          for (std::size_t j = 0U; j < test_resource_lifetimes::bucket_count; ++j)
+          {
+            site.m_blocks += site.m_lifetimes.m_allocations[j];
+            site.m_bytes += site.m_lifetimes.m_bytes[j];
+            if (test_resource_lifetimes::bucket_min(j) < short_lifetime)
+            {
+              site.m_shortLivedBytes += site.m_lifetimes.m_bytes[j];
+            }
+          }
+        }
+      }
+
+      std::sort(result.m_sites.begin(), result.m_sites.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.m_shortLivedBytes != rhs.m_shortLivedBytes ?
+          lhs.m_shortLivedBytes > rhs.m_shortLivedBytes : lhs.m_bytes > rhs.m_bytes;
+      });
+      return result;
+    }
+
+    /**
+     * \brief Detects an error
+     * \return false if mismatches(), bounds_errors(), bad_deallocate_params()
+     *         and writes_after_free() all return zero and true otherwise
+     */
+    [[nodiscard]]
+    bool has_errors() const noexcept
+    {
+      return snapshot().has_errors();
+    }
+
+    /**
+     * \brief Detects any allocation
+     * \return true if blocks_in_use() or bytes_in_use() are greater than zero and false otherwise
+     * \note if either is non‐zero both are non‐zero
+     */
+    [[nodiscard]]
+    bool has_allocations() const noexcept
+    {
+      return snapshot().has_allocations();
+    }
+
+    /**
+     * \brief Get the status of test_resource
+     * \return 0 - if this test_resource has detected no errors and
+     *             it does not currently have any active allocations
+     *             (no memory leaks).
+     *         The number of detected errors if there are any.
+     *         ‐1 - if there are active allocations (but no errors).
+     */
+    [[nodiscard]]
+    long long status() const noexcept
+    {
+      return snapshot().status();
+    }
+
+    void print() const
+    {
+      std::lock_guard guard{ m_lock };
+      if constexpr (policies::diagnostics)
+      {
+        m_reporter->report_print(*this);
+      }
+      else
+      {
+        const auto stats = snapshot();
+        m_reporter->report_log_msg("test_resource%s%.*s: %lld blocks (%lld bytes) in use, %lld blocks (%lld bytes) in total.\n",
+          m_name.empty() ? "" : " ",
+          static_cast<int>(m_name.length()),
+          m_name.data(),
+          stats.m_blocksInUse,
+          stats.m_bytesInUse,
+          stats.m_totalBlocks,
+          stats.m_totalBytes);
+      }
+    }
+
+    void release() noexcept
+    {
+      if constexpr (policies::diagnostics)
+      {
+        if (m_diagnostics.m_quarantine)
+        {
+          // the quarantined blocks are verified before they are given back
+          detail::block_list evicted{};
+          m_diagnostics.m_quarantine->drain(evicted);
+          release_quarantined<true>(evicted);
+        }
+      }
+
+      std::lock_guard guard{ m_lock };
+
+      if constexpr (policies::diagnostics)
+      {
+        if (is_verbose())
+        {
+          m_reporter->report_print(*this);
+        }
+
+        // the leak report reads the call sites of the outstanding blocks
+        if (!is_quiet())
+        {
+          m_reporter->report_release(*this);
+        }
+      }
+      else
+      {
+        if (const auto stats = snapshot(); stats.has_allocations() && !is_quiet())
+        {
+          m_reporter->report_log_msg("MEMORY_LEAK%s%.*s:\n   Number of blocks in use = %lld\n   Number of bytes in use = %lld\n",
+            m_name.empty() ? "" : " from ",
+            static_cast<int>(m_name.length()),
+            m_name.data(),
+            stats.m_blocksInUse,
+            stats.m_bytesInUse);
+
+          if (!is_no_abort())
+          {
+            std::abort();
+          }
+        }
+      }
+
+      if constexpr (policies::tracking)
+      {
+        m_list->clear();
+        m_list->~test_resource_list();
+        m_upstream->deallocate(m_list,
+          sizeof(detail::test_resource_list),
+          alignof(detail::test_resource_list));
+      }
+    }
+
+  private:
+    /**
+     * \brief Allocates a memory block with the checks selected by the policies
+     * \param bytes the number of bytes to allocate
+     * \param alignment the alignment of the memory block
+     * \return the address of the allocated memory block
+     */
+    void* allocate_with(std::size_t bytes, std::size_t alignment)
+    {
+      const detail::latency_scope latency{ m_diagnostics.m_latencies, detail::allocation_operation };
+
+      long long allocation_index = 0LL;
+      if constexpr (policies::stats)
+      {
+        allocation_index = m_counters->m_usage.m_allocations.fetch_add(1LL, std::memory_order_relaxed);
+      }
+
+      if (0LL <= allocation_limit())
+      {
+        if (0LL > m_allocationLimit.fetch_add(-1LL, std::memory_order_relaxed) - 1LL)
+        {
+          throw test_resource_exception(this, bytes, alignment);
+        }
+      }
+
+      alignment = resolve_alignment(bytes, alignment);
+
+      if constexpr (!policies::header)
+      {
+        return allocate_unchecked(bytes, alignment, allocation_index);
+      }
+      else
+      {
+        if constexpr (policies::diagnostics)
+        {
+          if (m_diagnostics.m_sampledBlocks && !m_diagnostics.m_sampledBlocks->sample(m_diagnostics.m_samplingRate))
+          {
+            return allocate_unsampled(bytes, alignment, allocation_index);
+          }
+        }
+
+        using allocate_function = void* (basic_test_resource::*)(std::size_t, std::size_t, long long);
+        static constexpr auto allocate_functions = make_function_table<allocate_function>(
+          [](auto align) noexcept -> allocate_function {
+            return &basic_test_resource::do_allocate_impl<decltype(align)::value>;
+          });
+
+        const std::size_t alignment_log2 = detail::countr_zero(alignment);
+        if (alignment_log2 > detail::max_alignment_log2)
+        {
+          throw test_resource_exception(this, bytes, alignment);
+        }
+        return (this->*allocate_functions[alignment_log2])(bytes, alignment, allocation_index);
+      }
+    }
+
+    /**
+     * \brief Deallocates a memory block with the checks selected by the policies
+     * \param p the address of the memory block
+     * \param bytes the number of bytes of the memory block
+     * \param alignment the alignment of the memory block
+     */
+    void deallocate_with(void* p, std::size_t bytes, std::size_t alignment)
+    {
+      const detail::latency_scope latency{ m_diagnostics.m_latencies, detail::deallocation_operation };
+
+      if constexpr (policies::stats)
+      {
+        m_counters->local_shard().m_deallocations.fetch_add(1LL, std::memory_order_relaxed);
+      }
+      m_lastDeallocatedAddress.store(p, std::memory_order_relaxed);
+
+      if (!p)
+      {
+        if (0U != bytes)
+        {
+          if constexpr (policies::stats)
+          {
+            m_counters->local_shard().m_badDeallocateParams.fetch_add(1LL, std::memory_order_relaxed);
+          }
+          if (!is_quiet())
+          {
+            {
+              detail::lock_guard_t<policies::locking> guard{ m_lock };
+              m_reporter->report_log_msg("*** Freeing a nullptr using non-zero size (%zu) with alignment (%zu). ***\n",
+                bytes,
+                alignment);
+            }
+
+            if (!is_no_abort())
+            {
+              std::abort();
+            }
+          }
+        }
+        else
+        {
+          store_last_deallocation(p, 0U, alignment);
+        }
+        return;
+      }
+
+      alignment = resolve_alignment(bytes, alignment);
+
+      if constexpr (!policies::header)
+      {
+        deallocate_unchecked(p, bytes, alignment);
+      }
+      else
+      {
+        if constexpr (policies::diagnostics)
+        {
+          // the sampled blocks are told apart without touching the memory before 'p'
+          if (m_diagnostics.m_sampledBlocks && !m_diagnostics.m_sampledBlocks->contains(p))
+          {
+            deallocate_unchecked(p, bytes, alignment);
+            return;
+          }
+        }
+
+        using deallocate_function = void (basic_test_resource::*)(void*, std::size_t, std::size_t);
+        static constexpr auto deallocate_functions = make_function_table<deallocate_function>(
+          [](auto align) noexcept -> deallocate_function {
+            return &basic_test_resource::do_deallocate_impl<decltype(align)::value>;
+          });
+
+        const std::size_t alignment_log2 = detail::countr_zero(alignment);
+        if (alignment_log2 > detail::max_alignment_log2)
+        {
+          throw test_resource_exception(this, bytes, alignment);
+        }
+        (this->*deallocate_functions[alignment_log2])(p, bytes, alignment);
+      }
+    }
+
+    /**
+     * \brief Allocates 'count' memory blocks with the checks selected by the policies
+     * \param blocks the array receiving the addresses of the memory blocks
+     * \param count the number of memory blocks
+     * \param bytes the size of every memory block
+     * \param alignment the alignment of every memory block
+     */
+    void allocate_bulk_with(void** blocks, std::size_t count, std::size_t bytes, std::size_t alignment)
+    {
+      if (0U == count)
+      {
+        return;
+      }
+
+      alignment = resolve_alignment(bytes, alignment);
+
+      std::size_t allocated = 0U;
+      if (!is_bulk_eligible(bytes, alignment) || 0LL <= allocation_limit())
+      {
+        // the blocks are allocated one by one, still all or nothing
+        try
+        {
+          for (; allocated < count; ++allocated)
+          {
+            blocks[allocated] = allocate_with(bytes, alignment);
+          }
+        }
+        catch (...)
+        {
+          while (0U != allocated)
+          {
+            --allocated;
+            deallocate_with(blocks[allocated], bytes, alignment);
+          }
+          throw;
+        }
+        return;
+      }
+
+      long long allocation_index = 0LL;
+      if constexpr (policies::stats)
+      {
+        allocation_index = m_counters->m_usage.m_allocations.fetch_add(static_cast<long long>(count), std::memory_order_relaxed);
+      }
+
+      // the blocks of one request share its call stack
+      const std::uint32_t stack_id = capture_callsite();
+
+      try
+      {
+        for (; allocated < count; ++allocated)
+        {
+          auto* header = allocate_block(bytes, alignment);
+          if (!header)
+          {
+            throw std::bad_alloc();
+          }
+          init_header(header, bytes, alignment, allocation_index + static_cast<long long>(allocated), stack_id);
+          blocks[allocated] = header + 1;
+        }
+      }
+      catch (...)
+      {
+        while (0U != allocated)
+        {
+          --allocated;
+          deallocate_block(static_cast<detail::aligned_header_base*>(blocks[allocated]) - 1, bytes, alignment);
+        }
+        throw;
+      }
+
+      stamp_lifetimes(allocation_index, count);
+      if (m_trace)
+      {
+        for (std::size_t i = 0U; i < count; ++i)
+        {
+          trace(trace_operation::allocation, allocation_index + static_cast<long long>(i), blocks[i], bytes, alignment, stack_id);
+        }
+      }
+
+      if constexpr (policies::tracking)
+      {
+        m_list->add_blocks<policies::locking>(count, [blocks](std::size_t i) noexcept {
+          return &(static_cast<detail::aligned_header_base*>(blocks[i]) - 1)->m_object.m_block;
+        });
+      }
+
+      commit_allocation(blocks[count - 1U], bytes, alignment, count);
+    }
+
+    /**
+     * \brief Deallocates 'count' memory blocks with the checks selected by the policies
+     * \param blocks the array of the addresses of the memory blocks
+     * \param count the number of memory blocks
+     * \param bytes the size of every memory block
+     * \param alignment the alignment of every memory block
+     */
+    void deallocate_bulk_with(void* const* blocks, std::size_t count, std::size_t bytes, std::size_t alignment)
+    {
+      if (0U == count)
+      {
+        return;
+      }
+
+      alignment = resolve_alignment(bytes, alignment);
+
+      bool bulk = is_bulk_eligible(bytes, alignment);
+      if constexpr (policies::scribble)
+      {
+        bulk = bulk && !m_diagnostics.m_quarantine;
+      }
+
+      // The blocks are claimed (stamped as deallocated) while they are checked,
+      // so a block passed twice or deallocated by another thread meanwhile
+      // fails the check of its second copy.
+      std::size_t checked = 0U;
+      if constexpr (policies::header)
+      {
+        for (; bulk && checked < count; ++checked)
+        {
+          if (!blocks[checked] || !check_block(blocks[checked], bytes, alignment).ok() ||
+              !detail::claim_deallocation((static_cast<detail::aligned_header_base*>(blocks[checked]) - 1)->m_object))
+          {
+            bulk = false;
+            break;
+          }
+        }
+      }
+
+      if (!bulk)
+      {
+        // any error is counted and reported by the deallocation of its block
+        while (0U != checked)
+        {
+          --checked;
+          detail::store_magic_number((static_cast<detail::aligned_header_base*>(blocks[checked]) - 1)->m_object,
+            detail::allocated_memory_pattern);
+        }
+        for (std::size_t i = 0U; i < count; ++i)
+        {
+          deallocate_with(blocks[i], bytes, alignment);
+        }
+        return;
+      }
+
+      if constexpr (policies::stats)
+      {
+        m_counters->local_shard().m_deallocations.fetch_add(static_cast<long long>(count), std::memory_order_relaxed);
+      }
+
+      record_lifetimes(blocks, count);
+      if (m_trace)
+      {
+        for (std::size_t i = 0U; i < count; ++i)
+        {
+          const auto& head = (static_cast<const detail::aligned_header_base*>(blocks[i]) - 1)->m_object;
+          trace(trace_operation::deallocation, head.m_block.m_index, blocks[i], bytes, alignment, head.m_stack_id);
+        }
+      }
+
+      if constexpr (policies::tracking)
+      {
+        m_list->remove_blocks<policies::locking>(count, [blocks](std::size_t i) noexcept {
+          return &(static_cast<detail::aligned_header_base*>(blocks[i]) - 1)->m_object.m_block;
+        });
+      }
+
+      for (std::size_t i = 0U; i < count; ++i)
+      {
+        if constexpr (policies::scribble)
+        {
+          scribble_block(blocks[i], bytes);
+        }
+        deallocate_block(static_cast<detail::aligned_header_base*>(blocks[i]) - 1, bytes, alignment);
+      }
+
+      commit_deallocation(blocks[count - 1U], bytes, alignment, count);
+    }
+
+    [[nodiscard]]
+    const detail::test_resource_list* test_resource_list() const
+    {
+      return m_list;
+    }
+
+    // the sum of 'counter' over the statistics shards; zero without the stats policy
+    [[nodiscard]]
+    long long sum_shards(std::atomic_llong detail::stats_shard::* counter) const noexcept
+    {
+      if constexpr (policies::stats)
+      {
+        return m_counters->sum(counter);
+      }
+      else
+      {
+        return 0LL;
+      }
+    }
+
+    // 'counter' of the counters shared by the shards; zero without the stats policy
+    [[nodiscard]]
+    long long usage_counter(std::atomic_llong detail::usage_counters::* counter) const noexcept
+    {
+      if constexpr (policies::stats)
+      {
+        return (m_counters->m_usage.*counter).load(std::memory_order_relaxed);
+      }
+      else
+      {
+        return 0LL;
+      }
+    }
+
+    /**
+     * \brief Returns the alignment of the request
+     * \param bytes the number of bytes of the request
+     * \param alignment the requested alignment or 0 for the natural alignment of 'bytes'
+     * \return the alignment of the memory block
+     * \throw test_resource_exception if the alignment is not a power of two
+     */
+    std::size_t resolve_alignment(std::size_t bytes, std::size_t alignment)
+    {
+      if (0U == alignment)
+      {
+        // Choose natural alignment for `bytes`
+        alignment = ((bytes ^ (bytes - 1U)) >> 1U) + 1U;
+        if (alignment > detail::max_natural_alignment)
+        {
+          alignment = detail::max_natural_alignment;
+        }
+      }
+
+      // alignment has to be power of two
+      if (!detail::is_power_of_two(alignment))
+      {
+        throw test_resource_exception(this, bytes, alignment);
+      }
+
+      return alignment;
+    }
+
+    /**
+     * \brief Makes the table of the functions indexed by log2 of the alignment
+     * \tparam Function the type of the table element
+     * \param make the function object returning the element for the
+     *        std::integral_constant of the alignment; the alignments above
+     *        the static ones get the detail::runtime_alignment instantiation
+     * \return the table of the functions
+     */
+    template<typename Function, typename Make, std::size_t... Log2>
+    static constexpr std::array<Function, sizeof...(Log2)> make_function_table(
+      Make make,
+      std::index_sequence<Log2...>) noexcept
+    {
+      return { { make(std::integral_constant<std::size_t, detail::static_alignment_v<Log2>>{})... } };
+    }
+
+    template<typename Function, typename Make>
+    static constexpr auto make_function_table(Make make) noexcept
+    {
+      return make_function_table<Function>(make, std::make_index_sequence<detail::max_alignment_log2 + 1U>{});
+    }
+
+    // counts 'blocks' allocations of 'bytes' bytes each
+    void count_allocation(detail::stats_shard& shard, std::size_t bytes, std::size_t alignment, std::size_t blocks = 1U) noexcept
+    {
+      if constexpr (policies::stats)
+      {
+        const auto numBlocks = static_cast<long long>(blocks);
+        const auto numBytes = static_cast<long long>(bytes * blocks);
+
+        m_counters->add_in_use(shard, numBlocks, numBytes);
+        shard.m_totalBlocks.fetch_add(numBlocks, std::memory_order_relaxed);
+        shard.m_totalBytes.fetch_add(numBytes, std::memory_order_relaxed);
+
+        auto& histograms = m_counters->local_histograms();
+        histograms.m_sizes[detail::size_histogram_bucket(bytes)].fetch_add(numBlocks, std::memory_order_relaxed);
+        // the alignments passed through to the upstream may exceed detail::max_alignment
+        const std::size_t alignmentBucket =
+          (std::min)(detail::countr_zero(alignment), detail::alignment_histogram_bucket_count - 1U);
+        histograms.m_alignments[alignmentBucket].fetch_add(numBlocks, std::memory_order_relaxed);
+      }
+    }
+
+    void scribble_block(void* p, std::size_t size) const noexcept
+    {
+      switch (scribble())
+      {
+      case scribble_mode::full:
+        memset(p, std::to_integer<unsigned char>(detail::scribbled_memory_byte), size);
+        break;
+      case scribble_mode::off:
+        break;
+      case scribble_mode::edges:
+        if (const std::size_t edge = scribble_edge_size(); size <= 2U * edge)
+        {
+          memset(p, std::to_integer<unsigned char>(detail::scribbled_memory_byte), size);
+        }
+        else
+        {
+          memset(p, std::to_integer<unsigned char>(detail::scribbled_memory_byte), edge);
+          memset(static_cast<std::byte*>(p) + (size - edge),
+            std::to_integer<unsigned char>(detail::scribbled_memory_byte),
+            edge);
+        }
+        break;
+      case scribble_mode::streaming:
+        detail::stream_scribble(p, size);
+        break;
+      }
+    }
+
+    // counts 'blocks' deallocations of 'bytes' bytes each
+    void count_deallocation(detail::stats_shard& shard, std::size_t bytes, std::size_t blocks = 1U) noexcept
+    {
+      if constexpr (policies::stats)
+      {
+        m_counters->add_in_use(shard, -static_cast<long long>(blocks), -static_cast<long long>(bytes * blocks));
+      }
+    }
+
+    // counts the allocations and stores the last one as a single update of the statistics
+    void commit_allocation(void* address, std::size_t bytes, std::size_t alignment, std::size_t blocks = 1U) noexcept
+    {
+      if constexpr (policies::stats)
+      {
+        auto& shard = m_counters->local_shard();
+        detail::test_resource_counters::begin_update(shard);
+        count_allocation(shard, bytes, alignment, blocks);
+        store_last_allocation(address, bytes, alignment);
+        detail::test_resource_counters::end_update(shard);
+      }
+      else
+      {
+        store_last_allocation(address, bytes, alignment);
+      }
+    }
+
+    // counts the deallocations and stores the last one as a single update of the statistics
+    void commit_deallocation(void* address, std::size_t bytes, std::size_t alignment, std::size_t blocks = 1U) noexcept
+    {
+      if constexpr (policies::stats)
+      {
+        auto& shard = m_counters->local_shard();
+        detail::test_resource_counters::begin_update(shard);
+        count_deallocation(shard, bytes, blocks);
+        store_last_deallocation(address, bytes, alignment);
+        detail::test_resource_counters::end_update(shard);
+      }
+      else
+      {
+        store_last_deallocation(address, bytes, alignment);
+      }
+    }
+
+    void* allocate_unchecked(std::size_t bytes, std::size_t alignment, long long allocation_index)
+    {
+      // no header, no padding: the request is passed to the upstream resource as is
+      void* address = nullptr;
+      {
+        const detail::upstream_timer timer{ nullptr != m_diagnostics.m_latencies };
+        address = m_upstream->allocate(bytes, alignment);
+      }
+      commit_allocation(address, bytes, alignment);
+      trace(trace_operation::allocation, allocation_index, address, bytes, alignment, 0U);
+      return address;
+    }
+
+    // the allocation passed through by the sampling; the tombstone of its address
+    // would make its deallocation look like the second deallocation of a sampled block
+    void* allocate_unsampled(std::size_t bytes, std::size_t alignment, long long allocation_index)
+    {
+      void* address = allocate_unchecked(bytes, alignment, allocation_index);
+      m_diagnostics.m_sampledBlocks->forget(address);
+      return address;
+    }
+
+    void deallocate_unchecked(void* p, std::size_t bytes, std::size_t alignment)
+    {
+      // nothing to be checked without the header; trust the caller
+      trace(trace_operation::deallocation, -1LL, p, bytes, alignment, 0U);
+      if constexpr (policies::scribble)
+      {
+        scribble_block(p, bytes);
+      }
+      commit_deallocation(p, bytes, alignment);
+      const detail::upstream_timer timer{ nullptr != m_diagnostics.m_latencies };
+      m_upstream->deallocate(p, bytes, alignment);
+    }
+
+    [[nodiscard]]
+    bool is_guarded(std::size_t bytes, std::size_t alignment) const noexcept
+    {
+      return 0U != m_diagnostics.m_guardPageThreshold && m_diagnostics.m_guardPageThreshold <= bytes && alignment <= detail::page_size();
+    }
+
+    [[nodiscard]]
+    detail::guarded_layout guarded_layout_of(std::size_t bytes, std::size_t alignment) const noexcept
+    {
+      return detail::make_guarded_layout(sizeof(detail::aligned_header_base), bytes, alignment, m_diagnostics.m_leadingGuardPage);
+    }
+
+    // the size of the padding after the user segment
+    [[nodiscard]]
+    std::size_t tail_padding_size(std::size_t bytes, std::size_t alignment) const noexcept
+    {
+      return is_guarded(bytes, alignment) ? guarded_layout_of(bytes, alignment).m_slack : detail::padding_size;
+    }
+
+    detail::aligned_header_base* allocate_block(std::size_t bytes, std::size_t alignment)
+    {
+      const detail::upstream_timer timer{ nullptr != m_diagnostics.m_latencies };
+      if (is_guarded(bytes, alignment))
+      {
+        const auto layout = guarded_layout_of(bytes, alignment);
+        std::byte* map = detail::map_guarded(layout);
+        if (!map)
+        {
+          throw std::bad_alloc();
+        }
+        return reinterpret_cast<detail::aligned_header_base*>(map + layout.m_payloadOffset) - 1;
+      }
+
+      if (detail::is_compact_header(alignment))
+      {
+        void* address = m_upstream->allocate(detail::upstream_size(bytes, alignment), detail::max_natural_alignment);
+        if (!address)
+        {
+          return nullptr;
+        }
+        return static_cast<detail::aligned_header_base*>(detail::place_compact(address, alignment)) - 1;
+      }
+
+      return static_cast<detail::aligned_header_base*>(m_upstream->allocate(
+        detail::upstream_size(bytes, alignment), alignment));
+    }
+
+    void deallocate_block(detail::aligned_header_base* header, std::size_t bytes, std::size_t alignment)
+    {
+      const detail::upstream_timer timer{ nullptr != m_diagnostics.m_latencies };
+      if (is_guarded(bytes, alignment))
+      {
+        const auto layout = guarded_layout_of(bytes, alignment);
+        detail::unmap_guarded(reinterpret_cast<std::byte*>(header + 1) - layout.m_payloadOffset, layout);
+        return;
+      }
+
+      const auto block = detail::upstream_block_of(header + 1, bytes, alignment);
+      m_upstream->deallocate(block.m_address, block.m_bytes, block.m_alignment);
+    }
+
+    /**
+     * \brief Finds the first byte of the deallocated block 'p' which is not scribbled
+     * \return the address of the overwritten byte or nullptr if the scribble is intact
+     * \note Only the bytes scribbled in the current scribble mode are verified.
+     */
+    [[nodiscard]]
+    const std::byte* find_write_after_free(const std::byte* p, std::size_t size) const noexcept
+    {
+      const std::byte* first = p;
+      const std::byte* last = p + size;
+      const std::byte* pc = last;
+      switch (scribble())
+      {
+      case scribble_mode::full:
+      case scribble_mode::streaming:
+        pc = detail::find_first_corrupted(first, last, detail::scribbled_memory_byte);
+        break;
+      case scribble_mode::off:
+        break;
+      case scribble_mode::edges:
+      {
+        const std::size_t edge = std::min(size, scribble_edge_size());
+        pc = detail::find_first_corrupted(first, first + edge, detail::scribbled_memory_byte);
+        if (pc == first + edge)
+        {
+          pc = detail::find_first_corrupted(last - edge, last, detail::scribbled_memory_byte);
+        }
+        break;
+      }
+      }
+      return pc != last ? pc : nullptr;
+    }
+
+    /**
+     * \brief Verifies the scribble of the blocks evicted from the quarantine
+     *        and gives them back to the upstream resource
+     * \tparam Locking false if the resource is never accessed concurrently
+     * \param evicted the list of the evicted blocks
+     */
+    template<bool Locking>
+    void release_quarantined(detail::block_list& evicted)
+    {
+      while (!evicted.empty())
+      {
+        auto* head = detail::header_of(evicted.remove_block(evicted.m_head));
+        const std::size_t bytes = head->m_bytes;
+        const std::size_t alignment = head->alignment();
+        auto* payload = reinterpret_cast<std::byte*>(head) + detail::aligned_header_size(alignment);
+
+        if (const auto* pc = find_write_after_free(payload, bytes))
+        {
+          m_counters->local_shard().m_writesAfterFree.fetch_add(1LL, std::memory_order_relaxed);
+          if (!is_quiet())
+          {
+            {
+              detail::lock_guard_t<Locking> guard{ m_lock };
+              m_reporter->report_write_after_free(
+                *this,
+                payload,
+                bytes,
+                alignment,
+                static_cast<std::size_t>(pc - payload));
+            }
+
+            if (!is_no_abort())
+            {
+              std::abort();
+            }
+          }
+        }
+
+        const auto block = detail::upstream_block_of(payload, bytes, alignment);
+        m_upstream->deallocate(block.m_address, block.m_bytes, block.m_alignment);
+      }
+    }
+
+    /**
+     * \brief Reports the invalid memory block 'p' of the failed deallocation
+     * \note The test_resource passes the block to the reporter,
+     *       the other instantiations log the error only.
+     */
+    void report_invalid_memory_block(void* p, std::size_t bytes, std::size_t alignment, const detail::block_check& check)
+    {
+      if constexpr (policies::diagnostics)
+      {
+        m_reporter->report_invalid_memory_block(
+          *this,
+          bytes,
+          alignment,
+          check.m_underrunBy,
+          check.m_overrunBy);
+      }
+      else
+      {
+        const char* error = "not allocated by this resource or already deallocated";
+        if (check.m_underrunBy)
+        {
+          error = "memory corrupted before the segment";
+        }
+        else if (check.m_overrunBy)
+        {
+          error = "memory corrupted after the segment";
+        }
+        else if (check.m_paramError)
+        {
+          error = "wrong size or alignment";
+        }
+        m_reporter->report_log_msg("test_resource%s%.*s: *** Freeing %zu byte segment (aligned %zu) at %p: %s. ***\n",
+          m_name.empty() ? "" : " ",
+          static_cast<int>(m_name.length()),
+          m_name.data(),
+          bytes,
+          alignment,
+          p,
+          error);
+      }
+    }
+
+    // true if the allocations and deallocations are reported (the verbose test_resource)
+    [[nodiscard]]
+    bool reports_operations() const noexcept
+    {
+      return policies::diagnostics && is_verbose();
+    }
+
+    void init_header(detail::aligned_header_base* header, std::size_t bytes, std::size_t alignment,
+      long long allocation_index, std::uint32_t stack_id) noexcept
+    {
+      if constexpr (policies::guard)
+      {
+        //initialize header padding + additional padding before the payload
+        memset(&header->m_object.m_padding,
+          std::to_integer<unsigned char>(detail::padded_memory_byte),
+          reinterpret_cast<std::byte*>(header + 1) - reinterpret_cast<std::byte*>(&header->m_object.m_padding));
+
+        //initialize padding after the payload
+        memset(reinterpret_cast<std::byte*>(header + 1) + bytes,
+          std::to_integer<unsigned char>(detail::padded_memory_byte),
+          tail_padding_size(bytes, alignment));
+      }
+
+      header->m_object.m_bytes = bytes;
+      header->m_object.m_alignment_log2 = static_cast<std::uint32_t>(detail::countr_zero(alignment));
+      header->m_object.m_stack_id = stack_id;
+      header->m_object.m_magic_number = detail::allocated_memory_pattern;
+      header->m_object.m_block.m_index = allocation_index;
+      header->m_object.m_pmr = this;
+    }
+
+    // the id of the call stack of the allocation or 0 if the capture is off
+    [[nodiscard]]
+    std::uint32_t capture_callsite() const noexcept
+    {
+      if constexpr (policies::diagnostics)
+      {
+        const std::size_t depth = m_diagnostics.m_callsiteDepth.load(std::memory_order_relaxed);
+        return 0U == depth ? 0U : detail::capture_callsite(depth, m_diagnostics.m_callsiteSkip.load(std::memory_order_relaxed));
+      }
+      else
+      {
+        return 0U;
+      }
+    }
+
+    // keeps the allocation time of the 'count' blocks starting at the allocation index 'index'
+    void stamp_lifetimes(long long index, std::size_t count) noexcept
+    {
+      if constexpr (policies::diagnostics)
+      {
+        if (m_diagnostics.m_lifetimes)
+        {
+          const std::uint64_t now = detail::clock_nanoseconds();
+          for (std::size_t i = 0U; i < count; ++i)
+          {
+            m_diagnostics.m_lifetimes->stamp(index + static_cast<long long>(i), now);
+          }
+        }
+      }
+    }
+
+    // records the event in the attached trace recorder
+    void trace(trace_operation operation, long long index, const void* p,
+      std::size_t bytes, std::size_t alignment, std::uint32_t stack_id) const noexcept
+    {
+      if (m_trace)
+      {
+        m_trace->record(operation, index, p, bytes, alignment, stack_id);
+      }
+    }
+
+    // counts the lifetimes of the 'count' valid blocks being deallocated
+    void record_lifetimes(void* const* blocks, std::size_t count) noexcept
+    {
+      if constexpr (policies::diagnostics)
+      {
+        if (m_diagnostics.m_lifetimes)
+        {
+          const std::uint64_t now = detail::clock_nanoseconds();
+          const long long allocations = m_counters->m_usage.m_allocations.load(std::memory_order_relaxed);
+          for (std::size_t i = 0U; i < count; ++i)
+          {
+            const auto& head = (static_cast<const detail::aligned_header_base*>(blocks[i]) - 1)->m_object;
+            m_diagnostics.m_lifetimes->record(head.m_block.m_index, allocations, head.m_bytes, head.m_stack_id, now);
+          }
+        }
+      }
+    }
+
+    // true if the blocks of the bulk request can skip the per block bookkeeping
+    [[nodiscard]]
+    bool is_bulk_eligible(std::size_t bytes, std::size_t alignment) const noexcept
+    {
+      return policies::header &&
+        !m_diagnostics.m_sampledBlocks &&
+        !reports_operations() &&
+        alignment <= detail::max_alignment &&
+        !is_guarded(bytes, alignment);
+    }
+
+    template<std::size_t Align>
+    void* do_allocate_impl(std::size_t bytes, std::size_t alignment, long long allocation_index)
+    {
+      if constexpr (Align != detail::runtime_alignment)
+      {
+        // the constant alignment lets the compiler fold the layout computations
+        alignment = Align;
+      }
+
+      auto* header = allocate_block(bytes, alignment);
+
+      if (!header)
+      {
+        // We cannot satisfy this request. Throw 'std::bad_alloc'.
+        throw std::bad_alloc();
+      }
+
+      if constexpr (policies::diagnostics)
+      {
+        if (m_diagnostics.m_sampledBlocks && !m_diagnostics.m_sampledBlocks->insert(header + 1))
+        {
+          // no room for another sampled block; the request is passed through
+          deallocate_block(header, bytes, alignment);
+          return allocate_unsampled(bytes, alignment, allocation_index);
+        }
+      }
+
+      const std::uint32_t stack_id = capture_callsite();
+      init_header(header, bytes, alignment, allocation_index, stack_id);
+      stamp_lifetimes(allocation_index, 1U);
+
+      if constexpr (policies::tracking)
+      {
+        m_list->add_block<policies::locking>(&header->m_object.m_block);
+      }
+
+      void* address = ++header;
+
+      if (reports_operations())
+      {
+        // the reporter reads the 'last allocated' fields,
+        // so they are updated and reported under the lock
+        detail::lock_guard_t<policies::locking> guard{ m_lock };
+        commit_allocation(address, bytes, alignment);
+        if constexpr (policies::diagnostics)
+        {
+          m_reporter->report_allocation(*this);
+        }
+      }
+      else
+      {
+        commit_allocation(address, bytes, alignment);
+      }
+
+      trace(trace_operation::allocation, allocation_index, address, bytes, alignment, stack_id);
+      return address;
+    }
+
+    [[nodiscard]]
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+      return allocate_with(bytes, alignment);
+    }
+
+    [[nodiscard]]
+    detail::block_check check_block(void* p, std::size_t bytes, std::size_t alignment) const noexcept
+    {
+      const auto* header = static_cast<const detail::aligned_header_base*>(p) - 1;
+
+      detail::block_check check{};
+
+      // The following checks are done deliberately in the order shown to avoid a
+      // possible bus error when attempting to read a misaligned 64-bit integer,
+      // which can happen if an invalid address is passed to this method. If the
+      // address of the memory being deallocated is misaligned, it is very likely
+      // that 'm_magicNumber' will not match the expected value, and so we will
+      // skip the reading of 'm_bytes_' (a 64-bit integer).
+      if ((detail::allocated_memory_pattern != detail::load_magic_number(header->m_object)) ||
+          (this != header->m_object.m_pmr))
+      {
+        check.m_miscError = true;
+      }
+      else
+      {
+        check.m_size = header->m_object.m_bytes;
+      }
+
+      // If there is evidence of corruption, this memory may have already been
+      // freed.  On some platforms (but not others), the 'free' function will
+      // scribble freed memory. To get uniform behavior for test drivers, we
+      // deliberately don't check over/underruns if 'm_miscError' is 'true'.
+      if (!check.m_miscError)
+      {
+        if constexpr (policies::guard)
+        {
+          // Check the padding before the segment. Go backwards so we will
+          // report the trashed byte nearest the segment.
+          const auto* head = static_cast<const std::byte*>(p);
+          const auto* pc = detail::find_last_corrupted(
+            reinterpret_cast<const std::byte*>(&header->m_object.m_padding), head);
+          if (pc)
+          {
+            check.m_underrunBy = static_cast<int>(head - pc);
+          }
+          else
+          {
+            // Check the padding after the segment.
+            const std::byte* tail = head + check.m_size;
+            const std::byte* tailEnd = tail + tail_padding_size(check.m_size, alignment);
+            pc = detail::find_first_corrupted(tail, tailEnd);
+            if (pc != tailEnd)
+            {
+              check.m_overrunBy = static_cast<int>(pc + 1 - tail);
+            }
+          }
+        }
+
+        if (bytes != check.m_size || alignment != header->m_object.alignment())
+        {
+          check.m_paramError = true;
+        }
+      }
+
+
+      return check;
+    }
+
+    template<std::size_t Align>
+    void do_deallocate_impl(void* p, std::size_t bytes, std::size_t alignment)
+    {
+      if constexpr (Align != detail::runtime_alignment)
+      {
+        // the constant alignment lets the compiler fold the layout computations
+        alignment = Align;
+      }
+
+      auto* header = static_cast<detail::aligned_header_base*>(p) - 1;
+
+      auto check = check_block(p, bytes, alignment);
+      const std::size_t size = check.m_size;
+
+      // Of the threads deallocating the block concurrently only one claims it,
+      // the others find it deallocated as a double deallocation would.
+      if (check.ok() && !detail::claim_deallocation(header->m_object))
+      {
+        check.m_miscError = true;
+      }
+
+      // Now check for corrupted memory block and cross allocation.
+      if (check.ok())
+      {
+        trace(trace_operation::deallocation, header->m_object.m_block.m_index, p, bytes, alignment,
+          header->m_object.m_stack_id);
+        record_lifetimes(&p, 1U);
+
+        if constexpr (policies::tracking)
+        {
+          m_list->remove_block<policies::locking>(&header->m_object.m_block);
+        }
+        if constexpr (policies::diagnostics)
+        {
+          if (m_diagnostics.m_sampledBlocks)
+          {
+            m_diagnostics.m_sampledBlocks->erase(p);
+          }
+        }
+      }
+      else
+      { // Any error, count it, report it
+        if constexpr (policies::stats)
+        {
+          auto& shard = m_counters->local_shard();
+          if (check.m_miscError)
+          {
+            shard.m_mismatches.fetch_add(1LL, std::memory_order_relaxed);
+          }
+          if (check.m_paramError)
+          {
+            shard.m_badDeallocateParams.fetch_add(1LL, std::memory_order_relaxed);
+          }
+          if (check.m_overrunBy || check.m_underrunBy) {
+            shard.m_boundsErrors.fetch_add(1LL, std::memory_order_relaxed);
+          }
+        }
+
+        if (is_quiet())
+        {
+          return;
+        }
+
+        {
+          detail::lock_guard_t<policies::locking> guard{ m_lock };
+          m_lastDeallocatedAddress.store(p, std::memory_order_relaxed);
+          report_invalid_memory_block(p, bytes, alignment, check);
+        }
+
+        if (is_no_abort())
+        {
+          return;
+        }
+
+        std::abort();
+      }
+
+      // At this point we know (almost) for sure that the memory block is
+      // currently allocated from this object and its header is stamped as
+      // deallocated. We now proceed to update our statistics, scribble over its
+      // payload, and give it back to the underlying allocator supplied at
+      // construction. In verbose mode, we also report the deallocation event to
+      // 'outputSteam'.
+      if constexpr (policies::scribble)
+      {
+        // the guarded block is unmapped, so any later access faults anyway
+        if (!is_guarded(size, alignment))
+        {
+          scribble_block(p, size);
+        }
+      }
+
+      if (reports_operations())
+      {
+        // the reporter reads the 'last deallocated' fields,
+        // so they are updated and reported under the lock
+        detail::lock_guard_t<policies::locking> guard{ m_lock };
+        commit_deallocation(p, size, alignment);
+        if constexpr (policies::diagnostics)
+        {
+          m_reporter->report_deallocation(*this);
+        }
+      }
+      else
+      {
+        commit_deallocation(p, size, alignment);
+      }
+
+      if constexpr (policies::diagnostics)
+      {
+        if (m_diagnostics.m_quarantine && !is_guarded(size, alignment))
+        {
+          detail::block_list evicted{};
+          m_diagnostics.m_quarantine->template push<policies::locking>(header->m_object, evicted);
+          release_quarantined<policies::locking>(evicted);
+          return;
+        }
+      }
+
+      deallocate_block(header, size, alignment);
+
+      // the deallocation via upstream may modify the magicnumber and data in user area
+      //header->m_object.m_magic_number = detail::deallocated_memory_pattern;
+      //memset(p, static_cast<int>(detail::scribbled_memory_byte), size);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+      deallocate_with(p, bytes, alignment);
+    }
+
+    void store_last_allocation(void* address, std::size_t bytes, std::size_t alignment) noexcept
+    {
+      m_lastAllocatedAddress.store(address, std::memory_order_relaxed);
+      m_lastAllocatedNumBytes.store(bytes, std::memory_order_relaxed);
+      m_lastAllocatedAlignment.store(alignment, std::memory_order_relaxed);
+    }
+
+    void store_last_deallocation(void* address, std::size_t bytes, std::size_t alignment) noexcept
+    {
+      m_lastDeallocatedAddress.store(address, std::memory_order_relaxed);
+      m_lastDeallocatedNumBytes.store(bytes, std::memory_order_relaxed);
+      m_lastDeallocatedAlignment.store(alignment, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]]
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+      return this == &other;
+    }
+
+    // serializes the reporting; the allocations and deallocations
+    // don't take the lock unless they are reported
+    mutable detail::mutex_t<policies::locking> m_lock{};
+    std::string_view m_name{};
+
+    std::atomic_bool m_noAbortFlag{ false };
+    std::atomic_bool m_quietFlag{ false };
+    std::atomic_bool m_verboseFlag{ false };
+    std::atomic_llong m_allocationLimit{ -1LL };
+    std::atomic<scribble_mode> m_scribbleMode{ scribble_mode::full };
+    std::atomic_size_t m_scribbleEdgeSize{ 0U };
+
+    detail::test_resource_diagnostics_t<policies::diagnostics> m_diagnostics{};
+    test_resource_trace_recorder* m_trace{ nullptr };
+
+    // allocated with the stats policy only
+    detail::test_resource_counters* m_counters{ nullptr };
+
+    std::atomic<void*> m_lastAllocatedAddress{ nullptr };
+    std::atomic<void*> m_lastDeallocatedAddress{ nullptr };
+
+    std::atomic_size_t m_lastAllocatedNumBytes{ 0U };
+    std::atomic_size_t m_lastDeallocatedNumBytes{ 0U };
+
+    std::atomic_size_t m_lastAllocatedAlignment{ 0U };
+    std::atomic_size_t m_lastDeallocatedAlignment{ 0U };
+
+    // allocated with the tracking policy only
+    detail::test_resource_list* m_list{ nullptr };
+
+    test_resource_reporter* m_reporter{ nullptr };
+
+    //upstream resource from which to allocate
+    std::pmr::memory_resource* m_upstream = std::pmr::get_default_resource();
+  };
+
+  // the resource only counting the statistics; the cheapest leak detection
+  using stats_test_resource = basic_test_resource<
+    mutex_lock_policy,
+    null_guard_policy,
+    null_scribble_policy,
+    null_tracking_policy,
+    sharded_stats_policy>;
+
+  /**
+   * \brief The default resource guard is a simple RAII class that supports
+   *        installing a new default polymorphic memory resource and then restoring
+   *        of the original default polymorphic memory resource in its destructor.
+   */
+  class [[maybe_unused]] default_resource_guard final
+  {
+  public:
+    explicit default_resource_guard(std::pmr::memory_resource* newDefault) noexcept
+    {
+      if (newDefault)
+      {
+        m_oldDefault = std::pmr::set_default_resource(newDefault);
+      }
+    }
+
+    default_resource_guard(const default_resource_guard&) = delete;
+    default_resource_guard& operator=(const default_resource_guard&) = delete;
+
+    ~default_resource_guard() noexcept
+    {
+      // if m_oldDefault is nullPtr, the set_default_resource sets
+      // a std::pmr::new_delete_resource as default one
+      std::pmr::set_default_resource(m_oldDefault);
+    }
+
+  private:
+    std::pmr::memory_resource* m_oldDefault{ nullptr };
+  };
+
+  template<typename LockPolicy, typename GuardPolicy, typename ScribblePolicy, typename TrackingPolicy, typename StatsPolicy, typename F>
+  void exception_test_loop(basic_test_resource<LockPolicy, GuardPolicy, ScribblePolicy, TrackingPolicy, StatsPolicy>& tr, F&& f)
+  {
+    const auto orig_allocation_limit = tr.allocation_limit();
+
+    for (long long exceptionCounter = 0LL; true; ++exceptionCounter)
+    {
+      try
+      {
+        tr.set_allocation_limit(exceptionCounter);
+        std::invoke(std::forward<decltype(f)>(f), tr);
+        tr.set_allocation_limit(orig_allocation_limit);
+        return;
+      }
+      catch (const test_resource_exception& e)
+      {
+        tr.set_allocation_limit(orig_allocation_limit);
+
+        if (e.originating_resource() != &tr)
+        {
+          tr.reporter()->report_log_msg(
+            "  *** test_resource_exception from unexpected test resource: %p %.*s ***\n",
+            static_cast<void*>(e.originating_resource()),
+            static_cast<int>(e.originating_name().length()),
+            e.originating_name().data());
+          throw;
+        }
+
+        if (tr.is_verbose())
+        {
+          tr.reporter()->report_log_msg(
+            "  *** test_resource_exception: alloc limit = %lld, last alloc size = %zu, align = %zu ***\n",
+            exceptionCounter,
+            e.size(),
+            e.alignment());
+        }
+      }
+    }
+  }
+
+  inline
+  const detail::test_resource_list*
+  test_resource_reporter::test_resource_list(const test_resource& tr) noexcept
+  {
+    return tr.test_resource_list();
+  }
+
+  inline
+  std::size_t
+  test_resource_reporter::tail_padding_size(const test_resource& tr, std::size_t bytes, std::size_t alignment) noexcept
+  {
+    return tr.tail_padding_size(bytes, alignment);
+  }
+
+  inline void test_resource_reporter::do_report_write_after_free(
+    const test_resource& tr,
+    const void* address,
+    std::size_t bytes,
+    std::size_t alignment,
+    std::size_t offset)
+  {
+    const std::string name{ tr.name() };
+    report_log_msg("test_resource%s%s: *** Memory written after free at %zu bytes into %zu byte segment (aligned %zu) at %p. ***\n",
+      name.empty() ? "" : " ",
+      name.c_str(),
+      offset,
+      bytes,
+      alignment,
+      address);
+  }
+
+  inline void detail::stream_test_resource_reporter::do_report_allocation(const test_resource& tr)
+  {
+    m_stream << "test_resource";
+
+    if (!tr.name().empty())
+    {
+      m_stream << " " << tr.name();
+    }
+
+    const auto stats = tr.snapshot();
+    auto* address = stats.m_lastAllocatedAddress;
+    const auto alignment = stats.m_lastAllocatedAlignment;
+    const auto bytes = stats.m_lastAllocatedBytes;
+    const auto* header = detail::get_header(address, alignment);
+
+    if (header)
+    {
+      const auto allocation_index = header->m_block.m_index;
+
+      m_stream << " [" << allocation_index << "]: Allocated "
+        << bytes << " byte" << (bytes == 1U ? "" : "s")
+        << " (aligned " << alignment << ") at "
+        << formater_type::addr2str(address) << '.';
+    }
+
+    m_stream << std::endl;
+  }
+
+  inline void detail::stream_test_resource_reporter::do_report_deallocation(const test_resource& tr)
+  {
+    m_stream << "test_resource";
+
+    if (!tr.name().empty())
+    {
+      m_stream << ' ' << tr.name();
+    }
+
+    const auto stats = tr.snapshot();
+    auto* address = stats.m_lastDeallocatedAddress;
+    const auto alignment = stats.m_lastDeallocatedAlignment;
+    const auto bytes = stats.m_lastDeallocatedBytes;
+    const auto* header = detail::get_header(address, alignment);
+
+    if (header)
+    {
+      const auto allocation_index = header->m_block.m_index;
+
+      m_stream << " [" << allocation_index << "]: Deallocated "
+        << bytes << " byte" << (bytes == 1U ? "" : "s")
+        << " (aligned " << alignment << ") at "
+        << formater_type::addr2str(address) << '.';
+    }
+
+    m_stream << std::endl;
+  }
+
+  inline void detail::stream_test_resource_reporter::do_report_invalid_memory_block(
+    const test_resource& tr,
+    std::size_t deallocatedBytes,
+    std::size_t deallocatedAlignment,
+    int underrunBy,
+    int overrunBy)
+  {
+    auto* payload = tr.last_deallocated_address();
+    auto* head = get_header(payload, deallocatedAlignment);
+    const auto* allocator = static_cast<const std::pmr::memory_resource*>(&tr);
+
+    const auto magicNumber = load_magic_number(*head);
+    const auto numBytes = head->m_bytes;
+    const auto alignment = head->alignment();
+
+    if (allocated_memory_pattern != magicNumber)
+    {
+      if (deallocated_memory_pattern == magicNumber)
+      {
+        m_stream << "*** Deallocating previously deallocated memory at "
+          << formater_type::addr2str(payload) << ". ***\n";
+      }
+      else
+      {
+        const auto prev_fill = m_stream.fill();
+        const auto prev_width = m_stream.width();
+        m_stream << "*** Invalid magic number "
+          << std::hex << std::showbase << std::setw(8U) << std::setfill('0')
+          << magicNumber
+          << std::setfill(prev_fill) << std::setw(prev_width) << std::noshowbase << std::dec
+          << " at address " << formater_type::addr2str(payload) << ". ***\n";
+      }
+    }
+    else
+    {
+      if (numBytes <= 0U)
+      {
+        m_stream << "*** Invalid (non-positive) byte count " << numBytes
+          << " at address " << formater_type::addr2str(payload) << ". *** \n";
+      }
+      if (deallocatedBytes != head->m_bytes)
+      {
+        m_stream << "*** Freeing segment at " << formater_type::addr2str(payload)
+          << " using wrong size (" << deallocatedBytes << " vs. " << numBytes  << "). ***\n";
+      }
+      if (deallocatedAlignment != alignment)
+      {
+        m_stream << "*** Freeing segment at " << formater_type::addr2str(payload)
+          << " using wrong alignment (" << deallocatedAlignment << " vs. " << alignment << "). ***\n";
+      }
+      if (allocator != head->m_pmr)
+      {
+        m_stream << "*** Freeing segment at " << formater_type::addr2str(payload)
+          << " from wrong allocator. ***\n";
+      }
+      if (underrunBy)
+      {
+        m_stream << "*** Memory corrupted at " << underrunBy
+          << " bytes before " << numBytes << " byte segment at "
+          << formater_type::addr2str(payload) << ". ***\n";
+
+        m_stream << "Pad area before user segment:\n";
+        m_stream << formater_type::mem2str(
+          &head->m_padding,
+          static_cast<std::byte*>(payload) - reinterpret_cast<std::byte*>(&head->m_padding));
+      }
+      if (overrunBy)
+      {
+        m_stream << "*** Memory corrupted at " << overrunBy << " bytes after "
+          << numBytes << " byte segment at " << formater_type::addr2str(payload) << ". ***\n";
+
+        // the guarded block is followed by its alignment slack and the guard page
+        m_stream << "Pad area after user segment:\n";
+        m_stream << formater_type::mem2str(static_cast<std::byte*>(payload) + numBytes,
+          tail_padding_size(tr, numBytes, alignment));
+      }
+    }
+
+    m_stream << "Header + Padding:\n"
+      << formater_type::mem2str(head, static_cast<std::byte*>(payload) - reinterpret_cast<std::byte*>(head));
+    //let print 64 bytes when the header is "corrupted"
+    m_stream << "User segment:\n" << formater_type::mem2str(payload, std::min<std::size_t>(64U, numBytes));
+  }
+
+  inline void detail::stream_test_resource_reporter::do_report_write_after_free(
+    const test_resource& tr,
+    const void* address,
+    std::size_t bytes,
+    std::size_t alignment,
+    std::size_t offset)
+  {
+    m_stream << "test_resource";
+
+    if (!tr.name().empty())
+    {
+      m_stream << ' ' << tr.name();
+    }
+
+    m_stream << ": *** Memory written after free at " << offset
+      << " bytes into " << bytes << " byte segment (aligned " << alignment << ") at "
+      << formater_type::addr2str(const_cast<void*>(address)) << ". ***\n";
+
+    //let print up to 64 bytes from the corrupted line
+    const std::size_t first = offset & ~std::size_t{ 15U };
+    m_stream << "User segment:\n" << formater_type::mem2str(
+      const_cast<std::byte*>(static_cast<const std::byte*>(address)) + first,
+      std::min<std::size_t>(64U, bytes - first));
+  }
+
+  inline void detail::stream_test_resource_reporter::do_report_release(const test_resource& tr)
+  {
+    if (const auto stats = tr.snapshot(); stats.has_allocations())
+    {
+      m_stream << "MEMORY_LEAK";
+      if (!tr.name().empty())
+      {
+        m_stream << " from " << tr.name();
+      }
+      m_stream <<
+        ":\n   Number of blocks in use = " << stats.m_blocksInUse <<
+        "\n   Number of bytes in use = " << stats.m_bytesInUse << std::endl;
+
+      print_callsites(tr);
+
+      if (!tr.is_no_abort())
+      {
+        std::abort();
+      }
+    }
+  }
+
+  inline void detail::stream_test_resource_reporter::do_report_print(const test_resource& tr)
+  {
+    m_stream <<
+      "\n======================================================"
+      "\n  TEST RESOURCE " << (!tr.name().empty() ? string_type(tr.name()) + " STATE" : "STATE") <<
+      "\n------------------------------------------------------";
+
+    const auto stats = tr.snapshot();
+    const auto prev_flags = m_stream.flags();
+    const auto prev_width = m_stream.width();
+    m_stream <<
+      "\n        Category    Blocks          Bytes"
+      "\n        --------    ------          -----"
+      "\n          IN USE    " << std::left << std::setw(16U) << stats.m_blocksInUse << std::setw(prev_width) << stats.m_bytesInUse <<
+      "\n             MAX    " << std::setw(16U) << stats.m_maxBlocks << std::setw(prev_width) << stats.m_maxBytes <<
+      "\n           TOTAL    " << std::setw(16U) << stats.m_totalBlocks << std::setw(prev_width) << stats.m_totalBytes <<
+      "\n      MISMATCHES    " << stats.m_mismatches <<
+      "\n   BOUNDS ERRORS    " << stats.m_boundsErrors <<
+      "\n   PARAM. ERRORS    " << stats.m_badDeallocateParams;
+
+    if (0LL != stats.m_totalBlocks)
+    {
+      // the non-empty buckets only, the pool options are chosen by them
+      const auto histograms = tr.histograms();
+      m_stream <<
+        "\n------------------------------------------------------"
+        "\n      Size (Bytes)        Blocks"
+        "\n      ------------        ------";
+      for (std::size_t i = 0U; i < histograms.m_sizes.size(); ++i)
+      {
+        if (0LL != histograms.m_sizes[i])
+        {
+          const auto min = test_resource_histograms::size_bucket_min(i);
+          m_stream << "\n      " << std::setw(20U);
+          if (i + 1U == histograms.m_sizes.size())
+          {
+            m_stream << (std::to_string(min) + " - ...");
+          }
+          else
+          {
+            const auto max = test_resource_histograms::size_bucket_min(i + 1U) - 1U;
+            m_stream << (min == max ? std::to_string(min) : std::to_string(min) + " - " + std::to_string(max));
+          }
+          m_stream << std::setw(prev_width) << histograms.m_sizes[i];
+        }
+      }
+
+      m_stream <<
+        "\n      Alignment           Blocks"
+        "\n      ---------           ------";
+      for (std::size_t i = 0U; i < histograms.m_alignments.size(); ++i)
+      {
+        if (0LL != histograms.m_alignments[i])
+        {
+          m_stream << "\n      " << std::setw(20U) << test_resource_histograms::alignment_of_bucket(i)
+            << std::setw(prev_width) << histograms.m_alignments[i];
+        }
+      }
+    }
+
+    if (tr.is_latency_profiling())
+    {
+      print_latencies(tr);
+    }
+
+    m_stream << "\n--------------------------------------------------\n";
+    m_stream.setf(prev_flags);
+
+    const auto* list = test_resource_list(tr);
+    if (!list->empty())
+    {
+      m_stream << " Indices of Outstanding Memory Allocations:\n ";
+
+      // Prints the indices of max 8 'block' objects per line
+      int column = 0;
+      list->for_each([this, &column](const block_info& info) {
+        m_stream << "  " << info.m_index;
+        if (++column == 8)
+        {
+          m_stream << "\n ";
+          column = 0;
+        }
+      });
+
+      if (column != 0)
+      {
+        m_stream << "\n ";
+      }
+    }
+
+    print_callsites(tr);
+
+    if (tr.is_lifetime_profiling())
+    {
+      print_lifetimes(tr);
+    }
+
+    m_stream.flush();
+  }
+
+  inline void detail::stream_test_resource_reporter::print_callsites(const test_resource& tr)
+  {
+    struct group
     {
-      m_quietFlag.store(is_quiet, std::memory_order_relaxed);
+      std::uint32_t m_stackId;
+      long long m_blocks;
+      std::size_t m_bytes;
+    };
+
+    // the outstanding blocks grouped by the ids of their call stacks
+    std::vector<group> groups;
+    bool captured = false;
+    test_resource_list(tr)->for_each([&groups, &captured](const block_info& info) {
+      captured = captured || 0U != info.m_stackId;
+      groups.push_back({ info.m_stackId, 1LL, info.m_bytes });
+    });
+
+    if (!captured)
+    {
+      return;
     }
 
-    /**
-     * \brief Sets the verbose behavior.
-     * \param is_verbose new value of verbose flag
-     * \note If flag is true, report all allocations and deallocations to the standard output.
-     *       The default value of the setting is false or what is specified in the constructor.
-     */
-    void set_verbose(bool is_verbose) noexcept
+    std::sort(groups.begin(), groups.end(), [](const group& lhs, const group& rhs) {
+      return lhs.m_stackId < rhs.m_stackId;
+    });
+    std::size_t count = 0U;
+    for (const auto& item : groups)
     {
-      m_verboseFlag.store(is_verbose, std::memory_order_relaxed);
+      if (0U != count && groups[count - 1U].m_stackId == item.m_stackId)
+      {
+        ++groups[count - 1U].m_blocks;
+        groups[count - 1U].m_bytes += item.m_bytes;
+      }
+      else
+      {
+        groups[count++] = item;
+      }
     }
+    groups.resize(count);
 
-    /**
-     * \brief Returns the number of allocation requests permitted before throwing
-     *        test_resource_exception or a negative value if this test memory resource
-     *        does not impose a limit on the number of allocations
-     * \return number of allowed allocation requests
-     * \note This value will decrement with every call to do_allocate.
-     */
-    [[nodiscard]]
-    long long allocation_limit() const noexcept
+    // the largest leaks first
+    std::stable_sort(groups.begin(), groups.end(), [](const group& lhs, const group& rhs) {
+      return lhs.m_bytes > rhs.m_bytes;
+    });
+
+    m_stream << " Outstanding Memory Allocations by Call Site:\n";
+    for (const auto& item : groups)
     {
-      return m_allocationLimit.load(std::memory_order_relaxed);
+      m_stream << "   " << item.m_blocks << " blocks, " << item.m_bytes << " bytes";
+      print_frames(item.m_stackId);
     }
+    m_stream.flush();
+  }
 
-    /**
-     * \brief Returns the current no‐abort flag
-     * \return the current no‐abort flag
-     */
-    [[nodiscard]]
-    bool is_no_abort() const noexcept
+  inline void detail::stream_test_resource_reporter::print_lifetimes(const test_resource& tr)
+  {
+    const auto lifetimes = tr.lifetimes();
+
+    // the lifetime bucket counting the median block of the histogram 'buckets'
+    const auto median = [](const auto& buckets) noexcept {
+      long long total = 0LL;
+      for (const auto count : buckets)
+      {
+        total += count;
+      }
+      std::size_t i = 0U;
+      for (long long below = buckets[0]; 2LL * below < total; below += buckets[i])
+      {
+        ++i;
+      }
+      return i;
+    };
+    // the bucket 'i' as a range of the lifetimes
+    const auto range = [](std::size_t i) {
+      const auto min = test_resource_lifetimes::bucket_min(i);
+      if (i + 1U == test_resource_lifetimes::bucket_count)
+      {
+        return std::to_string(min) + " - ...";
+      }
+      const auto max = test_resource_lifetimes::bucket_min(i + 1U) - 1U;
+      return min == max ? std::to_string(min) : std::to_string(min) + " - " + std::to_string(max);
+    };
+
+    const auto prev_flags = m_stream.flags();
+    const auto prev_width = m_stream.width();
+    m_stream <<
+      " Median Lifetimes of Deallocated Memory Blocks:\n"
+      "      Size (Bytes)        Blocks          Allocations         Nanoseconds\n"
+      "      ------------        ------          -----------         -----------\n" << std::left;
+    for (std::size_t i = 0U; i < lifetimes.m_sizeClasses.size(); ++i)
     {
-      return m_noAbortFlag.load(std::memory_order_relaxed);
+      const auto& histogram = lifetimes.m_sizeClasses[i];
+      long long blocks = 0LL;
+      for (const auto count : histogram.m_allocations)
+      {
+        blocks += count;
+      }
+      if (0LL != blocks)
+      {
+        m_stream << "      " << std::setw(20U) << range(i) << std::setw(16U) << blocks
+          << std::setw(20U) << range(median(histogram.m_allocations))
+          << std::setw(prev_width) << range(median(histogram.m_nanoseconds)) << '\n';
+      }
     }
+    m_stream.setf(prev_flags);
 
-    /**
-     * \brief Returns the current quiet flag
-     * \return the current quiet flag
-     */
-    [[nodiscard]]
-    bool is_quiet() const noexcept
+    // the top sites only, the rest is available from lifetimes()
+    constexpr std::size_t max_candidates = 10U;
+    m_stream << " Arena Candidates (lifetime below " << default_short_lifetime << " allocations):\n";
+    for (std::size_t i = 0U; i < (std::min)(max_candidates, lifetimes.m_sites.size()); ++i)
     {
-      return m_quietFlag.load(std::memory_order_relaxed);
+      const auto& site = lifetimes.m_sites[i];
+      if (0LL == site.m_shortLivedBytes)
+      {
+        break;
+      }
+      m_stream << "   " << site.m_shortLivedBytes << " of " << site.m_bytes << " bytes in "
+        << site.m_blocks << " blocks";
+      print_frames(site.m_stackId);
     }
+  }
 
-    /**
-     * \brief Returns the current verbosity flag
-     * \return the current verbosity flag
-     */
-    [[nodiscard]]
-    bool is_verbose() const noexcept
+  inline void detail::stream_test_resource_reporter::print_latencies(const test_resource& tr)
+  {
+    const auto latencies = tr.latencies();
+
+    const auto print = [this](const char* name, const test_resource_latencies::percentiles& phase) {
+      m_stream << "\n      " << std::setw(20U) << name << std::setw(12U) << phase.m_p50
+        << std::setw(12U) << phase.m_p99 << std::setw(12U) << phase.m_p999 << phase.m_max;
+    };
+
+    m_stream <<
+      "\n------------------------------------------------------"
+      "\n      Latency (ns)        p50         p99         p99.9       max"
+      "\n      ------------        ---         ---         -----       ---";
+    print("ALLOCATE", latencies.m_allocations.m_total);
+    print("  lock wait", latencies.m_allocations.m_lockWait);
+    print("  bookkeeping", latencies.m_allocations.m_bookkeeping);
+    print("  upstream", latencies.m_allocations.m_upstream);
+    print("DEALLOCATE", latencies.m_deallocations.m_total);
+    print("  lock wait", latencies.m_deallocations.m_lockWait);
+    print("  bookkeeping", latencies.m_deallocations.m_bookkeeping);
+    print("  upstream", latencies.m_deallocations.m_upstream);
+  }
+
+  inline void detail::stream_test_resource_reporter::print_frames(std::uint32_t stack_id)
+  {
+    const auto* site = callsites().find(stack_id);
+    if (!site)
     {
-      return m_verboseFlag.load(std::memory_order_relaxed);
+      m_stream << " from an unknown call site\n";
+      return;
     }
+    m_stream << " from call site " << stack_id << ":\n";
+
+    report_buffer out{ m_stream };
+    write_frames(out, *site);
+  }
+
+  inline void detail::stream_test_resource_reporter::do_report_log_msg(const char* format, va_list args)
+  {
+    m_stream << formater_type::msg2str(format, args);
+  }
+
+  /**
+   * \brief Defines what the async_test_resource_reporter does with an event when its queue is full
+   */
+  enum class async_overflow
+  {
+    block,    // the reporting thread waits for the writer thread
+    drop,     // the event is dropped and counted
+    sample    // once the queue is half full only every N-th event is queued, the rest is dropped
+  };
+
+  /**
+   * \brief The reporter writing the allocations and the deallocations to the stream from a background
+   *        thread, so the verbose test_resource neither formats nor writes while holding its lock
+   * \note The events are captured into a bounded lock-free queue and written in the format of
+   *       the stream reporter, one flush per batch. The rare reports (the invalid blocks, the writes
+   *       after free, the state, the leaks and the messages) wait for the queued events and are
+   *       written by the stream reporter at once, so the order of the output is kept.
+   *       The names longer than max_name_length characters are truncated in the queued events.
+   */
+  class async_test_resource_reporter final : public test_resource_reporter
+  {
+  public:
+    static constexpr std::size_t default_capacity = 4096U;
+    static constexpr std::size_t default_sampling = 16U;
+    static constexpr std::size_t max_name_length = 79U;
 
     /**
-     * \brief Returns the name supplied to this test_resource at construction
-     * \return the name of this test_resource
+     * \param os the stream receiving the reports
+     * \param capacity the number of the queued events; rounded up to a power of two
+     * \param overflow the policy of the full queue
+     * \param sampling the rate of the events queued by async_overflow::sample
      */
-    [[nodiscard]]
-    std::string_view name() const noexcept
+    explicit async_test_resource_reporter(std::ostream& os,
+      std::size_t capacity = default_capacity,
+      async_overflow overflow = async_overflow::block,
+      std::size_t sampling = default_sampling)
+      : m_stream(os)
+      , m_target(os)
+      , m_events(new event[std::size_t{ 1U } << detail::bit_width((std::max)(capacity, std::size_t{ 2U }) - 1U)])
+      , m_mask((std::size_t{ 1U } << detail::bit_width((std::max)(capacity, std::size_t{ 2U }) - 1U)) - 1U)
+      , m_overflow(overflow)
+      , m_sampling((std::max)(sampling, std::size_t{ 1U }))
     {
-      return m_name;
+      for (std::size_t i = 0U; i <= m_mask; ++i)
+      {
+        m_events[i].m_sequence.store(i, std::memory_order_relaxed);
+      }
+      m_writer = std::thread([this] { run(); });
     }
 
-    /**
-     * \brief Returns the pointer to the upstream memory_resource supplied
-     *        to this test_resource at construction
-     * \return pointer to the upstream memory_resource
-     */
-    [[nodiscard]]
-    std::pmr::memory_resource* upstream_resource() const noexcept
+    ~async_test_resource_reporter() noexcept override
     {
-      return m_upstream;
+      flush();
+      {
+        std::lock_guard<std::mutex> guard{ m_wakeupLock };
+        m_stopped = true;
+      }
+      m_wakeup.notify_one();
+      m_writer.join();
     }
 
+    async_test_resource_reporter(const async_test_resource_reporter&) = delete;
+    async_test_resource_reporter& operator=(const async_test_resource_reporter&) = delete;
+
     /**
-     * \brief Returns the pointer to the last memory block successfully
-     *        allocated by this test_resource
-     * \return pointer to the last allocated memory block
+     * \brief Waits until the events queued so far are written and the stream is flushed
      */
-    [[nodiscard]]
-    void* last_allocated_address() const noexcept
+    void flush()
     {
-      return m_lastAllocatedAddress.load(std::memory_order_relaxed);
+      const std::uint64_t queued = m_enqueued.load(std::memory_order_acquire);
+      std::unique_lock<std::mutex> guard{ m_wakeupLock };
+      m_flushRequested = true;
+      m_wakeup.notify_one();
+      m_written.wait(guard, [this, queued] { return m_flushed >= queued; });
     }
 
     /**
-     * \brief Returns the requested number of bytes of the last memory
-     *        block successfully allocated by this test_resource
-     * \return requested number of bytes of the last memory block
+     * \brief Returns the number of the events dropped by the overflow policy
      */
     [[nodiscard]]
-    std::size_t last_allocated_bytes() const noexcept
+    long long dropped() const noexcept
     {
-      return m_lastAllocatedNumBytes.load(std::memory_order_relaxed);
+      return m_dropped.load(std::memory_order_relaxed);
     }
 
-    /**
-     * \brief Returns the requested alignment of the last memory block
-     *        successfully allocated by this test_resource
-     * \return the requested alignment of the last memory block
-     */
-    [[nodiscard]]
-    std::size_t last_allocated_alignment() const noexcept
+  private:
+    struct event
     {
-      return m_lastAllocatedAlignment.load(std::memory_order_relaxed);
+      std::atomic<std::uint64_t> m_sequence{ 0U };
+      const void*   m_address = nullptr;
+      long long     m_index = 0LL;
+      std::size_t   m_bytes = 0U;
+      std::size_t   m_alignment = 0U;
+      bool          m_deallocation = false;
+      bool          m_header = false;
+      std::uint8_t  m_nameLength = 0U;
+      char          m_name[max_name_length];
+    };
+
+    void do_report_allocation(const test_resource& tr) override
+    {
+      push(tr, false, tr.last_allocated_address(), tr.last_allocated_bytes(), tr.last_allocated_alignment());
     }
 
-    /**
-     * \brief Returns the pointer to the last memory block successfully
-     *        deallocated by this test_resource
-     * \return pointer to the last deallocated memory block
-     */
-    [[nodiscard]]
-    void* last_deallocated_address() const noexcept
+    void do_report_deallocation(const test_resource& tr) override
     {
-      return m_lastDeallocatedAddress.load(std::memory_order_relaxed);
+      push(tr, true, tr.last_deallocated_address(), tr.last_deallocated_bytes(), tr.last_deallocated_alignment());
     }
 
-    /**
-     * \brief Returns the requested number of bytes of the last memory block
-     *        successfully deallocated by this test_resource
-     * \return number of bytes of the last requested memory block
-     */
-    [[nodiscard]]
-    std::size_t last_deallocated_bytes() const noexcept
+    void do_report_release(const test_resource& tr) override
     {
-      return m_lastDeallocatedNumBytes.load(std::memory_order_relaxed);
+      flush();
+      std::lock_guard<std::mutex> guard{ m_streamLock };
+      m_target.report_release(tr);
     }
 
-    /**
-     * \brief Returns the requested alignment of the last memory block successfully
-     *        deallocated by this test_resource
-     * \return the requested alignment of the last deallocated memory block
-     */
-    [[nodiscard]]
-    std::size_t last_deallocated_alignment() const noexcept
+    void do_report_invalid_memory_block(
+      const test_resource& tr,
+      std::size_t deallocatedBytes,
+      std::size_t deallocatedAlignment,
+      int underrunBy,
+      int overrunBy) override
     {
-      return m_lastDeallocatedAlignment.load(std::memory_order_relaxed);
+      flush();
+      std::lock_guard<std::mutex> guard{ m_streamLock };
+      m_target.report_invalid_memory_block(tr, deallocatedBytes, deallocatedAlignment, underrunBy, overrunBy);
     }
 
-    /**
-     * \brief Returns the total number of allocations requested from this test_resource
-     * \return total number of allocations
-     * \note This number includes failed allocations too.
-     */
-    [[nodiscard]]
-    long long allocations() const noexcept
+    void do_report_write_after_free(
+      const test_resource& tr,
+      const void* address,
+      std::size_t bytes,
+      std::size_t alignment,
+      std::size_t offset) override
     {
-      return m_allocations.load(std::memory_order_relaxed);
+      flush();
+      std::lock_guard<std::mutex> guard{ m_streamLock };
+      m_target.report_write_after_free(tr, address, bytes, alignment, offset);
     }
 
-    /**
-     * \brief Returns the number of total deallocations requested from this test_resource
-     * \return total number of deallocations
-     * \note This number includes failed deallocations too.
-     */
-    [[nodiscard]]
-    long long deallocations() const noexcept
+    void do_report_print(const test_resource& tr) override
     {
-      return m_deallocations.load(std::memory_order_relaxed);
+      flush();
+      std::lock_guard<std::mutex> guard{ m_streamLock };
+      m_target.report_print(tr);
     }
 
-    /**
-     * \brief Returns the number of memory blocks still allocated by this test_resource
-     * \return the number of still used memory blocks
-     */
-    [[nodiscard]]
-    long long blocks_in_use() const noexcept
+    void do_report_log_msg(const char* format, va_list args) override
     {
-      return m_blocksInUse.load(std::memory_order_relaxed);
+      flush();
+      std::lock_guard<std::mutex> guard{ m_streamLock };
+      m_stream << detail::report_formater<char>::msg2str(format, args);
     }
 
-    /**
-     * \brief Returns the largest number of memory blocks allocated at
-     *        any given time by this test_resource
-     * \return the largest number of allocated memory blocks
-     */
-    [[nodiscard]]
-    long long max_blocks() const noexcept
+    // queues the event; the bounded multi-producer queue of D. Vyukov
+    void push(const test_resource& tr, bool deallocation, void* address, std::size_t bytes, std::size_t alignment)
     {
-      return m_maxBlocks.load(std::memory_order_relaxed);
+      if (async_overflow::sample == m_overflow &&
+          m_enqueued.load(std::memory_order_relaxed) - m_dequeued.load(std::memory_order_relaxed) > m_mask / 2U &&
+          0U != m_sampled.fetch_add(1U, std::memory_order_relaxed) % m_sampling)
+      {
+        m_dropped.fetch_add(1LL, std::memory_order_relaxed);
+        return;
+      }
+
+      event* cell = nullptr;
+      std::uint64_t position = m_enqueued.load(std::memory_order_relaxed);
+      for (;;)
+      {
+        cell = &m_events[position & m_mask];
+        const std::uint64_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+        if (sequence == position)
+        {
+          if (m_enqueued.compare_exchange_weak(position, position + 1U, std::memory_order_seq_cst))
+          {
+            break;
+          }
+        }
+        else if (sequence < position)
+        {
+          // the queue is full
+          if (async_overflow::block != m_overflow)
+          {
+            m_dropped.fetch_add(1LL, std::memory_order_relaxed);
+            return;
+          }
+          wake_writer();
+          std::this_thread::yield();
+          position = m_enqueued.load(std::memory_order_relaxed);
+        }
+        else
+        {
+          position = m_enqueued.load(std::memory_order_relaxed);
+        }
+      }
+
+      const auto* header = detail::get_header(address, alignment);
+      cell->m_address = address;
+      cell->m_index = header ? header->m_block.m_index : 0LL;
+      cell->m_bytes = bytes;
+      cell->m_alignment = alignment;
+      cell->m_deallocation = deallocation;
+      cell->m_header = nullptr != header;
+      const std::string_view name = tr.name();
+      cell->m_nameLength = static_cast<std::uint8_t>((std::min)(name.size(), max_name_length));
+      std::copy_n(name.data(), cell->m_nameLength, cell->m_name);
+      cell->m_sequence.store(position + 1U, std::memory_order_release);
+
+      // pairs with the writer storing m_sleeping before it reads m_enqueued
+      if (m_sleeping.load(std::memory_order_seq_cst))
+      {
+        wake_writer();
+      }
     }
 
-    /**
-     * \brief Returns the total number of memory blocks ever
-     *        successfully allocated by this test_resource
-     * \return total number of successfully allocated memory blocks
-     */
-    [[nodiscard]]
-    long long total_blocks() const noexcept
+    void wake_writer()
     {
-      return m_totalBlocks.load(std::memory_order_relaxed);
+      std::lock_guard<std::mutex> guard{ m_wakeupLock };
+      m_wakeup.notify_one();
     }
 
-    /**
-     * \brief Returns the number of buffer overruns and underruns detected
-     *        by this test_resource.
-     * \return the number of buffer overruns and underruns
-     */
-    [[nodiscard]]
-    long long bounds_errors() const noexcept
+    // writes the queued events until the queue is empty; called by the writer thread only
+    void write_events()
     {
-      return m_boundsErrors.load(std::memory_order_relaxed);
+      std::lock_guard<std::mutex> guard{ m_streamLock };
+      const std::uint64_t first = m_dequeued.load(std::memory_order_relaxed);
+      std::uint64_t position = first;
+      for (;;)
+      {
+        auto& cell = m_events[position & m_mask];
+        if (cell.m_sequence.load(std::memory_order_acquire) != position + 1U)
+        {
+          break;
+        }
+
+        // the text of detail::stream_test_resource_reporter
+        m_stream << "test_resource";
+        if (0U != cell.m_nameLength)
+        {
+          m_stream << ' ' << std::string_view(cell.m_name, cell.m_nameLength);
+        }
+        if (cell.m_header)
+        {
+          m_stream << " [" << cell.m_index << "]: " << (cell.m_deallocation ? "Deallocated " : "Allocated ")
+            << cell.m_bytes << " byte" << (cell.m_bytes == 1U ? "" : "s")
+            << " (aligned " << cell.m_alignment << ") at "
+            << detail::report_formater<char>::addr2str(const_cast<void*>(cell.m_address)) << '.';
+        }
+        m_stream << '\n';
+
+        cell.m_sequence.store(position + m_mask + 1U, std::memory_order_release);
+        m_dequeued.store(++position, std::memory_order_release);
+      }
+      if (position != first)
+      {
+        m_stream.flush();
+      }
     }
 
-    /**
-     * \brief Returns the number of mismatched deallocation size and
-     *        alignment parameters detected by this test_resource
-     * \return the number of mismatched deallocation size and
-     *         alignment parameters
-     */
-    [[nodiscard]]
-    long long bad_deallocate_params() const noexcept
+    void run()
     {
-      return m_badDeallocateParams.load(std::memory_order_relaxed);
+      std::unique_lock<std::mutex> guard{ m_wakeupLock };
+      for (;;)
+      {
+        const bool stopped = m_stopped;
+        m_flushRequested = false;
+        guard.unlock();
+        write_events();
+        guard.lock();
+
+        m_flushed = m_dequeued.load(std::memory_order_relaxed);
+        m_written.notify_all();
+        if (stopped)
+        {
+          return;
+        }
+
+        // the producers wake the writer once it is about to sleep
+        m_sleeping.store(true, std::memory_order_seq_cst);
+        if (m_enqueued.load(std::memory_order_seq_cst) == m_dequeued.load(std::memory_order_relaxed))
+        {
+          m_wakeup.wait_for(guard, std::chrono::milliseconds(100), [this] {
+            return m_stopped || m_flushRequested ||
+              m_enqueued.load(std::memory_order_relaxed) != m_dequeued.load(std::memory_order_relaxed);
+          });
+        }
+        m_sleeping.store(false, std::memory_order_relaxed);
+      }
     }
 
+    std::ostream& m_stream;
+    detail::stream_test_resource_reporter m_target;
+    std::mutex m_streamLock;
+
+    std::unique_ptr<event[]> m_events;
+    const std::size_t m_mask;
+    const async_overflow m_overflow;
+    const std::size_t m_sampling;
+    alignas(detail::cache_line_size) std::atomic<std::uint64_t> m_enqueued{ 0U };
+    alignas(detail::cache_line_size) std::atomic<std::uint64_t> m_dequeued{ 0U };
+    std::atomic_llong m_dropped{ 0LL };
+    std::atomic<std::uint64_t> m_sampled{ 0U };
+
+    std::mutex m_wakeupLock;
+    std::condition_variable m_wakeup;
+    std::condition_variable m_written;
+    std::atomic_bool m_sleeping{ false };
+    bool m_flushRequested = false;
+    bool m_stopped = false;
+    std::uint64_t m_flushed = 0U;
+    std::thread m_writer;
+  };
+
+  /**
+   * \brief The reporter collecting the allocations and the deallocations in a large buffer formatted
+   *        by std::to_chars, so the verbose test_resource does not write to the stream for every event
+   * \note The buffer is written out and the stream flushed when the buffer is full, on the first event
+   *       after the flush interval has passed, by flush() and by the destructor. The rare reports (the
+   *       invalid blocks, the writes after free, the state, the leaks and the messages) write the buffer
+   *       out first and flush the stream, so the events preceding an error reach the stream before
+   *       the test_resource aborts.
+   */
+  class buffered_test_resource_reporter final : public test_resource_reporter
+  {
+  public:
+    static constexpr std::size_t capacity = 65536U;
+    static constexpr std::chrono::milliseconds default_interval{ 100 };
+
     /**
-     * \brief Returns the number of mismatched deallocations detected by
-     *       this test_resource
-     * \return the number of mismatched deallocations
-     * \note Mismatched deallocations are deallocation attempts of memory
-     *       blocks not obtained from this test_resource.
+     * \param os the stream receiving the reports
+     * \param interval the longest time the events are kept in the buffer while the resource is busy
      */
-    [[nodiscard]]
-    long long mismatches() const noexcept
-    {
-      return m_mismatches.load(std::memory_order_relaxed);
-    }
+    explicit buffered_test_resource_reporter(std::ostream& os, std::chrono::milliseconds interval = default_interval)
+      : m_stream(os)
+      , m_target(os)
+      , m_interval(static_cast<std::uint64_t>(std::chrono::nanoseconds(interval).count()))
+      , m_lastWrite(detail::clock_nanoseconds())
+      , m_buffer(os)
+    {}
 
     /**
-     * \brief Returns the number of bytes currently allocated by this test_resource
-     * \return the number of bytes currently allocated
+     * \param filename the file receiving the reports
+     * \param mode the mode the file is opened in
+     * \param interval the longest time the events are kept in the buffer while the resource is busy
      */
-    [[nodiscard]]
-    long long bytes_in_use() const noexcept
+    explicit buffered_test_resource_reporter(const std::filesystem::path& filename,
+      std::ios_base::openmode mode = std::ios_base::out,
+      std::chrono::milliseconds interval = default_interval)
+      : m_file(filename, mode)
+      , m_stream(m_file)
+      , m_target(m_file)
+      , m_interval(static_cast<std::uint64_t>(std::chrono::nanoseconds(interval).count()))
+      , m_lastWrite(detail::clock_nanoseconds())
+      , m_buffer(m_file)
+    {}
+
+    ~buffered_test_resource_reporter() noexcept override
     {
-      return m_bytesInUse.load(std::memory_order_relaxed);
+      flush();
     }
 
+    buffered_test_resource_reporter(const buffered_test_resource_reporter&) = delete;
+    buffered_test_resource_reporter& operator=(const buffered_test_resource_reporter&) = delete;
+
     /**
-     * \brief Returns the largest number of bytes allocated at
-     *        any given time by this test_resource
-     * \return the largest number of allocated bytes
+     * \brief Writes the buffered events out and flushes the stream
      */
-    [[nodiscard]]
-    long long max_bytes() const noexcept
+    void flush()
     {
-      return m_maxBytes.load(std::memory_order_relaxed);
+      std::lock_guard<std::mutex> guard{ m_lock };
+      write_out();
     }
 
-    /**
-     * \brief Returns the total number of bytes ever successfully
-     *        allocated by this test_resource
-     * \return total number of successfully allocated bytes
-     */
     [[nodiscard]]
-    long long total_bytes() const noexcept
+    bool good() const
     {
-      return m_totalBytes.load(std::memory_order_relaxed);
+      return m_stream.good();
     }
 
-    /**
-     * \brief Returns the reporter assigned to the test_resource
-     * \return total number of successfully allocated bytes
-     */
-    [[nodiscard]]
-    test_resource_reporter* reporter() const noexcept
+  private:
+    void do_report_allocation(const test_resource& tr) override
     {
-      return m_reporter;
+      write_event(tr, "Allocated ", tr.last_allocated_address(), tr.last_allocated_bytes(), tr.last_allocated_alignment());
     }
 
-    /**
-     * \brief Detects an error
-     * \return false if mismatches() and bounds_errors() and bad_deallocate_params() all return zero
-     *         and true otherwise
-     */
-    [[nodiscard]]
-    bool has_errors() const noexcept
+    void do_report_deallocation(const test_resource& tr) override
     {
-      return mismatches() != 0LL ||
-        bounds_errors() != 0LL ||
-        bad_deallocate_params() != 0LL;
+      write_event(tr, "Deallocated ", tr.last_deallocated_address(), tr.last_deallocated_bytes(), tr.last_deallocated_alignment());
     }
 
-    /**
-     * \brief Detects any allocation
-     * \return true if blocks_in_use() or bytes_in_use() are greater than zero and false otherwise
-     * \note if either is non‐zero both are non‐zero
-     */
-    [[nodiscard]]
-    bool has_allocations() const noexcept
+    void do_report_release(const test_resource& tr) override
     {
-      return blocks_in_use() > 0LL || bytes_in_use() > 0LL;
+      std::lock_guard<std::mutex> guard{ m_lock };
+      m_buffer.flush();
+      m_target.report_release(tr);
+      write_out();
     }
 
-    /**
-     * \brief Get the status of test_resource
-     * \return 0 - if this test_resource has detected no errors and
-     *             it does not currently have any active allocations
-     *             (no memory leaks).
-     *         The number of detected errors if there are any.
-     *         ‐1 - if there are active allocations (but no errors).
-     */
-    [[nodiscard]]
-    long long status() const
+    void do_report_invalid_memory_block(
+      const test_resource& tr,
+      std::size_t deallocatedBytes,
+      std::size_t deallocatedAlignment,
+      int underrunBy,
+      int overrunBy) override
     {
       std::lock_guard<std::mutex> guard{ m_lock };
-
-      long long numErrors(mismatches());
-      numErrors += bounds_errors();
-      numErrors += bad_deallocate_params();
-
-      if (numErrors > 0LL)
-      {
-        return numErrors;
-      }
-
-      if (has_allocations())
-      {
-        return -1; //inidcation of memory leak
-      }
-
-      return 0; //success
+      m_buffer.flush();
+      m_target.report_invalid_memory_block(tr, deallocatedBytes, deallocatedAlignment, underrunBy, overrunBy);
+      write_out();
     }
 
-    void print() const
+    void do_report_write_after_free(
+      const test_resource& tr,
+      const void* address,
+      std::size_t bytes,
+      std::size_t alignment,
+      std::size_t offset) override
     {
       std::lock_guard<std::mutex> guard{ m_lock };
-      m_reporter->report_print(*this);
+      m_buffer.flush();
+      m_target.report_write_after_free(tr, address, bytes, alignment, offset);
+      write_out();
     }
 
-    void release() noexcept
+    void do_report_print(const test_resource& tr) override
     {
       std::lock_guard<std::mutex> guard{ m_lock };
-
-      if (is_verbose())
-      {
-        m_reporter->report_print(*this);
-      }
-
-      m_list->clear(m_upstream);
-      m_upstream->deallocate(m_list,
-        sizeof(detail::test_resource_list),
-        alignof(detail::test_resource_list));
-
-      if (!is_quiet())
-      {
-        m_reporter->report_release(*this);
-      }
+      m_buffer.flush();
+      m_target.report_print(tr);
+      write_out();
     }
 
-  private:
-    [[nodiscard]]
-    const detail::test_resource_list* test_resource_list() const
+    void do_report_log_msg(const char* format, va_list args) override
     {
-      return m_list;
+      std::lock_guard<std::mutex> guard{ m_lock };
+      m_buffer.flush();
+      m_stream << detail::report_formater<char>::msg2str(format, args);
+      write_out();
     }
 
-    template<std::size_t Align>
-    void* do_allocate_impl(std::size_t bytes, long long allocation_index)
+    // the text of detail::stream_test_resource_reporter
+    void write_event(const test_resource& tr, std::string_view action, void* address, std::size_t bytes, std::size_t alignment)
     {
-      auto* header = static_cast<detail::aligned_header<Align>*>(m_upstream->allocate(
-        detail::aligned_header_size_v<Align> + bytes + detail::padding_size, Align));
+      const auto* header = detail::get_header(address, alignment);
+      const std::string_view name = tr.name();
 
-      if (!header)
+      std::lock_guard<std::mutex> guard{ m_lock };
+      m_buffer << "test_resource";
+      if (!name.empty())
       {
-        // We cannot satisfy this request. Throw 'std::bad_alloc'.
-        throw std::bad_alloc();
+        m_buffer << ' ' << name;
       }
-
-      m_lastAllocatedNumBytes.store(static_cast<long long>(bytes), std::memory_order_relaxed);
-      m_lastAllocatedAlignment.store(static_cast<long long>(Align), std::memory_order_relaxed);
-
-      //initialize header padding + additional padding before the payload
-      memset(&header->m_object.m_padding,
-        std::to_integer<unsigned char>(detail::padded_memory_byte),
-        reinterpret_cast<std::byte*>(header + 1) - reinterpret_cast<std::byte*>(&header->m_object.m_padding));
-
-      //initialize padding after the payload
-      memset(reinterpret_cast<std::byte*>(header + 1) + bytes,
-        std::to_integer<unsigned char>(detail::padded_memory_byte),
-        detail::padding_size);
-
-      header->m_object.m_bytes = bytes;
-      header->m_object.m_alignment = Align;
-      header->m_object.m_magic_number = detail::allocated_memory_pattern;
-      header->m_object.m_index = allocation_index;
-
-      m_blocksInUse.fetch_add(1LL, std::memory_order_relaxed);
-      if (max_blocks() < blocks_in_use())
+      if (header)
       {
-        m_maxBlocks.store(blocks_in_use(), std::memory_order_relaxed);
+        m_buffer << " [" << header->m_block.m_index << "]: " << action
+          << bytes << " byte" << (bytes == 1U ? "" : "s")
+          << " (aligned " << alignment << ") at " << detail::report_address{ address } << '.';
       }
-      m_totalBlocks.fetch_add(1LL, std::memory_order_relaxed);
+      m_buffer << '\n';
 
-      m_bytesInUse.fetch_add(static_cast<long long>(bytes), std::memory_order_relaxed);
-      if (max_bytes() < bytes_in_use())
+      if (detail::clock_nanoseconds() - m_lastWrite >= m_interval)
       {
-        m_maxBytes.store(bytes_in_use(), std::memory_order_relaxed);
+        write_out();
       }
-      m_totalBytes.fetch_add(static_cast<long long>(bytes), std::memory_order_relaxed);
+    }
 
-      header->m_object.m_address = m_list->add_block(allocation_index, m_upstream);
-      header->m_object.m_pmr = this;
+    void write_out()
+    {
+      m_buffer.flush();
+      m_stream.flush();
+      m_lastWrite = detail::clock_nanoseconds();
+    }
 
-      void* address = ++header;
+    std::ofstream m_file;
+    std::ostream& m_stream;
+    detail::stream_test_resource_reporter m_target;
+    std::mutex m_lock;
+    const std::uint64_t m_interval;
+    std::uint64_t m_lastWrite;
+    detail::basic_report_buffer<capacity> m_buffer;
+  };
 
-      m_lastAllocatedAddress.store(address, std::memory_order_relaxed);
+  /**
+   * \brief The test_resource_monitor works in tandem with test_resource to observe changes
+   *        (or lack of changes) in the statistics collected by a test_resource.
+   * \note  Monitored statistics are based on number of memory blocks and do not depend
+   *        on the number of bytes in those allocated blocks.
+   */
+  class test_resource_monitor
+  {
+  public:
+    explicit test_resource_monitor(const test_resource& monitored) noexcept
+      : m_monitored(monitored)
+    {
+      reset();
+    }
 
-      if (is_verbose())
-      {
-        m_reporter->report_allocation(*this);
-      }
+    // To avoid binding the const ref arg to a temporary (above).
+    explicit test_resource_monitor(test_resource&&) = delete;
 
-      return address;
+    test_resource_monitor(const test_resource_monitor&) = delete;
+    test_resource_monitor& operator=(const test_resource_monitor&) = delete;
+
+    void reset() noexcept
+    {
+      const auto stats = m_monitored.snapshot();
+      m_initialInUse = stats.m_blocksInUse;
+      m_initialMax = stats.m_maxBlocks;
+      m_initialTotal = stats.m_totalBlocks;
     }
 
     [[nodiscard]]
-    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    bool is_in_use_down() const noexcept
     {
-      std::lock_guard<std::mutex> guard(m_lock);
-      const auto allocation_index = m_allocations.fetch_add(1, std::memory_order_relaxed);
-
-      if (0LL <= allocation_limit())
-      {
-        if (0LL > m_allocationLimit.fetch_add(-1LL, std::memory_order_relaxed) - 1LL)
-        {
-          throw test_resource_exception(this, bytes, alignment);
-        }
-      }
-
-      if (0U == alignment)
-      {
-        // Choose natural alignment for `bytes`
-        alignment = ((bytes ^ (bytes - 1U)) >> 1U) + 1U;
-        if (alignment > detail::max_natural_alignment)
-        {
-          alignment = detail::max_natural_alignment;
-        }
-      }
-
-      // alignment has to be power of two
-      if (!detail::is_power_of_two(alignment))
-      {
-        throw test_resource_exception(this, bytes, alignment);
-      }
-
-      switch (alignment)
-      {
-      case 1U:
-        return do_allocate_impl<1U>(bytes, allocation_index);
-      case 2U:
-        return do_allocate_impl<2U>(bytes, allocation_index);
-      case 4U:
-        return do_allocate_impl<4U>(bytes, allocation_index);
-      case 8U:
-        return do_allocate_impl<8U>(bytes, allocation_index);
-      case 16U:
-        return do_allocate_impl<16U>(bytes, allocation_index);
-      case 32U:
-        return do_allocate_impl<32U>(bytes, allocation_index);
-      case 64U:
-        return do_allocate_impl<64U>(bytes, allocation_index);
-      case 128U:
-        return do_allocate_impl<128U>(bytes, allocation_index);
-      case 256U:
-        return do_allocate_impl<256U>(bytes, allocation_index);
-      case 512U:
-        return do_allocate_impl<512U>(bytes, allocation_index);
-      case 1024U:
-        return do_allocate_impl<1024U>(bytes, allocation_index);
-      case 2048U:
-        return do_allocate_impl<2048U>(bytes, allocation_index);
-      case 4096U:
-        return do_allocate_impl<4096U>(bytes, allocation_index);
-      default:
-        // TODO: let data_cache_line_size be a default alignment value
-        // return do_allocate_impl<64U>(bytes, allocation_index);
-        throw test_resource_exception(this, bytes, alignment);
-      }
+      return m_monitored.snapshot().m_blocksInUse < m_initialInUse;
     }
 
-    template<size_t Align>
-    void do_deallocate_impl(void* p, std::size_t bytes)
+    [[nodiscard]]
+    bool is_in_use_same() const noexcept
     {
-      auto* header = static_cast<detail::aligned_header<Align>*>(p) - 1;
-
-      bool miscError = false;
-      bool paramError = false;
+      return m_monitored.snapshot().m_blocksInUse == m_initialInUse;
+    }
 
-      std::size_t size = 0U;
+    [[nodiscard]]
+    bool is_in_use_up() const noexcept
+    {
+      return m_monitored.snapshot().m_blocksInUse > m_initialInUse;
+    }
 
-      // The following checks are done deliberately in the order shown to avoid a
-      // possible bus error when attempting to read a misaligned 64-bit integer,
-      // which can happen if an invalid address is passed to this method. If the
-      // address of the memory being deallocated is misaligned, it is very likely
-      // that 'm_magicNumber' will not match the expected value, and so we will
-      // skip the reading of 'm_bytes_' (a 64-bit integer).
-      if ((detail::allocated_memory_pattern != header->m_object.m_magic_number) ||
-          (this != header->m_object.m_pmr))
-      {
-        miscError = true;
-      }
-      else
-      {
-        size = header->m_object.m_bytes;
-      }
+    [[nodiscard]]
+    bool is_max_same() const noexcept
+    {
+      return m_initialMax == m_monitored.snapshot().m_maxBlocks;
+    }
 
-      // If there is evidence of corruption, this memory may have already been
-      // freed.  On some platforms (but not others), the 'free' function will
-      // scribble freed memory. To get uniform behavior for test drivers, we
-      // deliberately don't check over/underruns if 'miscError' is 'true'.
-      int overrunBy = 0;
-      int underrunBy = 0;
+    [[nodiscard]]
+    bool is_max_up() const noexcept
+    {
+      return m_monitored.snapshot().m_maxBlocks != m_initialMax;
+    }
 
-      if (!miscError)
-      {
-        // Check the padding before the segment. Go backwards so we will
-        // report the trashed byte nearest the segment.
-        std::byte* pcBegin = static_cast<std::byte*>(p) - 1;
-        auto* pcEnd = reinterpret_cast<std::byte*>(&header->m_object.m_padding);
+    [[nodiscard]]
+    bool is_total_same() const noexcept
+    {
+      return m_monitored.snapshot().m_totalBlocks == m_initialTotal;
+    }
 
-        for (std::byte* pc = pcBegin; pcEnd <= pc; --pc)
-        {
-          if (detail::padded_memory_byte != *pc)
-          {
-            underrunBy = static_cast<int>(pcBegin + 1 - pc);
-            break;
-          }
-        }
+    [[nodiscard]]
+    bool is_total_up() const noexcept
+    {
+      return m_monitored.snapshot().m_totalBlocks != m_initialTotal;
+    }
 
-        if (!underrunBy)
-        {
-          // Check the padding after the segment.
-          std::byte* tail = static_cast<std::byte*>(p) + size;
-          pcBegin = tail;
-          pcEnd = tail + detail::padding_size;
-          for (std::byte* pc = pcBegin; pc < pcEnd; ++pc)
-          {
-            if (detail::padded_memory_byte != *pc)
-            {
-              overrunBy = static_cast<int>(pc + 1 - pcBegin);
-              break;
-            }
-          }
-        }
+    [[nodiscard]]
+    long long delta_blocks_in_use() const noexcept
+    {
+      return m_monitored.snapshot().m_blocksInUse - m_initialInUse;
+    }
 
-        if (bytes != size || Align != header->m_object.m_alignment)
-        {
-          paramError = true;
-        }
-      }
+    [[nodiscard]]
+    long long delta_max_blocks() const noexcept
+    {
+      return m_monitored.snapshot().m_maxBlocks - m_initialMax;
+    }
 
-      // Now check for corrupted memory block and cross allocation.
-      if (!miscError && !overrunBy && !underrunBy && !paramError)
-      {
-        m_upstream->deallocate(m_list->remove_block(header->m_object.m_address), sizeof(detail::block), alignof(detail::block));
-      }
-      else
-      { // Any error, count it, report it
-        if (miscError)
-        {
-          m_mismatches.fetch_add(1LL, std::memory_order_relaxed);
-        }
-        if (paramError)
-        {
-          m_badDeallocateParams.fetch_add(1LL, std::memory_order_relaxed);
-        }
-        if (overrunBy || underrunBy) {
-          m_boundsErrors.fetch_add(1LL, std::memory_order_relaxed);
-        }
+    [[nodiscard]]
+    long long delta_total_blocks() const noexcept
+    {
+      return m_monitored.snapshot().m_totalBlocks - m_initialTotal;
+    }
 
-        if (is_quiet())
-        {
-          return;
-        }
+  private:
+    long long            m_initialInUse = 0LL;
+    long long            m_initialMax = 0LL;
+    long long            m_initialTotal = 0LL;
+    const test_resource& m_monitored;
+  };
 
-        m_reporter->report_invalid_memory_block(
-          *this,
-          bytes,
-          Align,
-          underrunBy,
-          overrunBy);
+  namespace detail
+  {
+    /**
+     * \brief The writer of the text into the fixed buffer; the text not fitting
+     *        into the buffer is only counted
+     */
+    class fixed_text_buffer
+    {
+    public:
+      fixed_text_buffer(char* buffer, std::size_t size) noexcept
+        : m_buffer(buffer)
+        , m_capacity(size)
+      {}
 
-        if (is_no_abort())
+      fixed_text_buffer& operator<<(std::string_view text) noexcept
+      {
+        if (m_size < m_capacity)
         {
-          return;
+          const std::size_t count = (std::min)(text.size(), m_capacity - m_size);
+          std::copy(text.data(), text.data() + count, m_buffer + m_size);
         }
-
-        std::abort();
+        m_size += text.size();
+        return *this;
       }
 
-      // At this point we know (almost) for sure that the memory block is
-      // currently allocated from this object.  We now proceed to update our
-      // statistics, stamp the block's header as deallocated, scribble over its
-      // payload, and give it back to the underlying allocator supplied at
-      // construction. In verbose mode, we also report the deallocation event to
-      // 'outputSteam'.
-      m_lastDeallocatedNumBytes.store(static_cast<long long>(size), std::memory_order_relaxed);
-      m_lastDeallocatedAlignment.store(static_cast<long long>(Align), std::memory_order_relaxed);
-
-      m_blocksInUse.fetch_add(-1LL, std::memory_order_relaxed);
-      m_bytesInUse.fetch_add(-static_cast<long long>(size), std::memory_order_relaxed);
-
-      header->m_object.m_magic_number = detail::deallocated_memory_pattern;
-      memset(p, static_cast<int>(detail::scribbled_memory_byte), size);
+      fixed_text_buffer& operator<<(char c) noexcept
+      {
+        return *this << std::string_view(&c, 1U);
+      }
 
-      if (is_verbose())
+      template<typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+      fixed_text_buffer& operator<<(T value) noexcept
       {
-        m_reporter->report_deallocation(*this);
+        char digits[3U * sizeof(T) + 1U];
+        const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+        return *this << std::string_view(digits, static_cast<std::size_t>(result.ptr - digits));
       }
 
-      m_upstream->deallocate(header, detail::aligned_header_size_v<Align> + size + detail::padding_size, Align);
+      // the length of the whole text
+      [[nodiscard]]
+      std::size_t size() const noexcept
+      {
+        return m_size;
+      }
 
-      // the deallocation via upstream may modify the magicnumber and data in user area
-      //header->m_object.m_magic_number = detail::deallocated_memory_pattern;
-      //memset(p, static_cast<int>(detail::scribbled_memory_byte), size);
-    }
+    private:
+      char*       m_buffer;
+      std::size_t m_capacity;
+      std::size_t m_size = 0U;
+    };
 
-    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    // writes the 'name' label of the resource, escaped as the OpenMetrics label value
+    inline void write_name_label(fixed_text_buffer& out, const test_resource& tr) noexcept
     {
-      std::lock_guard<std::mutex> guard(m_lock);
-
-      m_deallocations.fetch_add(1LL, std::memory_order_relaxed);
-      m_lastDeallocatedAddress.store(p, std::memory_order_relaxed);
-
-      if (!p)
+      out << "{name=\"";
+      for (const char c : tr.name())
       {
-        if (0U != bytes)
-        {
-          m_badDeallocateParams.fetch_add(1LL, std::memory_order_relaxed);
-          if (!is_quiet())
-          {
-            m_reporter->report_log_msg("*** Freeing a nullptr using non-zero size (%zu) with alignment (%zu). ***\n",
-              bytes,
-              alignment);
-
-            if (!is_no_abort())
-            {
-              std::abort();
-            }
-          }
-        }
-        else
+        switch (c)
         {
-          m_lastDeallocatedNumBytes.store(0U, std::memory_order_relaxed);
-          m_lastDeallocatedAlignment.store(alignment, std::memory_order_relaxed);
+        case '\\':
+          out << "\\\\";
+          break;
+        case '"':
+          out << "\\\"";
+          break;
+        case '\n':
+          out << "\\n";
+          break;
+        default:
+          out << c;
         }
-        return;
       }
+      out << '"';
+    }
 
-      if (0U == alignment)
+    // writes the metric family of one sample per resource
+    inline void write_metric_family(fixed_text_buffer& out, const test_resource* const* resources,
+      const test_resource_stats* stats, std::size_t count, std::string_view name, std::string_view type,
+      std::string_view help, long long test_resource_stats::* field) noexcept
+    {
+      const bool counter = "counter" == type;
+      out << "# TYPE " << name << ' ' << type << "\n# HELP " << name << ' ' << help << '\n';
+      for (std::size_t i = 0U; i < count; ++i)
       {
-        // Choose natural alignment for `bytes`
-        alignment = ((bytes ^ (bytes - 1U)) >> 1U) + 1U;
-        if (alignment > detail::max_natural_alignment)
-        {
-          alignment = detail::max_natural_alignment;
-        }
+        out << name << (counter ? "_total" : "");
+        write_name_label(out, *resources[i]);
+        out << "} " << stats[i].*field << '\n';
       }
+    }
+  }
 
-      // alignment has to be power of two
-      if (!detail::is_power_of_two(alignment))
-      {
-        throw test_resource_exception(this, bytes, alignment);
-      }
+  /**
+   * \brief Writes the statistics of the resources in the OpenMetrics text format
+   * \param buffer the buffer receiving the text
+   * \param size the size of the buffer
+   * \param resources the resources, labelled by their names
+   * \param stats the snapshot() of every resource
+   * \param histograms the histograms() of every resource
+   * \param count the number of the resources
+   * \return the length of the whole text; the text is complete only if it does not exceed 'size'
+   *         (like by snprintf, but no terminating null character is written)
+   * \note Nothing is allocated on the heap. All the metric families of a resource are
+   *       rendered from the same snapshot taken by the caller, so a too short buffer can be
+   *       retried with the same text. The size histogram has the _count and the _sum (the
+   *       allocated bytes), the alignment histogram (cumulative, the powers of two only)
+   *       the buckets only.
+   */
+  inline std::size_t write_openmetrics(char* buffer, std::size_t size, const test_resource* const* resources,
+    const test_resource_stats* stats, const test_resource_histograms* histograms, std::size_t count) noexcept
+  {
+    detail::fixed_text_buffer out{ buffer, size };
 
-      switch (alignment)
-      {
-      case 1U:
-        return do_deallocate_impl<1U>(p, bytes);
-      case 2U:
-        return do_deallocate_impl<2U>(p, bytes);
-      case 4U:
-        return do_deallocate_impl<4U>(p, bytes);
-      case 8U:
-        return do_deallocate_impl<8U>(p, bytes);
-      case 16U:
-        return do_deallocate_impl<16U>(p, bytes);
-      case 32U:
-        return do_deallocate_impl<32U>(p, bytes);
-      case 64U:
-        return do_deallocate_impl<64U>(p, bytes);
-      case 128U:
-        return do_deallocate_impl<128U>(p, bytes);
-      case 256U:
-        return do_deallocate_impl<256U>(p, bytes);
-      case 512U:
-        return do_deallocate_impl<512U>(p, bytes);
-      case 1024U:
-        return do_deallocate_impl<1024U>(p, bytes);
-      case 2048U:
-        return do_deallocate_impl<2048U>(p, bytes);
-      case 4096U:
-        return do_deallocate_impl<4096U>(p, bytes);
-      default:
-        // TODO: let data_cache_line_size be a default alignment value
-        // return do_deallocate_impl<64U>(p, bytes);
-        throw test_resource_exception(this, bytes, alignment);
+    const auto family = [&out, resources, stats, count](std::string_view name, std::string_view type,
+      std::string_view help, long long test_resource_stats::* field) noexcept {
+      detail::write_metric_family(out, resources, stats, count, name, type, help, field);
+    };
+    family("test_resource_allocation_requests", "counter", "Allocation requests, the failed ones included.",
+      &test_resource_stats::m_allocations);
+    family("test_resource_deallocation_requests", "counter", "Deallocation requests, the invalid ones included.",
+      &test_resource_stats::m_deallocations);
+    family("test_resource_allocated_blocks", "counter", "Successfully allocated blocks.",
+      &test_resource_stats::m_totalBlocks);
+    family("test_resource_allocated_bytes", "counter", "Bytes of the successfully allocated blocks.",
+      &test_resource_stats::m_totalBytes);
+    family("test_resource_blocks_in_use", "gauge", "Outstanding blocks.",
+      &test_resource_stats::m_blocksInUse);
+    family("test_resource_bytes_in_use", "gauge", "Bytes of the outstanding blocks.",
+      &test_resource_stats::m_bytesInUse);
+    family("test_resource_max_blocks_in_use", "gauge", "High-water mark of the outstanding blocks.",
+      &test_resource_stats::m_maxBlocks);
+    family("test_resource_max_bytes_in_use", "gauge", "High-water mark of the bytes of the outstanding blocks.",
+      &test_resource_stats::m_maxBytes);
+    family("test_resource_mismatches", "counter", "Deallocations of the blocks not allocated by the resource.",
+      &test_resource_stats::m_mismatches);
+    family("test_resource_bounds_errors", "counter", "Deallocations of the blocks with the overwritten paddings.",
+      &test_resource_stats::m_boundsErrors);
+    family("test_resource_bad_deallocate_params", "counter", "Deallocations with the wrong size or alignment.",
+      &test_resource_stats::m_badDeallocateParams);
+    family("test_resource_writes_after_free", "counter", "Deallocated blocks written after the deallocation.",
+      &test_resource_stats::m_writesAfterFree);
+
+    out << "# TYPE test_resource_allocation_size_bytes histogram"
+      "\n# HELP test_resource_allocation_size_bytes Sizes of the successful allocations.\n";
+    for (std::size_t i = 0U; i < count; ++i)
+    {
+      const auto& sizes = histograms[i].m_sizes;
+      long long cumulative = 0LL;
+      for (std::size_t bucket = 0U; bucket < sizes.size(); ++bucket)
+      {
+        cumulative += sizes[bucket];
+        // the buckets of one power of two are merged
+        if (0U == (bucket + 1U) % test_resource_histograms::sub_buckets && bucket + 1U < sizes.size())
+        {
+          out << "test_resource_allocation_size_bytes_bucket";
+          detail::write_name_label(out, *resources[i]);
+          out << ",le=\"" << test_resource_histograms::size_bucket_min(bucket + 1U) - 1U << "\"} " << cumulative << '\n';
+        }
       }
+      out << "test_resource_allocation_size_bytes_bucket";
+      detail::write_name_label(out, *resources[i]);
+      out << ",le=\"+Inf\"} " << cumulative << "\ntest_resource_allocation_size_bytes_count";
+      detail::write_name_label(out, *resources[i]);
+      out << "} " << cumulative << "\ntest_resource_allocation_size_bytes_sum";
+      detail::write_name_label(out, *resources[i]);
+      out << "} " << stats[i].m_totalBytes << '\n';
     }
 
-    [[nodiscard]]
-    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    out << "# TYPE test_resource_allocation_alignment_bytes histogram"
+      "\n# HELP test_resource_allocation_alignment_bytes Alignments of the successful allocations.\n";
+    for (std::size_t i = 0U; i < count; ++i)
     {
-      return this == &other;
+      const auto& alignments = histograms[i].m_alignments;
+      long long cumulative = 0LL;
+      for (std::size_t bucket = 0U; bucket + 1U < alignments.size(); ++bucket)
+      {
+        cumulative += alignments[bucket];
+        out << "test_resource_allocation_alignment_bytes_bucket";
+        detail::write_name_label(out, *resources[i]);
+        out << ",le=\"" << test_resource_histograms::alignment_of_bucket(bucket) << "\"} " << cumulative << '\n';
+      }
+      // without the sum of the alignments there is no _count either
+      cumulative += alignments.back();
+      out << "test_resource_allocation_alignment_bytes_bucket";
+      detail::write_name_label(out, *resources[i]);
+      out << ",le=\"+Inf\"} " << cumulative << '\n';
     }
 
-    mutable std::mutex m_lock{};
-    std::string_view m_name{};
-
-    std::atomic_bool m_noAbortFlag{ false };
-    std::atomic_bool m_quietFlag{ false };
-    std::atomic_bool m_verboseFlag{ false };
-    std::atomic_llong m_allocationLimit{ -1LL };
-
-    std::atomic_llong m_allocations{ 0LL };
-    std::atomic_llong m_deallocations{ 0LL };
-    std::atomic_llong m_blocksInUse{ 0LL };
-    std::atomic_llong m_maxBlocks{ 0LL };
-    std::atomic_llong m_totalBlocks{ 0LL };
-    std::atomic_llong m_boundsErrors{ 0LL };
-    std::atomic_llong m_badDeallocateParams{ 0LL };
-    std::atomic_llong m_mismatches{ 0LL };
-
-    std::atomic_llong m_bytesInUse{ 0LL };
-    std::atomic_llong m_maxBytes{ 0LL };
-    std::atomic_llong m_totalBytes{ 0LL };
-
-    std::atomic<void*> m_lastAllocatedAddress{ nullptr };
-    std::atomic<void*> m_lastDeallocatedAddress{ nullptr };
-
-    std::atomic_size_t m_lastAllocatedNumBytes{ 0U };
-    std::atomic_size_t m_lastDeallocatedNumBytes{ 0U };
-
-    std::atomic_size_t m_lastAllocatedAlignment{ 0U };
-    std::atomic_size_t m_lastDeallocatedAlignment{ 0U };
-
-    detail::test_resource_list* m_list{ nullptr };
-
-    test_resource_reporter* m_reporter{ nullptr };
+    out << "# EOF\n";
+    return out.size();
+  }
 
-    //upstream resource from which to allocate
-    std::pmr::memory_resource* m_upstream = std::pmr::get_default_resource();
-  };
+  /**
+   * \brief Writes the statistics of the resource 'tr' in the OpenMetrics text format
+   * \see write_openmetrics(char*, std::size_t, const test_resource* const*,
+   *      const test_resource_stats*, const test_resource_histograms*, std::size_t)
+   */
+  inline std::size_t write_openmetrics(char* buffer, std::size_t size, const test_resource& tr) noexcept
+  {
+    const test_resource* resources[] = { &tr };
+    const test_resource_stats stats = tr.snapshot();
+    const test_resource_histograms histograms = tr.histograms();
+    return write_openmetrics(buffer, size, resources, &stats, &histograms, 1U);
+  }
 
   /**
-   * \brief The default resource guard is a simple RAII class that supports
-   *        installing a new default polymorphic memory resource and then restoring
-   *        of the original default polymorphic memory resource in its destructor.
+   * \brief Keeps the OpenMetrics exposition of the resources current in a file,
+   *        e.g. for the textfile collector of the Prometheus node exporter
+   * \note The file is rewritten by a background thread every 'interval' (and on destruction)
+   *       through a temporary file renamed over it, so a reader never sees a partial text.
+   *       The resources must outlive the exporter.
    */
-  class [[maybe_unused]] default_resource_guard final
+  class test_resource_metrics_exporter
   {
   public:
-    explicit default_resource_guard(std::pmr::memory_resource* newDefault) noexcept
+    test_resource_metrics_exporter(std::filesystem::path path, std::vector<const test_resource*> resources,
+      std::chrono::milliseconds interval)
+      : m_path(std::move(path))
+      , m_resources(std::move(resources))
+      , m_stats(m_resources.size())
+      , m_histograms(m_resources.size())
+      , m_interval(interval)
     {
-      if (newDefault)
-      {
-        m_oldDefault = std::pmr::set_default_resource(newDefault);
-      }
+      refresh();
+      m_thread = std::thread([this] { run(); });
     }
 
-    default_resource_guard(const default_resource_guard&) = delete;
-    default_resource_guard& operator=(const default_resource_guard&) = delete;
-
-    ~default_resource_guard() noexcept
+    ~test_resource_metrics_exporter()
     {
-      // if m_oldDefault is nullPtr, the set_default_resource sets
-      // a std::pmr::new_delete_resource as default one
-      std::pmr::set_default_resource(m_oldDefault);
+      {
+        std::lock_guard<std::mutex> guard{ m_lock };
+        m_stopped = true;
+      }
+      m_wakeup.notify_one();
+      m_thread.join();
+      refresh();
     }
 
-  private:
-    std::pmr::memory_resource* m_oldDefault{ nullptr };
-  };
-
-  template<typename F>
-  void exception_test_loop(test_resource& tr, F&& f)
-  {
-    const auto orig_allocation_limit = tr.allocation_limit();
+    test_resource_metrics_exporter(const test_resource_metrics_exporter&) = delete;
+    test_resource_metrics_exporter& operator=(const test_resource_metrics_exporter&) = delete;
 
-    for (long long exceptionCounter = 0LL; true; ++exceptionCounter)
+    /**
+     * \brief Rewrites the file now
+     * \return false if the file could not be written
+     */
+    bool refresh()
     {
-      try
+      std::lock_guard<std::mutex> guard{ m_refreshLock };
+
+      for (std::size_t i = 0U; i < m_resources.size(); ++i)
       {
-        tr.set_allocation_limit(exceptionCounter);
-        std::invoke(std::forward<decltype(f)>(f), tr);
-        tr.set_allocation_limit(orig_allocation_limit);
-        return;
+        m_stats[i] = m_resources[i]->snapshot();
+        m_histograms[i] = m_resources[i]->histograms();
       }
-      catch (const test_resource_exception& e)
+
+      // the buffer is kept and grows to the largest exposition
+      const auto write = [this] {
+        return write_openmetrics(m_buffer.data(), m_buffer.size(), m_resources.data(), m_stats.data(),
+          m_histograms.data(), m_resources.size());
+      };
+      std::size_t size = write();
+      if (size > m_buffer.size())
       {
-        tr.set_allocation_limit(orig_allocation_limit);
+        m_buffer.resize(size + size / 4U);
+        size = write();
+      }
 
-        if (e.originating_resource() != &tr)
+      auto temporary = m_path;
+      temporary += ".tmp";
+      {
+        std::ofstream file{ temporary, std::ios::binary | std::ios::trunc };
+        file.write(m_buffer.data(), static_cast<std::streamsize>((std::min)(size, m_buffer.size())));
+        if (!file)
         {
-          tr.reporter()->report_log_msg(
-            "  *** test_resource_exception from unexpected test resource: %p %.*s ***\n",
-            static_cast<void*>(e.originating_resource()),
-            static_cast<int>(e.originating_resource()->name().length()),
-            e.originating_resource()->name().data());
-          throw;
+          return false;
         }
+      }
+      std::error_code error;
+      std::filesystem::rename(temporary, m_path, error);
+      return !error;
+    }
 
-        if (tr.is_verbose())
-        {
-          tr.reporter()->report_log_msg(
-            "  *** test_resource_exception: alloc limit = %lld, last alloc size = %zu, align = %zu ***\n",
-            exceptionCounter,
-            e.size(),
-            e.alignment());
-        }
+  private:
+    void run()
+    {
+      std::unique_lock<std::mutex> guard{ m_lock };
+      while (!m_wakeup.wait_for(guard, m_interval, [this] { return m_stopped; }))
+      {
+        guard.unlock();
+        refresh();
+        guard.lock();
       }
     }
-  }
 
-  inline
-  const detail::test_resource_list*
-  test_resource_reporter::test_resource_list(const test_resource& tr) noexcept
-  {
-    return tr.test_resource_list();
-  }
+    std::filesystem::path                 m_path;
+    std::vector<const test_resource*>     m_resources;
+    // the statistics of the last refresh, one of each per resource
+    std::vector<test_resource_stats>      m_stats;
+    std::vector<test_resource_histograms> m_histograms;
+    std::chrono::milliseconds             m_interval;
+    std::vector<char>                     m_buffer;
+    std::mutex                            m_refreshLock;
+    std::mutex                            m_lock;
+    std::condition_variable               m_wakeup;
+    bool                                  m_stopped = false;
+    std::thread                           m_thread;
+  };
 
-  inline void detail::stream_test_resource_reporter::do_report_allocation(const test_resource& tr)
+  /**
+   * \brief Publishes the usage counters of the test_resource instances in a shared
+   *        memory file, so they can be watched by another process (e.g. test_resource_top)
+   * \note Only the resources constructed while the page is open are published; their
+   *       counters are kept in the page itself, the allocation path does not change.
+   *       The page has a fixed binary layout with a version number and one record with
+   *       a sequence lock per resource (see detail::stats_page_header). Linux only.
+   */
+  class test_resource_stats_page
   {
-    m_stream << "test_resource";
+  public:
+    // default number of the records of the page
+    static constexpr std::size_t default_capacity = 256U;
 
-    if (!tr.name().empty())
+    /**
+     * \brief Returns the default path of the statistics page of the process 'pid'
+     * \param pid the process identifier
+     * \return "/dev/shm/stdx_pmr.<pid>"
+     */
+    [[nodiscard]]
+    static std::filesystem::path default_path(long long pid)
     {
-      m_stream << " " << tr.name();
+      return "/dev/shm/stdx_pmr." + std::to_string(pid);
     }
 
-    auto* address = tr.last_allocated_address();
-    const auto alignment = tr.last_allocated_alignment();
-    const auto bytes = tr.last_allocated_bytes();
-    const auto* header = detail::get_header(address, alignment);
-
-    if (header)
+    /**
+     * \brief Returns the default path of the statistics page of this process
+     */
+    [[nodiscard]]
+    static std::filesystem::path default_path()
     {
-      const auto allocation_index = header->m_index;
-
-      m_stream << " [" << allocation_index << "]: Allocated "
-        << bytes << " byte" << (bytes == 1U ? "" : "s")
-        << " (aligned " << alignment << ") at "
-        << formater_type::addr2str(address) << '.';
+#if defined(__linux__)
+      return default_path(static_cast<long long>(::getpid()));
+#else
+      return {};
+#endif
     }
 
-    m_stream << std::endl;
-  }
-
-  inline void detail::stream_test_resource_reporter::do_report_deallocation(const test_resource& tr)
-  {
-    m_stream << "test_resource";
-
-    if (!tr.name().empty())
+    /**
+     * \brief Creates the statistics page the test_resource instances constructed from now on are published in
+     * \param path the path of the file of the page
+     * \param capacity the number of the records; the resources not fitting in are not published
+     * \return false if the page is open already or the file could not be created
+     */
+    static bool open(const std::filesystem::path& path = default_path(), std::size_t capacity = default_capacity)
     {
-      m_stream << ' ' << tr.name();
+      return detail::stats_page::open(path, capacity);
     }
 
-    auto* address = tr.last_deallocated_address();
-    const auto alignment = tr.last_deallocated_alignment();
-    const auto bytes = tr.last_deallocated_bytes();
-    const auto* header = detail::get_header(address, alignment);
-
-    if (header)
+    /**
+     * \brief Stops publishing the new resources and removes the file of the page
+     */
+    static void close() noexcept
     {
-      const auto allocation_index = header->m_index;
-
-      m_stream << " [" << allocation_index << "]: Deallocated "
-        << bytes << " byte" << (bytes == 1U ? "" : "s")
-        << " (aligned " << alignment << ") at "
-        << formater_type::addr2str(address) << '.';
+      detail::stats_page::close();
     }
 
-    m_stream << std::endl;
-  }
-
-  inline void detail::stream_test_resource_reporter::do_report_invalid_memory_block(
-    const test_resource& tr,
-    std::size_t deallocatedBytes,
-    std::size_t deallocatedAlignment,
-    int underrunBy,
-    int overrunBy)
-  {
-    auto* payload = tr.last_deallocated_address();
-    auto* head = get_header(payload, deallocatedAlignment);
-    const auto* allocator = static_cast<const std::pmr::memory_resource*>(&tr);
-
-    const auto magicNumber = head->m_magic_number;
-    const auto numBytes = head->m_bytes;
-    const auto alignment = head->m_alignment;
-
-    if (allocated_memory_pattern != magicNumber)
+    /**
+     * \brief Returns whether the new resources are published
+     */
+    [[nodiscard]]
+    static bool is_open() noexcept
     {
-      if (deallocated_memory_pattern == magicNumber)
-      {
-        m_stream << "*** Deallocating previously deallocated memory at "
-          << formater_type::addr2str(payload) << ". ***\n";
-      }
-      else
-      {
-        const auto prev_fill = m_stream.fill();
-        const auto prev_width = m_stream.width();
-        m_stream << "*** Invalid magic number "
-          << std::hex << std::showbase << std::setw(8U) << std::setfill('0')
-          << magicNumber
-          << std::setfill(prev_fill) << std::setw(prev_width) << std::noshowbase << std::dec
-          << " at address " << formater_type::addr2str(payload) << ". ***\n";
-      }
+      return detail::stats_page::is_open();
     }
-    else
+  };
+
+  /**
+   * \brief The usage counters of one test_resource read from the statistics page
+   */
+  struct test_resource_page_entry
+  {
+    std::string   m_name;
+    std::size_t   m_slot = 0U;        // index of the record in the page
+    std::uint64_t m_generation = 0U;  // changes when the record is reused by another resource
+    long long     m_allocations = 0LL;
+    long long     m_blocksInUse = 0LL;
+    long long     m_maxBlocks = 0LL;
+    long long     m_bytesInUse = 0LL;
+    long long     m_maxBytes = 0LL;
+  };
+
+  /**
+   * \brief Maps the statistics page of a process read only and reads its records
+   */
+  class test_resource_stats_page_reader
+  {
+  public:
+    /**
+     * \param path the path of the file of the page
+     * \note is_open() is false if the file is missing or its layout is unknown.
+     */
+    explicit test_resource_stats_page_reader([[maybe_unused]] const std::filesystem::path& path) noexcept
     {
-      if (numBytes <= 0U)
-      {
-        m_stream << "*** Invalid (non-positive) byte count " << numBytes
-          << " at address " << formater_type::addr2str(payload) << ". *** \n";
-      }
-      if (deallocatedBytes != head->m_bytes)
+#if defined(__linux__)
+      const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (file < 0)
       {
-        m_stream << "*** Freeing segment at " << formater_type::addr2str(payload)
-          << " using wrong size (" << deallocatedBytes << " vs. " << numBytes  << "). ***\n";
+        return;
       }
-      if (deallocatedAlignment != head->m_alignment)
+      struct stat status {};
+      void* map = MAP_FAILED;
+      if (0 == ::fstat(file, &status) && static_cast<std::size_t>(status.st_size) >= sizeof(detail::stats_page_header))
       {
-        m_stream << "*** Freeing segment at " << formater_type::addr2str(payload)
-          << " using wrong alignment (" << deallocatedAlignment << " vs. " << alignment << "). ***\n";
+        m_length = static_cast<std::size_t>(status.st_size);
+        map = ::mmap(nullptr, m_length, PROT_READ, MAP_SHARED, file, 0);
       }
-      if (allocator != head->m_pmr)
+      ::close(file);
+      if (MAP_FAILED == map)
       {
-        m_stream << "*** Freeing segment at " << formater_type::addr2str(payload)
-          << " from wrong allocator. ***\n";
+        return;
       }
-      if (underrunBy)
-      {
-        m_stream << "*** Memory corrupted at " << underrunBy
-          << " bytes before " << numBytes << " byte segment at "
-          << formater_type::addr2str(payload) << ". ***\n";
 
-        m_stream << "Pad area before user segment:\n";
-        m_stream << formater_type::mem2str(
-          &head->m_padding,
-          static_cast<std::byte*>(payload) - reinterpret_cast<std::byte*>(&head->m_padding));
-      }
-      if (overrunBy)
+      const auto* header = static_cast<const detail::stats_page_header*>(map);
+      if (0 != std::memcmp(header->m_magic, detail::stats_page_magic, sizeof(detail::stats_page_magic)) ||
+          detail::stats_page_version != header->m_version ||
+          sizeof(detail::stats_page_header) != header->m_headerSize ||
+          sizeof(detail::stats_page_record) != header->m_recordSize ||
+          m_length < sizeof(detail::stats_page_header) + header->m_capacity * sizeof(detail::stats_page_record))
       {
-        m_stream << "*** Memory corrupted at " << overrunBy << " bytes after "
-          << numBytes << " byte segment at " << formater_type::addr2str(payload) << ". ***\n";
-
-        m_stream << "Pad area after user segment:\n";
-        m_stream << formater_type::mem2str(static_cast<std::byte*>(payload) + numBytes, padding_size);
+        ::munmap(map, m_length);
+        return;
       }
+      m_header = header;
+#endif
     }
 
-    m_stream << "Header + Padding:\n"
-      << formater_type::mem2str(head, static_cast<std::byte*>(payload) - reinterpret_cast<std::byte*>(head));
-    //let print 64 bytes when the header is "corrupted"
-    m_stream << "User segment:\n" << formater_type::mem2str(payload, std::min<std::size_t>(64U, numBytes));
-  }
-
-  inline void detail::stream_test_resource_reporter::do_report_release(const test_resource& tr)
-  {
-    if (tr.has_allocations())
+    ~test_resource_stats_page_reader()
     {
-      m_stream << "MEMORY_LEAK";
-      if (!tr.name().empty())
-      {
-        m_stream << " from " << tr.name();
-      }
-      m_stream <<
-        ":\n   Number of blocks in use = " << tr.blocks_in_use() <<
-        "\n   Number of bytes in use = " << tr.bytes_in_use() << std::endl;
-
-      if (!tr.is_no_abort())
+#if defined(__linux__)
+      if (nullptr != m_header)
       {
-        std::abort();
+        ::munmap(const_cast<detail::stats_page_header*>(m_header), m_length);
       }
+#endif
     }
-  }
 
-  inline void detail::stream_test_resource_reporter::do_report_print(const test_resource& tr)
-  {
-    m_stream <<
-      "\n======================================================"
-      "\n  TEST RESOURCE " << (!tr.name().empty() ? string_type(tr.name()) + " STATE" : "STATE") <<
-      "\n------------------------------------------------------";
+    test_resource_stats_page_reader(const test_resource_stats_page_reader&) = delete;
+    test_resource_stats_page_reader& operator=(const test_resource_stats_page_reader&) = delete;
 
-    const auto prev_flags = m_stream.flags();
-    const auto prev_width = m_stream.width();
-    m_stream <<
-      "\n        Category    Blocks          Bytes"
-      "\n        --------    ------          -----"
-      "\n          IN USE    " << std::left << std::setw(16U) << tr.blocks_in_use() << std::setw(prev_width) << tr.bytes_in_use() <<
-      "\n             MAX    " << std::setw(16U) << tr.max_blocks() << std::setw(prev_width) << tr.max_bytes() <<
-      "\n           TOTAL    " << std::setw(16U) << tr.total_blocks() << std::setw(prev_width) << tr.total_bytes() <<
-      "\n      MISMATCHES    " << tr.mismatches() <<
-      "\n   BOUNDS ERRORS    " << tr.bounds_errors() <<
-      "\n   PARAM. ERRORS    " << tr.bad_deallocate_params() <<
-      "\n--------------------------------------------------\n";
-    m_stream.setf(prev_flags);
+    [[nodiscard]]
+    bool is_open() const noexcept
+    {
+      return nullptr != m_header;
+    }
 
-    const auto* list = test_resource_list(tr);
-    if (!list->empty())
+    /**
+     * \brief Returns the identifier of the process publishing the page
+     */
+    [[nodiscard]]
+    long long pid() const noexcept
     {
-      m_stream << " Indices of Outstanding Memory Allocations:\n ";
+      return nullptr != m_header ? m_header->m_pid : 0LL;
+    }
 
-      const auto* mblock = list->m_head;
+    /**
+     * \brief Reads the records of the published resources
+     * \return the usage counters of the live resources in the order of the records
+     * \note The reader can't hold off the updates of the other process; the counters
+     *       of a resource updated without a pause are read inconsistently at worst.
+     */
+    [[nodiscard]]
+    std::vector<test_resource_page_entry> read() const
+    {
+      std::vector<test_resource_page_entry> entries;
+      if (nullptr == m_header)
+      {
+        return entries;
+      }
 
-      while (mblock)
+      const auto* records = reinterpret_cast<const detail::stats_page_record*>(m_header + 1);
+      for (std::uint32_t i = 0U; i < m_header->m_capacity; ++i)
       {
-        // Prints the indices of max 8 'block' objects
-        for (int i = 0; i < 8 && mblock; ++i)
+        const auto& record = records[i];
+        if (detail::stats_record_live != record.m_state.load(std::memory_order_acquire))
         {
-          m_stream << "  " << mblock->m_index;
-          mblock = mblock->m_next;
+          continue;
+        }
+
+        test_resource_page_entry entry;
+        entry.m_slot = i;
+        entry.m_generation = record.m_generation.load(std::memory_order_relaxed);
+        detail::stats_shard_values values{};
+        for (const auto& shard : record.m_shards)
+        {
+          values += detail::read_shard(shard, detail::optimistic_read_attempts);
+        }
+        entry.m_allocations = record.m_usage.m_allocations.load(std::memory_order_relaxed);
+        entry.m_blocksInUse = values.m_blocksInUse;
+        entry.m_maxBlocks = record.m_usage.m_maxBlocks.load(std::memory_order_relaxed);
+        entry.m_bytesInUse = values.m_bytesInUse;
+        entry.m_maxBytes = record.m_usage.m_maxBytes.load(std::memory_order_relaxed);
+
+        char name[detail::stats_page_name_size];
+        std::memcpy(name, record.m_name, sizeof(name));
+        name[sizeof(name) - 1U] = '\0';
+        entry.m_name = name;
+
+        // the record is skipped if it has been reused meanwhile
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (detail::stats_record_live == record.m_state.load(std::memory_order_relaxed) &&
+            entry.m_generation == record.m_generation.load(std::memory_order_relaxed))
+        {
+          entries.push_back(std::move(entry));
         }
-        m_stream << "\n ";
       }
+      return entries;
     }
 
-    m_stream.flush();
-  }
-
-  inline void detail::stream_test_resource_reporter::do_report_log_msg(const char* format, va_list args)
-  {
-    m_stream << formater_type::msg2str(format, args);
-  }
+  private:
+    const detail::stats_page_header* m_header = nullptr;
+    std::size_t                      m_length = 0U;
+  };
 
   /**
-   * \brief The test_resource_monitor works in tandem with test_resource to observe changes
-   *        (or lack of changes) in the statistics collected by a test_resource.
-   * \note  Monitored statistics are based on number of memory blocks and do not depend
-   *        on the number of bytes in those allocated blocks.
+   * \brief The measurements of one replay of an allocation trace
    */
-  class test_resource_monitor
+  struct test_resource_replay_result
   {
-  public:
-    explicit test_resource_monitor(const test_resource& monitored) noexcept
-      : m_initialInUse(monitored.blocks_in_use())
-      , m_initialMax(monitored.max_blocks())
-      , m_initialTotal(monitored.total_blocks())
-      , m_monitored(monitored)
+    using percentiles = detail::latency_percentiles;
+
+    std::uint64_t m_allocations = 0U;
+    std::uint64_t m_deallocations = 0U;
+    std::uint64_t m_failedAllocations = 0U; // the allocations thrown by the resource
+    double        m_seconds = 0.0;          // wall time of the replayed operations
+    percentiles   m_allocationLatency{};    // in nanoseconds
+    percentiles   m_deallocationLatency{};  // in nanoseconds
+    std::size_t   m_peakBytes = 0U;         // peak of the requested bytes in use
+    long long     m_peakFootprint = 0LL;    // peak of the bytes taken from the upstream resource
+
+    // the replayed operations per second
+    [[nodiscard]]
+    double throughput() const noexcept
     {
+      return m_seconds > 0.0 ? static_cast<double>(m_allocations + m_deallocations) / m_seconds : 0.0;
     }
+  };
 
-    // To avoid binding the const ref arg to a temporary (above).
-    explicit test_resource_monitor(test_resource&&) = delete;
-
-    test_resource_monitor(const test_resource_monitor&) = delete;
-    test_resource_monitor& operator=(const test_resource_monitor&) = delete;
+  /**
+   * \brief Replays an allocation trace written by test_resource_trace_recorder
+   *        against any std::pmr::memory_resource
+   * \note The trace is loaded once; the deallocations are matched to the allocations by
+   *       their addresses and replayed with the size and the alignment of the allocation.
+   *       The deallocations of the blocks allocated before the recording are skipped,
+   *       the blocks never deallocated in the trace are deallocated after the measurement.
+   */
+  class test_resource_trace_replay
+  {
+  public:
+    /**
+     * \brief Makes the resource under test on top of the upstream resource counting its footprint
+     */
+    using factory = std::function<std::unique_ptr<std::pmr::memory_resource>(std::pmr::memory_resource& upstream)>;
 
-    void reset() noexcept
+    /**
+     * \param path the path of the trace file
+     */
+    explicit test_resource_trace_replay(const std::filesystem::path& path)
     {
-      m_initialInUse = m_monitored.blocks_in_use();
-      m_initialMax = m_monitored.max_blocks();
-      m_initialTotal = m_monitored.total_blocks();
-    }
+      test_resource_trace_reader reader{ path };
+      if (!reader.is_open())
+      {
+        return;
+      }
+      m_valid = true;
 
-    [[nodiscard]]
-    bool is_in_use_down() const noexcept
-    {
-      return m_monitored.blocks_in_use() < m_initialInUse;
+      struct live_block
+      {
+        std::uint32_t m_slot;
+        std::size_t   m_bytes;
+        std::size_t   m_alignment;
+      };
+      std::unordered_map<std::uintptr_t, live_block> live;
+      m_operations.reserve(static_cast<std::size_t>(reader.events()));
+      test_resource_trace_event event;
+      while (reader.next(event))
+      {
+        if (event.m_thread >= m_streams.size())
+        {
+          m_streams.resize(event.m_thread + 1U);
+        }
+        m_streams[event.m_thread].push_back(static_cast<std::uint32_t>(m_operations.size()));
+        if (trace_operation::allocation == event.m_operation)
+        {
+          // a block at the address of a live one has lost its deallocation (dropped by the recorder)
+          const auto slot = static_cast<std::uint32_t>(m_slots++);
+          live[event.m_address] = { slot, event.m_bytes, event.m_alignment };
+          m_operations.push_back({ event.m_bytes, event.m_alignment, slot, event.m_operation });
+        }
+        else if (const auto found = live.find(event.m_address); live.end() != found)
+        {
+          const auto& block = found->second;
+          m_operations.push_back({ block.m_bytes, block.m_alignment, block.m_slot, event.m_operation });
+          live.erase(found);
+        }
+        else
+        {
+          m_streams[event.m_thread].pop_back();
+          ++m_unmatched;
+        }
+      }
     }
 
     [[nodiscard]]
-    bool is_in_use_same() const noexcept
+    bool is_open() const noexcept
     {
-      return m_monitored.blocks_in_use() == m_initialInUse;
+      return m_valid;
     }
 
+    /**
+     * \brief Returns the number of the replayed operations
+     */
     [[nodiscard]]
-    bool is_in_use_up() const noexcept
+    std::size_t operations() const noexcept
     {
-      return m_monitored.blocks_in_use() > m_initialInUse;
+      return m_operations.size();
     }
 
+    /**
+     * \brief Returns the number of the recording threads
+     */
     [[nodiscard]]
-    bool is_max_same() const noexcept
+    std::size_t threads() const noexcept
     {
-      return m_initialMax == m_monitored.max_blocks();
+      return m_streams.size();
     }
 
+    /**
+     * \brief Returns the number of the skipped deallocations of the unknown blocks
+     */
     [[nodiscard]]
-    bool is_max_up() const noexcept
+    std::size_t unmatched() const noexcept
     {
-      return m_monitored.max_blocks() != m_initialMax;
+      return m_unmatched;
     }
 
+    /**
+     * \brief Replays the trace against the resource made by 'make'
+     * \param make the factory of the resource under test; the resource may allocate
+     *        from the upstream passed, which counts the footprint
+     * \param threaded if true, the events of every recording thread are replayed by their
+     *        own thread (the deallocation of a block of another thread waits for its
+     *        allocation), otherwise all the events are replayed by the calling thread
+     * \return the measurements
+     * \note The threaded replay requires a thread safe resource.
+     * \note An allocation throwing an exception is counted as failed and the deallocation
+     *       of its block is skipped.
+     */
     [[nodiscard]]
-    bool is_total_same() const noexcept
+    test_resource_replay_result run(const factory& make, bool threaded = false) const
     {
-      return m_monitored.total_blocks() == m_initialTotal;
+      stats_test_resource upstream{ "replay_upstream", false, std::pmr::new_delete_resource() };
+      test_resource_replay_result result{};
+      {
+        const auto resource = make(upstream);
+        result = run(*resource, threaded);
+      }
+      result.m_peakFootprint = upstream.max_bytes();
+      return result;
     }
 
+    /**
+     * \brief Replays the trace against 'resource'
+     * \see run(const factory&, bool)
+     * \note The footprint is not measured.
+     */
     [[nodiscard]]
-    bool is_total_up() const noexcept
+    test_resource_replay_result run(std::pmr::memory_resource& resource, bool threaded = false) const
     {
-      return m_monitored.total_blocks() != m_initialTotal;
-    }
+      auto slots = std::make_unique<std::atomic<void*>[]>(m_slots);
+      auto latencies = std::make_unique<detail::latency_profile>();
+      std::atomic<std::uint64_t> failed_allocations{ 0U };
+      std::atomic_llong bytes_in_use{ 0LL };
+      std::atomic_llong peak_bytes{ 0LL };
+
+      const auto replay = [&](std::size_t thread) {
+        const std::size_t count = threaded ? m_streams[thread].size() : m_operations.size();
+        for (std::size_t i = 0U; i < count; ++i)
+        {
+          const auto& operation = m_operations[threaded ? m_streams[thread][i] : i];
+          auto& slot = slots[operation.m_slot];
+          const long long bytes = static_cast<long long>(operation.m_bytes);
+          if (trace_operation::allocation == operation.m_operation)
+          {
+            const std::uint64_t start = detail::trace_timestamp();
+            void* p = nullptr;
+            try
+            {
+              p = resource.allocate(operation.m_bytes, operation.m_alignment);
+            }
+            catch (...)
+            {
+              // the exception must not leave the replaying thread
+              failed_allocations.fetch_add(1U, std::memory_order_relaxed);
+              slot.store(failed_block(), std::memory_order_release);
+              continue;
+            }
+            const std::uint64_t stop = detail::trace_timestamp();
+            latencies->record(detail::allocation_operation, {}, stop - start);
+            slot.store(p, std::memory_order_release);
+            detail::atomic_store_max(peak_bytes, bytes_in_use.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+          }
+          else
+          {
+            // the block allocated by another thread may not be allocated yet
+            void* p = slot.exchange(nullptr, std::memory_order_acquire);
+            while (nullptr == p)
+            {
+              std::this_thread::yield();
+              p = slot.exchange(nullptr, std::memory_order_acquire);
+            }
+            if (failed_block() == p)
+            {
+              continue;
+            }
+            bytes_in_use.fetch_add(-bytes, std::memory_order_relaxed);
+            const std::uint64_t start = detail::trace_timestamp();
+            resource.deallocate(p, operation.m_bytes, operation.m_alignment);
+            const std::uint64_t stop = detail::trace_timestamp();
+            latencies->record(detail::deallocation_operation, {}, stop - start);
+          }
+        }
+      };
 
-    [[nodiscard]]
-    long long delta_blocks_in_use() const noexcept
-    {
-      return m_monitored.blocks_in_use() - m_initialInUse;
+      const std::uint64_t start_ticks = detail::trace_timestamp();
+      const std::uint64_t start = detail::clock_nanoseconds();
+      if (threaded)
+      {
+        std::vector<std::thread> threads;
+        for (std::size_t thread = 0U; thread < m_streams.size(); ++thread)
+        {
+          threads.emplace_back(replay, thread);
+        }
+        for (auto& thread : threads)
+        {
+          thread.join();
+        }
+      }
+      else
+      {
+        replay(0U);
+      }
+      const std::uint64_t nanoseconds = detail::clock_nanoseconds() - start;
+      const std::uint64_t elapsed_ticks = detail::trace_timestamp() - start_ticks;
+
+      // the blocks still allocated are not measured
+      for (const auto& operation : m_operations)
+      {
+        if (trace_operation::allocation == operation.m_operation)
+        {
+          void* p = slots[operation.m_slot].exchange(nullptr, std::memory_order_relaxed);
+          if (nullptr != p && failed_block() != p)
+          {
+            resource.deallocate(p, operation.m_bytes, operation.m_alignment);
+          }
+        }
+      }
+
+      const double nanoseconds_per_tick = 0U == elapsed_ticks ? 1.0
+        : static_cast<double>(nanoseconds) / static_cast<double>(elapsed_ticks);
+      const auto scale = [nanoseconds_per_tick](test_resource_replay_result::percentiles ticks) noexcept {
+        const auto convert = [nanoseconds_per_tick](std::uint64_t value) noexcept {
+          return static_cast<std::uint64_t>(static_cast<double>(value) * nanoseconds_per_tick + 0.5);
+        };
+        ticks.m_p50 = convert(ticks.m_p50);
+        ticks.m_p99 = convert(ticks.m_p99);
+        ticks.m_p999 = convert(ticks.m_p999);
+        ticks.m_max = convert(ticks.m_max);
+        return ticks;
+      };
+
+      test_resource_replay_result result{};
+      result.m_allocationLatency = scale(latencies->percentiles(detail::allocation_operation, detail::total_phase));
+      result.m_deallocationLatency = scale(latencies->percentiles(detail::deallocation_operation, detail::total_phase));
+      result.m_allocations = static_cast<std::uint64_t>(result.m_allocationLatency.m_count);
+      result.m_deallocations = static_cast<std::uint64_t>(result.m_deallocationLatency.m_count);
+      result.m_failedAllocations = failed_allocations.load(std::memory_order_relaxed);
+      result.m_seconds = static_cast<double>(nanoseconds) * 1e-9;
+      result.m_peakBytes = static_cast<std::size_t>(peak_bytes.load(std::memory_order_relaxed));
+      return result;
     }
 
-    [[nodiscard]]
-    long long delta_max_blocks() const noexcept
+  private:
+    // marks the slot of a failed allocation
+    static void* failed_block() noexcept
     {
-      return m_monitored.max_blocks() - m_initialMax;
+      static char marker;
+      return &marker;
     }
 
-    [[nodiscard]]
-    long long delta_total_blocks() const noexcept
+    struct replay_operation
     {
-      return m_monitored.total_blocks() - m_initialTotal;
-    }
+      std::size_t     m_bytes;
+      std::size_t     m_alignment;
+      std::uint32_t   m_slot;
+      trace_operation m_operation;
+    };
 
-  private:
-    long long            m_initialInUse;
-    long long            m_initialMax;
-    long long            m_initialTotal;
-    const test_resource& m_monitored;
+    // the operations in the order of the trace
+    std::vector<replay_operation> m_operations;
+    // the indexes of the operations of every recording thread
+    std::vector<std::vector<std::uint32_t>> m_streams;
+    std::size_t m_slots = 0U;
+    std::size_t m_unmatched = 0U;
+    bool        m_valid = false;
   };
 
   // C++20 enhancements of std::pmr::polymorphic_allocator
@@ -2209,6 +8360,85 @@ namespace stdx::pmr
       deallocate_bytes(p, n * sizeof(U), alignof(U));
     }
 
+    /**
+     * \brief Allocates 'count' storages for n objects of type U each using the underlying memory resource.
+     *        If the memory resource is a test_resource, the storages are allocated by its allocate_bulk().
+     * \tparam U the type of object
+     * \param objects the array receiving the pointers to the allocated storages
+     * \param count the number of storages to allocate
+     * \param n the number of objects of type U of every storage
+     * \note If any storage can't be allocated, none of them stays allocated and the exception is rethrown.
+     */
+    template<typename U>
+    void allocate_objects_bulk(U** objects, std::size_t count, std::size_t n = 1U)
+    {
+      std::size_t allocated = 0U;
+      try
+      {
+        if (auto* tr = dynamic_cast<test_resource*>(this->resource()))
+        {
+          void* blocks[bulk_batch_size];
+          while (allocated < count)
+          {
+            const std::size_t size = (std::min)(bulk_batch_size, count - allocated);
+            tr->allocate_bulk(blocks, size, n * sizeof(U), alignof(U));
+            for (std::size_t i = 0U; i < size; ++i)
+            {
+              objects[allocated + i] = static_cast<U*>(blocks[i]);
+            }
+            allocated += size;
+          }
+        }
+        else
+        {
+          for (; allocated < count; ++allocated)
+          {
+            objects[allocated] = allocate_object<U>(n);
+          }
+        }
+      }
+      catch (...)
+      {
+        deallocate_objects_bulk(objects, allocated, n);
+        throw;
+      }
+    }
+
+    /**
+     * \brief Deallocates 'count' storages of n objects of type U each, typically allocated
+     *        through a call to allocate_objects_bulk<U>(objects, count, n).
+     *        If the memory resource is a test_resource, the storages are deallocated by its deallocate_bulk().
+     * \tparam U the type of object
+     * \param objects the array of the pointers to the storages to deallocate
+     * \param count the number of storages to deallocate
+     * \param n the number of objects of type U of every storage
+     */
+    template<typename U>
+    void deallocate_objects_bulk(U* const* objects, std::size_t count, std::size_t n = 1U)
+    {
+      if (auto* tr = dynamic_cast<test_resource*>(this->resource()))
+      {
+        void* blocks[bulk_batch_size];
+        for (std::size_t deallocated = 0U; deallocated < count;)
+        {
+          const std::size_t size = (std::min)(bulk_batch_size, count - deallocated);
+          for (std::size_t i = 0U; i < size; ++i)
+          {
+            blocks[i] = objects[deallocated + i];
+          }
+          tr->deallocate_bulk(blocks, size, n * sizeof(U), alignof(U));
+          deallocated += size;
+        }
+      }
+      else
+      {
+        for (std::size_t i = 0U; i < count; ++i)
+        {
+          deallocate_object(objects[i], n);
+        }
+      }
+    }
+
     /**
      * \brief Allocates and constructs an object of type U.
      * \tparam U
@@ -2245,6 +8475,10 @@ namespace stdx::pmr
                // the std::destroy_at(p) can be utilized or direct call of type destructor.
       deallocate_object(p);
     }
+
+  private:
+    // the number of the storages passed to test_resource in one bulk request
+    static constexpr std::size_t bulk_batch_size = 256U;
   };
 }
 
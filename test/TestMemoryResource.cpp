@@ -4,7 +4,10 @@
 #include <gtest/gtest.h>
 
 #include <deque>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 inline constexpr bool g_verbose = true;
 
@@ -931,28 +934,28 @@ TEST(StdX_MemoryResource_aligned_header, size_and_alignment_verification)
   EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<64U>, 64U);
 
   // alignment 128
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<128U>, stdx::pmr::detail::checked_alignment(128U));
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<128U>, 128U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<128U>, 64U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<128U>, 64U);
 
   // alignment 256
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<256U>, stdx::pmr::detail::checked_alignment(256U));
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<256U>, 256U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<256U>, 64U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<256U>, 64U);
 
   // alignment 512
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<512U>, stdx::pmr::detail::checked_alignment(512U));
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<512U>, 512U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<512U>, 64U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<512U>, 64U);
 
   // alignment 1024
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<1024U>, stdx::pmr::detail::checked_alignment(1024U));
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<1024U>, 1024U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<1024U>, 64U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<1024U>, 64U);
 
   // alignment 2048
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<2048U>, stdx::pmr::detail::checked_alignment(2048U));
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<2048U>, 2048U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<2048U>, 64U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<2048U>, 64U);
 
   // alignment 4096
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<4096U>, stdx::pmr::detail::checked_alignment(4096U));
-  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<4096U>, 4096U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_align_v<4096U>, 64U);
+  EXPECT_EQ(stdx::pmr::detail::aligned_header_size_v<4096U>, 64U);
 }
 
 #ifdef __SANITIZE_ADDRESS__
@@ -1051,3 +1054,1627 @@ TEST(StdX_MemoryResource_test_resource, overwrite_padding_after_payload__output_
   }
   EXPECT_FALSE(std::filesystem::remove(filename));
 }
+
+TEST(StdX_MemoryResource_test_resource, statistics__concurrent_threads)
+{
+  constexpr int thread_count = 8;
+  constexpr int allocation_count = 1000;
+
+  stdx::pmr::test_resource tpmr{ "threads", false };
+  tpmr.set_no_abort(true);
+  {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t)
+    {
+      threads.emplace_back([&tpmr]() {
+        std::vector<void*> blocks;
+        blocks.reserve(allocation_count);
+        for (int i = 0; i < allocation_count; ++i)
+        {
+          blocks.push_back(tpmr.allocate(16U, 8U));
+        }
+        for (auto* p : blocks)
+        {
+          tpmr.deallocate(p, 16U, 8U);
+        }
+      });
+    }
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+  }
+
+  EXPECT_EQ(tpmr.allocations(), thread_count * allocation_count);
+  EXPECT_EQ(tpmr.deallocations(), thread_count * allocation_count);
+  EXPECT_EQ(tpmr.total_blocks(), thread_count * allocation_count);
+  EXPECT_EQ(tpmr.total_bytes(), 16LL * thread_count * allocation_count);
+  EXPECT_EQ(tpmr.blocks_in_use(), 0LL);
+  EXPECT_EQ(tpmr.bytes_in_use(), 0LL);
+  // the high-water mark is off by less than the unflushed blocks of the other shards
+  EXPECT_GE(tpmr.max_blocks(),
+    allocation_count - (thread_count - 1) * (stdx::pmr::detail::usage_flush_blocks - 1LL));
+  EXPECT_LE(tpmr.max_blocks(), thread_count * allocation_count);
+  EXPECT_EQ(tpmr.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, deallocation__concurrent_double_deallocation_is_reported)
+{
+  constexpr int rounds = 200;
+
+  // the upstream never reuses the memory, so the header of a deallocated block stays readable
+  std::pmr::monotonic_buffer_resource upstream{ std::pmr::new_delete_resource() };
+  stdx::pmr::test_resource tpmr{ "racing", false, &upstream };
+  tpmr.set_quiet(true);
+  tpmr.set_no_abort(true);
+
+  for (int round = 0; round < rounds; ++round)
+  {
+    void* p = tpmr.allocate(32U, 8U);
+    std::atomic_int ready{ 0 };
+    const auto deallocate = [&tpmr, &ready, p]() {
+      // both threads start deallocating at once
+      ready.fetch_add(1, std::memory_order_acq_rel);
+      while (ready.load(std::memory_order_acquire) < 2)
+      {
+      }
+      tpmr.deallocate(p, 32U, 8U);
+    };
+    std::thread first{ deallocate };
+    std::thread second{ deallocate };
+    first.join();
+    second.join();
+  }
+
+  // one of the threads deallocates the block, the other one finds it deallocated
+  EXPECT_EQ(tpmr.mismatches(), static_cast<long long>(rounds));
+  EXPECT_EQ(tpmr.blocks_in_use(), 0LL);
+  EXPECT_FALSE(tpmr.has_allocations());
+}
+
+TEST(StdX_MemoryResource_test_resource, statistics__blocks_deallocated_by_another_thread)
+{
+  stdx::pmr::test_resource tpmr{ "threads", false };
+
+  std::vector<void*> blocks(100U);
+  std::thread{ [&tpmr, &blocks]() {
+    for (auto& block : blocks)
+    {
+      block = tpmr.allocate(32U, 8U);
+    }
+  } }.join();
+  EXPECT_EQ(tpmr.blocks_in_use(), 100LL);
+  EXPECT_EQ(tpmr.bytes_in_use(), 3200LL);
+
+  // the in-use counters of the shard of this thread go negative
+  for (auto* block : blocks)
+  {
+    tpmr.deallocate(block, 32U, 8U);
+  }
+  const auto stats = tpmr.snapshot();
+  EXPECT_EQ(stats.m_blocksInUse, 0LL);
+  EXPECT_EQ(stats.m_bytesInUse, 0LL);
+  EXPECT_EQ(stats.m_maxBlocks, 100LL);
+  EXPECT_EQ(stats.m_maxBytes, 3200LL);
+  EXPECT_EQ(tpmr.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, allocation__single_upstream_block)
+{
+  stdx::pmr::test_resource upstream{ "upstream", false };
+  upstream.set_no_abort(true);
+  {
+    stdx::pmr::test_resource tpmr{ "tracked", false, &upstream };
+    tpmr.set_no_abort(true);
+
+    const stdx::pmr::test_resource_monitor monitor{ upstream };
+    void* p = tpmr.allocate(24U, 8U);
+    EXPECT_EQ(monitor.delta_blocks_in_use(), 1LL);
+    tpmr.deallocate(p, 24U, 8U);
+    EXPECT_EQ(monitor.delta_blocks_in_use(), 0LL);
+    EXPECT_EQ(tpmr.status(), 0LL);
+  }
+  EXPECT_EQ(upstream.status(), 0LL);
+}
+
+namespace
+{
+  class counting_test_resource_reporter final : public stdx::pmr::test_resource_reporter
+  {
+  public:
+    [[nodiscard]]
+    long long outstanding_blocks() const noexcept
+    {
+      return m_outstandingBlocks;
+    }
+
+    [[nodiscard]]
+    std::size_t write_after_free_offset() const noexcept
+    {
+      return m_writeAfterFreeOffset;
+    }
+
+  private:
+    void do_report_allocation(const stdx::pmr::test_resource&) override
+    {
+    }
+
+    void do_report_deallocation(const stdx::pmr::test_resource&) override
+    {
+    }
+
+    void do_report_release(const stdx::pmr::test_resource&) override
+    {
+    }
+
+    void do_report_invalid_memory_block(
+      const stdx::pmr::test_resource&,
+      std::size_t,
+      std::size_t,
+      int,
+      int) override
+    {
+    }
+
+    void do_report_write_after_free(
+      const stdx::pmr::test_resource&,
+      const void*,
+      std::size_t,
+      std::size_t,
+      std::size_t offset) override
+    {
+      m_writeAfterFreeOffset = offset;
+    }
+
+    void do_report_print(const stdx::pmr::test_resource& tr) override
+    {
+      m_outstandingBlocks = 0LL;
+      test_resource_list(tr)->for_each([this](const stdx::pmr::detail::block_info&) {
+        ++m_outstandingBlocks;
+      });
+    }
+
+    void do_report_log_msg(const char*, va_list) override
+    {
+    }
+
+    long long m_outstandingBlocks{ 0LL };
+    std::size_t m_writeAfterFreeOffset{ 0U };
+  };
+}
+
+TEST(StdX_MemoryResource_test_resource, print__outstanding_blocks_of_threads)
+{
+  constexpr int thread_count = 4;
+  constexpr int allocation_count = 100;
+
+  counting_test_resource_reporter reporter;
+  stdx::pmr::test_resource tpmr{ "threads", false, &reporter };
+  tpmr.set_no_abort(true);
+
+  std::vector<std::vector<void*>> blocks(thread_count);
+  {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t)
+    {
+      threads.emplace_back([&tpmr, &thread_blocks = blocks[t]]() {
+        for (int i = 0; i < allocation_count; ++i)
+        {
+          thread_blocks.push_back(tpmr.allocate(32U, 16U));
+        }
+      });
+    }
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+  }
+
+  tpmr.print();
+  EXPECT_EQ(reporter.outstanding_blocks(), thread_count * allocation_count);
+
+  // deallocate from other threads than the allocating ones
+  {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t)
+    {
+      threads.emplace_back([&tpmr, &thread_blocks = blocks[(t + 1) % thread_count]]() {
+        for (auto* p : thread_blocks)
+        {
+          tpmr.deallocate(p, 32U, 16U);
+        }
+      });
+    }
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+  }
+
+  tpmr.print();
+  EXPECT_EQ(reporter.outstanding_blocks(), 0LL);
+  EXPECT_EQ(tpmr.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_basic_test_resource, stats_only__passthrough)
+{
+  // neither the list of the blocks nor the diagnostics
+  EXPECT_LT(sizeof(stdx::pmr::stats_test_resource), sizeof(stdx::pmr::test_resource));
+
+  stdx::pmr::test_resource upstream{ "upstream", false };
+  upstream.set_no_abort(true);
+  {
+    stdx::pmr::stats_test_resource tpmr{ "stats", false, &upstream };
+    tpmr.set_no_abort(true);
+
+    const stdx::pmr::test_resource_monitor monitor{ upstream };
+    void* p = tpmr.allocate(24U, 8U);
+    // no header and no padding, the upstream gets the request as is
+    EXPECT_EQ(upstream.last_allocated_bytes(), 24U);
+    EXPECT_EQ(upstream.last_allocated_address(), p);
+    EXPECT_EQ(tpmr.blocks_in_use(), 1LL);
+    EXPECT_EQ(tpmr.bytes_in_use(), 24LL);
+    EXPECT_EQ(tpmr.status(), -1LL);
+
+    tpmr.deallocate(p, 24U, 8U);
+    EXPECT_EQ(monitor.delta_blocks_in_use(), 0LL);
+    EXPECT_EQ(tpmr.blocks_in_use(), 0LL);
+    EXPECT_EQ(tpmr.total_blocks(), 1LL);
+    EXPECT_EQ(tpmr.status(), 0LL);
+  }
+  EXPECT_EQ(upstream.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_basic_test_resource, null_lock__detects_overrun)
+{
+  using single_thread_test_resource = stdx::pmr::basic_test_resource<
+    stdx::pmr::null_lock_policy,
+    stdx::pmr::padding_guard_policy,
+    stdx::pmr::scribble_policy,
+    stdx::pmr::list_tracking_policy,
+    stdx::pmr::sharded_stats_policy>;
+
+  single_thread_test_resource tpmr{ "single", false };
+  tpmr.set_quiet(true);
+
+  auto* p = static_cast<unsigned char*>(tpmr.allocate(8U, 8U));
+  p[8] = 0U;
+  tpmr.deallocate(p, 8U, 8U);
+  EXPECT_EQ(tpmr.bounds_errors(), 1LL);
+  EXPECT_EQ(tpmr.blocks_in_use(), 1LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, guard_check__finds_corrupted_byte)
+{
+  std::vector<std::byte> padding(4096U + 3U, stdx::pmr::detail::padded_memory_byte);
+  const std::byte* first = padding.data() + 3U;
+  const std::byte* last = padding.data() + padding.size();
+  EXPECT_EQ(stdx::pmr::detail::find_first_corrupted(first, last), last);
+  EXPECT_EQ(stdx::pmr::detail::find_last_corrupted(first, last), nullptr);
+
+  for (std::size_t offset : { 0U, 1U, 7U, 15U, 16U, 31U, 32U, 100U, 4095U })
+  {
+    padding[3U + offset] = std::byte{ 0x00U };
+    EXPECT_EQ(stdx::pmr::detail::find_first_corrupted(first, last), first + offset);
+    EXPECT_EQ(stdx::pmr::detail::find_last_corrupted(first, last), first + offset);
+    padding[3U + offset] = stdx::pmr::detail::padded_memory_byte;
+  }
+}
+
+TEST(StdX_MemoryResource_test_resource, overwrite_padding_before_payload__page_aligned)
+{
+  stdx::pmr::test_resource tpmr{ "aligned", false };
+  tpmr.set_quiet(true);
+
+  auto* p = static_cast<unsigned char*>(tpmr.allocate(64U, 4096U));
+  p[-10] = 0U;
+  tpmr.deallocate(p, 64U, 4096U);
+  EXPECT_EQ(tpmr.bounds_errors(), 1LL);
+}
+
+namespace
+{
+  // deallocates the block of 'size' bytes and counts the scribbled bytes of it
+  std::size_t count_scribbled_bytes(stdx::pmr::test_resource& tpmr, std::size_t size)
+  {
+    auto* p = static_cast<std::byte*>(tpmr.allocate(size, 16U));
+    memset(p, 0, size);
+    tpmr.deallocate(p, size, 16U);
+    // the monotonic upstream keeps the memory accessible after the deallocation
+    return static_cast<std::size_t>(std::count(p, p + size, stdx::pmr::detail::scribbled_memory_byte));
+  }
+}
+
+TEST(StdX_MemoryResource_test_resource, scribble__modes)
+{
+  std::pmr::monotonic_buffer_resource upstream{};
+  stdx::pmr::test_resource tpmr{ "scribble", false, &upstream };
+  EXPECT_EQ(tpmr.scribble(), stdx::pmr::scribble_mode::full);
+  EXPECT_EQ(count_scribbled_bytes(tpmr, 1000U), 1000U);
+
+  tpmr.set_scribble(stdx::pmr::scribble_mode::off);
+  EXPECT_EQ(count_scribbled_bytes(tpmr, 1000U), 0U);
+
+  tpmr.set_scribble(stdx::pmr::scribble_mode::edges, 64U);
+  EXPECT_EQ(tpmr.scribble_edge_size(), 64U);
+  EXPECT_EQ(count_scribbled_bytes(tpmr, 1000U), 128U);
+  EXPECT_EQ(count_scribbled_bytes(tpmr, 100U), 100U);
+
+  tpmr.set_scribble(stdx::pmr::scribble_mode::streaming);
+  EXPECT_EQ(count_scribbled_bytes(tpmr, 1000U), 1000U);
+  EXPECT_EQ(count_scribbled_bytes(tpmr, 7U), 7U);
+  EXPECT_EQ(tpmr.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, sampling__checks_sampled_blocks_only)
+{
+  stdx::pmr::test_resource upstream{ "upstream", false };
+  upstream.set_no_abort(true);
+  {
+    stdx::pmr::test_resource tpmr{ "sampled", false, &upstream };
+    tpmr.set_quiet(true);
+    tpmr.set_sampling_rate(10U);
+    EXPECT_EQ(tpmr.sampling_rate(), 10U);
+
+    std::vector<unsigned char*> blocks;
+    std::size_t sampled = 0U;
+    unsigned char* corrupted = nullptr;
+    for (int i = 0; i < 1000; ++i)
+    {
+      blocks.push_back(static_cast<unsigned char*>(tpmr.allocate(24U, 8U)));
+      // the sampled block has the header and the paddings
+      if (upstream.last_allocated_bytes() != 24U)
+      {
+        ++sampled;
+        corrupted = blocks.back();
+      }
+    }
+    EXPECT_GT(sampled, 20U);
+    EXPECT_LT(sampled, 500U);
+    EXPECT_EQ(tpmr.blocks_in_use(), 1000LL);
+
+    ASSERT_NE(corrupted, nullptr);
+    corrupted[24] = 0U;
+    for (auto* p : blocks)
+    {
+      tpmr.deallocate(p, 24U, 8U);
+    }
+    EXPECT_EQ(tpmr.bounds_errors(), 1LL);
+    EXPECT_EQ(tpmr.blocks_in_use(), 1LL);
+
+    // give the corrupted block back to the upstream
+    corrupted[24] = std::to_integer<unsigned char>(stdx::pmr::detail::padded_memory_byte);
+    tpmr.deallocate(corrupted, 24U, 8U);
+    EXPECT_EQ(tpmr.blocks_in_use(), 0LL);
+  }
+  EXPECT_EQ(upstream.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, sampling__second_deallocation_of_sampled_block_is_reported)
+{
+  // the memory of the deallocated blocks stays readable
+  std::pmr::monotonic_buffer_resource monotonic;
+  stdx::pmr::test_resource upstream{ "upstream", false, &monotonic };
+  upstream.set_no_abort(true);
+  upstream.set_quiet(true);
+  {
+    stdx::pmr::test_resource tpmr{ "sampled", false, &upstream };
+    tpmr.set_no_abort(true);
+    tpmr.set_quiet(true);
+    tpmr.set_sampling_rate(2U);
+
+    void* sampled = nullptr;
+    std::vector<void*> blocks;
+    while (!sampled)
+    {
+      blocks.push_back(tpmr.allocate(24U, 8U));
+      if (upstream.last_allocated_bytes() != 24U)
+      {
+        sampled = blocks.back();
+        blocks.pop_back();
+      }
+    }
+
+    tpmr.deallocate(sampled, 24U, 8U);
+    tpmr.deallocate(sampled, 24U, 8U);
+    EXPECT_EQ(tpmr.mismatches(), 1LL);
+    // the address inside the upstream block is not passed to the upstream
+    EXPECT_FALSE(upstream.has_errors());
+
+    for (void* p : blocks)
+    {
+      tpmr.deallocate(p, 24U, 8U);
+    }
+  }
+  EXPECT_EQ(upstream.blocks_in_use(), 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, sampling__rate_is_kept_per_resource)
+{
+  stdx::pmr::test_resource upstream1{ "upstream1", false };
+  stdx::pmr::test_resource upstream2{ "upstream2", false };
+  {
+    stdx::pmr::test_resource frequent{ "frequent", false, &upstream1 };
+    stdx::pmr::test_resource rare{ "rare", false, &upstream2 };
+    frequent.set_sampling_rate(2U);
+    rare.set_sampling_rate(1000U);
+
+    // the allocations of the two resources interleave on one thread
+    std::vector<void*> frequentBlocks;
+    std::vector<void*> rareBlocks;
+    std::size_t frequentSampled = 0U;
+    for (int i = 0; i < 1000; ++i)
+    {
+      frequentBlocks.push_back(frequent.allocate(24U, 8U));
+      frequentSampled += upstream1.last_allocated_bytes() != 24U ? 1U : 0U;
+      rareBlocks.push_back(rare.allocate(24U, 8U));
+    }
+    EXPECT_GT(frequentSampled, 250U);
+    EXPECT_LT(frequentSampled, 750U);
+
+    for (void* p : frequentBlocks)
+    {
+      frequent.deallocate(p, 24U, 8U);
+    }
+    for (void* p : rareBlocks)
+    {
+      rare.deallocate(p, 24U, 8U);
+    }
+  }
+  EXPECT_EQ(upstream1.status(), 0LL);
+  EXPECT_EQ(upstream2.status(), 0LL);
+}
+
+#if defined(__linux__)
+TEST(StdX_MemoryResource_test_resource, guard_pages__payload_ends_at_guard_page)
+{
+  stdx::pmr::test_resource upstream{ "upstream", false };
+  {
+    stdx::pmr::test_resource tpmr{ "guarded", false, &upstream };
+    // the report of the corrupted slack must not touch the guard page
+    tpmr.set_no_abort(true);
+    tpmr.set_guard_pages(4096U, true);
+    EXPECT_EQ(tpmr.guard_page_threshold(), 4096U);
+    const stdx::pmr::test_resource_monitor monitor{ upstream };
+
+    const auto page = stdx::pmr::detail::page_size();
+    auto* p = static_cast<unsigned char*>(tpmr.allocate(5008U, 16U));
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p + 5008U) % page, 0U);
+    // the guarded blocks don't come from the upstream
+    EXPECT_EQ(monitor.delta_blocks_in_use(), 0LL);
+    memset(p, 0, 5008U);
+    tpmr.deallocate(p, 5008U, 16U);
+
+    // the overrun into the alignment slack is detected on deallocation
+    p = static_cast<unsigned char*>(tpmr.allocate(5000U, 16U));
+    p[5003] = 0U;
+    tpmr.deallocate(p, 5000U, 16U);
+    EXPECT_EQ(tpmr.bounds_errors(), 1LL);
+
+    // the small blocks are still allocated from the upstream
+    void* small = tpmr.allocate(100U, 16U);
+    EXPECT_EQ(monitor.delta_blocks_in_use(), 1LL);
+    tpmr.deallocate(small, 100U, 16U);
+  }
+  EXPECT_EQ(upstream.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, guard_pages__overrun_faults)
+{
+  const auto overrun = []() {
+    stdx::pmr::test_resource tpmr{ "guarded", false };
+    tpmr.set_guard_pages(4096U);
+    auto* p = static_cast<volatile unsigned char*>(tpmr.allocate(8192U, 16U));
+    p[8192] = 0U;
+  };
+  EXPECT_DEATH(overrun(), "");
+}
+
+TEST(StdX_MemoryResource_test_resource, guard_pages__overrun_report_of_overaligned_block_dumps_its_padding)
+{
+  std::ostringstream os;
+  stdx::pmr::detail::stream_test_resource_reporter reporter{ os };
+  stdx::pmr::test_resource tpmr{ "guarded", false, &reporter };
+  tpmr.set_no_abort(true);
+  tpmr.set_guard_pages(4096U);
+
+  // the block aligned above the page size is not guarded and has the ordinary padding only
+  const std::size_t alignment = 2U * stdx::pmr::detail::page_size();
+  auto* p = static_cast<unsigned char*>(tpmr.allocate(5000U, alignment));
+  p[5000] = 0U;
+  tpmr.deallocate(p, 5000U, alignment);
+  EXPECT_EQ(tpmr.bounds_errors(), 1LL);
+
+  const auto text = os.str();
+  const auto first = text.find("Pad area after user segment:\n");
+  const auto last = text.find("Header + Padding:\n");
+  ASSERT_NE(first, std::string::npos);
+  ASSERT_NE(last, std::string::npos);
+  EXPECT_EQ(std::count(text.begin() + static_cast<std::ptrdiff_t>(first), text.begin() + static_cast<std::ptrdiff_t>(last), '\n'),
+    1 + static_cast<std::ptrdiff_t>(stdx::pmr::detail::padding_size / 16U));
+}
+#endif
+
+TEST(StdX_MemoryResource_test_resource, quarantine__detects_write_after_free)
+{
+  counting_test_resource_reporter reporter;
+  stdx::pmr::test_resource upstream{ "upstream", false };
+  {
+    stdx::pmr::test_resource tpmr{ "quarantined", false, &upstream, &reporter };
+    tpmr.set_no_abort(true);
+    tpmr.set_quarantine(1024U, 2U);
+    const stdx::pmr::test_resource_monitor monitor{ upstream };
+
+    auto* p = static_cast<unsigned char*>(tpmr.allocate(100U, 8U));
+    tpmr.deallocate(p, 100U, 8U);
+    // the block stays in the quarantine
+    EXPECT_EQ(monitor.delta_blocks_in_use(), 1LL);
+    p[42] = 0U;
+
+    // the double free of the quarantined block is detected
+    tpmr.deallocate(p, 100U, 8U);
+    EXPECT_EQ(tpmr.mismatches(), 1LL);
+
+    // the third block pushes the first one out of the quarantine
+    for (int i = 0; i < 2; ++i)
+    {
+      tpmr.deallocate(tpmr.allocate(100U, 8U), 100U, 8U);
+    }
+    EXPECT_EQ(tpmr.writes_after_free(), 1LL);
+    EXPECT_EQ(reporter.write_after_free_offset(), 42U);
+    EXPECT_EQ(monitor.delta_blocks_in_use(), 2LL);
+  }
+  // the quarantine is emptied on the destruction
+  EXPECT_EQ(upstream.status(), 0LL);
+}
+
+namespace
+{
+  // the reporter written before the write after free detection
+  class message_test_resource_reporter final : public stdx::pmr::test_resource_reporter
+  {
+  public:
+    [[nodiscard]]
+    const std::string& messages() const noexcept
+    {
+      return m_messages;
+    }
+
+  private:
+    void do_report_allocation(const stdx::pmr::test_resource&) override
+    {
+    }
+
+    void do_report_deallocation(const stdx::pmr::test_resource&) override
+    {
+    }
+
+    void do_report_release(const stdx::pmr::test_resource&) override
+    {
+    }
+
+    void do_report_invalid_memory_block(
+      const stdx::pmr::test_resource&,
+      std::size_t,
+      std::size_t,
+      int,
+      int) override
+    {
+    }
+
+    void do_report_print(const stdx::pmr::test_resource&) override
+    {
+    }
+
+    void do_report_log_msg(const char* format, va_list args) override
+    {
+      m_messages += stdx::pmr::detail::report_formater<char>::msg2str(format, args);
+    }
+
+    std::string m_messages;
+  };
+}
+
+TEST(StdX_MemoryResource_test_resource, quarantine__write_after_free_is_logged_by_reporter_without_callback)
+{
+  message_test_resource_reporter reporter;
+  {
+    stdx::pmr::test_resource tpmr{ "quarantined", false, &reporter };
+    tpmr.set_no_abort(true);
+    tpmr.set_quarantine(1024U, 1U);
+
+    auto* p = static_cast<unsigned char*>(tpmr.allocate(100U, 8U));
+    tpmr.deallocate(p, 100U, 8U);
+    p[42] = 0U;
+    tpmr.deallocate(tpmr.allocate(100U, 8U), 100U, 8U);
+    EXPECT_EQ(tpmr.writes_after_free(), 1LL);
+  }
+  EXPECT_NE(reporter.messages().find(
+    "test_resource quarantined: *** Memory written after free at 42 bytes into 100 byte segment (aligned 8) at "),
+    std::string::npos);
+}
+
+TEST(StdX_MemoryResource_basic_test_resource, null_lock__errors_and_leaks_are_logged)
+{
+  using single_thread_test_resource = stdx::pmr::basic_test_resource<
+    stdx::pmr::null_lock_policy,
+    stdx::pmr::padding_guard_policy,
+    stdx::pmr::scribble_policy,
+    stdx::pmr::list_tracking_policy,
+    stdx::pmr::sharded_stats_policy>;
+
+  message_test_resource_reporter reporter;
+  {
+    single_thread_test_resource tpmr{ "single", false, &reporter };
+    tpmr.set_no_abort(true);
+
+    auto* p = static_cast<unsigned char*>(tpmr.allocate(8U, 8U));
+    p[8] = 0U;
+    tpmr.deallocate(p, 8U, 8U);
+  }
+  EXPECT_NE(reporter.messages().find("test_resource single: *** Freeing 8 byte segment (aligned 8) at "),
+    std::string::npos);
+  EXPECT_NE(reporter.messages().find(": memory corrupted after the segment. ***\n"), std::string::npos);
+  EXPECT_NE(reporter.messages().find("MEMORY_LEAK from single:\n   Number of blocks in use = 1\n"),
+    std::string::npos);
+}
+
+TEST(StdX_MemoryResource_test_resource, allocation__compact_header_of_large_alignment)
+{
+  stdx::pmr::test_resource upstream{ "upstream", false };
+  {
+    stdx::pmr::test_resource tpmr{ "compact", false, &upstream };
+    tpmr.set_no_abort(true);
+
+    for (std::size_t alignment = 128U; alignment <= 4096U; alignment <<= 1U)
+    {
+      void* p = tpmr.allocate(100U, alignment);
+      EXPECT_TRUE(stdx::pmr::detail::is_aligned(p, alignment));
+      // the upstream block is naturally aligned and its overhead is the header
+      // and the room for the alignment of the user segment
+      EXPECT_EQ(upstream.last_allocated_alignment(), stdx::pmr::detail::max_natural_alignment);
+      EXPECT_EQ(upstream.last_allocated_bytes(), alignment + 64U + 100U + stdx::pmr::detail::padding_size);
+      tpmr.deallocate(p, 100U, alignment);
+    }
+    EXPECT_EQ(tpmr.status(), 0LL);
+  }
+  EXPECT_EQ(upstream.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, allocation__compact_header_wrong_number_of_bytes)
+{
+  stdx::pmr::test_resource upstream{ "upstream", false };
+  {
+    stdx::pmr::test_resource tpmr{ "compact", false, &upstream };
+    tpmr.set_no_abort(true);
+    tpmr.set_quiet(true);
+
+    for (std::size_t alignment = 128U; alignment <= 4096U; alignment <<= 1U)
+    {
+      // the header precedes the user segment, so the wrong size is found in it
+      void* p = tpmr.allocate(100U, alignment);
+      tpmr.deallocate(p, 200U, alignment);
+      tpmr.deallocate(p, std::size_t{ 1U } << 24U, alignment);
+      EXPECT_EQ(tpmr.blocks_in_use(), 1LL);
+      tpmr.deallocate(p, 100U, alignment);
+      EXPECT_EQ(tpmr.blocks_in_use(), 0LL);
+    }
+    EXPECT_EQ(tpmr.bad_deallocate_params(), 12LL);
+    EXPECT_EQ(tpmr.mismatches(), 0LL);
+  }
+  EXPECT_EQ(upstream.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, allocation__runtime_alignment)
+{
+  stdx::pmr::test_resource upstream{ "upstream", false };
+  {
+    stdx::pmr::test_resource tpmr{ "runtime", false, &upstream };
+    tpmr.set_no_abort(true);
+
+    for (std::size_t alignment = 8192U; alignment <= stdx::pmr::detail::max_alignment; alignment <<= 1U)
+    {
+      void* p = tpmr.allocate(100U, alignment);
+      EXPECT_TRUE(stdx::pmr::detail::is_aligned(p, alignment));
+      EXPECT_EQ(tpmr.last_allocated_alignment(), alignment);
+      tpmr.deallocate(p, 100U, alignment);
+    }
+    EXPECT_EQ(tpmr.status(), 0LL);
+
+    EXPECT_THROW(static_cast<void>(tpmr.allocate(100U, stdx::pmr::detail::max_alignment << 1U)),
+      stdx::pmr::test_resource_exception);
+  }
+  EXPECT_EQ(upstream.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, bulk__allocate_and_deallocate)
+{
+  stdx::pmr::test_resource upstream{ "upstream", false };
+  {
+    stdx::pmr::test_resource tpmr{ "bulk", false, &upstream };
+
+    std::vector<void*> blocks(1000U);
+    tpmr.allocate_bulk(blocks.data(), blocks.size(), 24U, 8U);
+    EXPECT_EQ(tpmr.allocations(), 1000LL);
+    EXPECT_EQ(tpmr.blocks_in_use(), 1000LL);
+    EXPECT_EQ(tpmr.max_blocks(), 1000LL);
+    EXPECT_EQ(tpmr.bytes_in_use(), 24000LL);
+    EXPECT_EQ(tpmr.last_allocated_address(), blocks.back());
+    for (void* p : blocks)
+    {
+      EXPECT_TRUE(stdx::pmr::detail::is_aligned(p, 8U));
+      memset(p, 0xAB, 24U);
+    }
+
+    // the blocks are tracked as if they were allocated one by one
+    tpmr.deallocate(blocks.front(), 24U, 8U);
+    tpmr.deallocate_bulk(blocks.data() + 1U, blocks.size() - 1U, 24U, 8U);
+    EXPECT_EQ(tpmr.deallocations(), 1000LL);
+    EXPECT_EQ(tpmr.blocks_in_use(), 0LL);
+    EXPECT_EQ(tpmr.status(), 0LL);
+  }
+  EXPECT_EQ(upstream.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, bulk__deallocate_reports_invalid_block)
+{
+  stdx::pmr::test_resource tpmr{ "bulk", false };
+  tpmr.set_quiet(true);
+
+  void* blocks[4];
+  tpmr.allocate_bulk(blocks, 4U, 8U, 8U);
+  static_cast<unsigned char*>(blocks[2])[8] = 0U;
+
+  tpmr.deallocate_bulk(blocks, 4U, 8U, 8U);
+  EXPECT_EQ(tpmr.bounds_errors(), 1LL);
+  EXPECT_EQ(tpmr.blocks_in_use(), 1LL);
+}
+
+#ifdef __SANITIZE_ADDRESS__
+TEST(StdX_MemoryResource_test_resource, DISABLED_bulk__deallocate_reports_block_passed_twice)
+#else
+TEST(StdX_MemoryResource_test_resource, bulk__deallocate_reports_block_passed_twice)
+#endif
+{
+  stdx::pmr::test_resource tpmr{ "bulk", false };
+  tpmr.set_quiet(true);
+
+  // a block passed twice is deallocated once
+  void* twice[2];
+  twice[0] = tpmr.allocate(8U, 8U);
+  twice[1] = twice[0];
+  tpmr.deallocate_bulk(twice, 2U, 8U, 8U);
+  EXPECT_EQ(tpmr.mismatches(), 1LL);
+  EXPECT_EQ(tpmr.blocks_in_use(), 0LL);
+}
+
+TEST(StdX_MemoryResource_polymorphic_allocator, allocate_objects_bulk)
+{
+  struct node
+  {
+    node* m_next;
+    long long m_value;
+  };
+
+  stdx::pmr::test_resource tpmr{ "bulk", false };
+  stdx::pmr::polymorphic_allocator<> allocator{ &tpmr };
+
+  std::vector<node*> nodes(300U);
+  allocator.allocate_objects_bulk(nodes.data(), nodes.size(), 2U);
+  EXPECT_EQ(tpmr.blocks_in_use(), 300LL);
+  EXPECT_EQ(tpmr.last_allocated_bytes(), 2U * sizeof(node));
+  EXPECT_EQ(tpmr.last_allocated_alignment(), alignof(node));
+  allocator.deallocate_objects_bulk(nodes.data(), nodes.size(), 2U);
+  EXPECT_EQ(tpmr.status(), 0LL);
+
+  stdx::pmr::polymorphic_allocator<> default_allocator{ std::pmr::new_delete_resource() };
+  default_allocator.allocate_objects_bulk(nodes.data(), nodes.size());
+  default_allocator.deallocate_objects_bulk(nodes.data(), nodes.size());
+}
+
+TEST(StdX_MemoryResource_test_resource, snapshot__reads_all_statistics)
+{
+  stdx::pmr::test_resource tpmr{ "snapshot", false };
+  tpmr.set_quiet(true);
+
+  void* p = tpmr.allocate(40U, 8U);
+  void* q = tpmr.allocate(24U, 16U);
+  tpmr.deallocate(p, 41U, 8U);
+  tpmr.deallocate(q, 24U, 16U);
+
+  const auto stats = tpmr.snapshot();
+  EXPECT_EQ(stats.m_allocations, 2LL);
+  EXPECT_EQ(stats.m_deallocations, 2LL);
+  EXPECT_EQ(stats.m_blocksInUse, 1LL);
+  EXPECT_EQ(stats.m_bytesInUse, 40LL);
+  EXPECT_EQ(stats.m_maxBlocks, 2LL);
+  EXPECT_EQ(stats.m_maxBytes, 64LL);
+  EXPECT_EQ(stats.m_totalBlocks, 2LL);
+  EXPECT_EQ(stats.m_totalBytes, 64LL);
+  EXPECT_EQ(stats.m_badDeallocateParams, 1LL);
+  EXPECT_EQ(stats.m_lastAllocatedAddress, q);
+  EXPECT_EQ(stats.m_lastAllocatedBytes, 24U);
+  EXPECT_EQ(stats.m_lastAllocatedAlignment, 16U);
+  EXPECT_EQ(stats.m_lastDeallocatedAddress, q);
+  EXPECT_EQ(stats.m_lastDeallocatedBytes, 24U);
+  EXPECT_EQ(stats.status(), tpmr.status());
+  EXPECT_EQ(stats.status(), 1LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, snapshot__is_consistent_while_threads_allocate)
+{
+  constexpr int thread_count = 4;
+  constexpr std::size_t block_size = 48U;
+
+  stdx::pmr::test_resource tpmr{ "snapshot", false };
+
+  std::atomic_bool done{ false };
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_count; ++t)
+  {
+    threads.emplace_back([&tpmr, &done]() {
+      void* blocks[16];
+      while (!done.load(std::memory_order_relaxed))
+      {
+        for (auto& block : blocks)
+        {
+          block = tpmr.allocate(block_size, 16U);
+        }
+        for (auto* block : blocks)
+        {
+          tpmr.deallocate(block, block_size, 16U);
+        }
+      }
+    });
+  }
+
+  // every completed allocation and deallocation is seen as a whole
+  int torn = 0;
+  for (int i = 0; i < 10000; ++i)
+  {
+    const auto stats = tpmr.snapshot();
+    if (stats.m_bytesInUse != stats.m_blocksInUse * static_cast<long long>(block_size) ||
+        stats.m_totalBytes != stats.m_totalBlocks * static_cast<long long>(block_size) ||
+        (stats.m_lastAllocatedAddress && stats.m_lastAllocatedBytes != block_size))
+    {
+      ++torn;
+    }
+  }
+
+  done.store(true, std::memory_order_relaxed);
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  EXPECT_EQ(torn, 0);
+  EXPECT_EQ(tpmr.status(), 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, histograms__count_sizes_and_alignments)
+{
+  using histograms_type = stdx::pmr::test_resource_histograms;
+  static_assert(histograms_type::size_bucket(3U) == 3U);
+  static_assert(histograms_type::size_bucket(4U) == 4U);
+  static_assert(histograms_type::size_bucket(39U) == histograms_type::size_bucket(32U));
+  static_assert(histograms_type::size_bucket(40U) == histograms_type::size_bucket(32U) + 1U);
+  static_assert(histograms_type::size_bucket_min(histograms_type::size_bucket(40U)) == 40U);
+
+  std::ostringstream os;
+  stdx::pmr::detail::stream_test_resource_reporter reporter{ os };
+  stdx::pmr::test_resource tpmr{ "histograms", false, &reporter };
+
+  void* blocks[3];
+  blocks[0] = tpmr.allocate(33U, 8U);
+  blocks[1] = tpmr.allocate(39U, 8U);
+  blocks[2] = tpmr.allocate(1000U, 64U);
+
+  const auto histograms = tpmr.histograms();
+  EXPECT_EQ(histograms.m_sizes[histograms_type::size_bucket(32U)], 2LL);
+  EXPECT_EQ(histograms.m_sizes[histograms_type::size_bucket(1000U)], 1LL);
+  EXPECT_EQ(histograms.m_alignments[3], 2LL);
+  EXPECT_EQ(histograms.m_alignments[6], 1LL);
+
+  long long total = 0LL;
+  for (const auto count : histograms.m_sizes)
+  {
+    total += count;
+  }
+  EXPECT_EQ(total, tpmr.total_blocks());
+
+  tpmr.print();
+  EXPECT_NE(os.str().find("32 - 39"), std::string::npos);
+  EXPECT_NE(os.str().find("896 - 1023"), std::string::npos);
+
+  tpmr.deallocate(blocks[0], 33U, 8U);
+  tpmr.deallocate(blocks[1], 39U, 8U);
+  tpmr.deallocate(blocks[2], 1000U, 64U);
+}
+
+TEST(StdX_MemoryResource_test_resource, callsites__group_outstanding_blocks)
+{
+  std::ostringstream os;
+  stdx::pmr::detail::stream_test_resource_reporter reporter{ os };
+  stdx::pmr::test_resource tpmr{ "callsites", false, &reporter };
+
+  // not captured by default
+  void* untracked = tpmr.allocate(16U, 8U);
+  EXPECT_EQ(stdx::pmr::detail::get_header(untracked, 8U)->m_stack_id, 0U);
+
+  tpmr.set_callsite_capture(stdx::pmr::detail::max_callsite_depth);
+  EXPECT_EQ(tpmr.callsite_depth(), stdx::pmr::detail::max_callsite_depth);
+
+  void* blocks[3];
+  for (auto& block : blocks)
+  {
+    block = tpmr.allocate(32U, 8U);
+  }
+  void* other = tpmr.allocate(32U, 8U);
+
+#if defined(__GLIBC__)
+  const auto stack_id = stdx::pmr::detail::get_header(blocks[0], 8U)->m_stack_id;
+  EXPECT_NE(stack_id, 0U);
+  EXPECT_EQ(stdx::pmr::detail::get_header(blocks[1], 8U)->m_stack_id, stack_id);
+  EXPECT_EQ(stdx::pmr::detail::get_header(blocks[2], 8U)->m_stack_id, stack_id);
+  EXPECT_NE(stdx::pmr::detail::get_header(other, 8U)->m_stack_id, stack_id);
+
+  tpmr.print();
+  EXPECT_NE(os.str().find("Outstanding Memory Allocations by Call Site"), std::string::npos);
+  EXPECT_NE(os.str().find("3 blocks, 96 bytes from call site " + std::to_string(stack_id)), std::string::npos);
+  EXPECT_NE(os.str().find("1 blocks, 32 bytes from call site"), std::string::npos);
+  EXPECT_NE(os.str().find("1 blocks, 16 bytes from an unknown call site"), std::string::npos);
+#endif
+
+  tpmr.set_callsite_capture(0U);
+  void* uncaptured = tpmr.allocate(16U, 8U);
+  EXPECT_EQ(stdx::pmr::detail::get_header(uncaptured, 8U)->m_stack_id, 0U);
+
+  for (auto* block : blocks)
+  {
+    tpmr.deallocate(block, 32U, 8U);
+  }
+  tpmr.deallocate(other, 32U, 8U);
+  tpmr.deallocate(untracked, 16U, 8U);
+  tpmr.deallocate(uncaptured, 16U, 8U);
+}
+
+TEST(StdX_MemoryResource_test_resource, lifetimes__rank_arena_candidates)
+{
+  using lifetimes_type = stdx::pmr::test_resource_lifetimes;
+
+  std::ostringstream os;
+  stdx::pmr::detail::stream_test_resource_reporter reporter{ os };
+  stdx::pmr::test_resource tpmr{ "lifetimes", false, &reporter };
+  EXPECT_FALSE(tpmr.is_lifetime_profiling());
+  EXPECT_TRUE(tpmr.lifetimes().m_sites.empty());
+
+  tpmr.set_lifetime_profiling(true);
+  tpmr.set_callsite_capture(stdx::pmr::detail::max_callsite_depth);
+  EXPECT_TRUE(tpmr.is_lifetime_profiling());
+
+  // the long lived block outlives more allocations than the timestamps kept
+  constexpr std::size_t short_lived = 2U * stdx::pmr::detail::lifetime_stamp_capacity;
+  void* long_lived = tpmr.allocate(1000U, 8U);
+  for (std::size_t i = 0U; i < short_lived; ++i)
+  {
+    tpmr.deallocate(tpmr.allocate(24U, 8U), 24U, 8U);
+  }
+  tpmr.deallocate(long_lived, 1000U, 8U);
+
+  const auto lifetimes = tpmr.lifetimes();
+  const auto& small = lifetimes.m_sizeClasses[lifetimes_type::size_class(24U)];
+  EXPECT_EQ(small.m_allocations[0], static_cast<long long>(short_lived));
+  EXPECT_EQ(small.m_bytes[0], static_cast<long long>(24U * short_lived));
+  const auto& large = lifetimes.m_sizeClasses[lifetimes_type::size_class(1000U)];
+  EXPECT_EQ(large.m_allocations[stdx::pmr::detail::log2_bucket(short_lived, lifetimes_type::bucket_count)], 1LL);
+
+  long long timed = 0LL;
+  for (const auto count : large.m_nanoseconds)
+  {
+    timed += count;
+  }
+  EXPECT_EQ(timed, 1LL);
+
+#if defined(__GLIBC__)
+  ASSERT_EQ(lifetimes.m_sites.size(), 2U);
+  EXPECT_EQ(lifetimes.m_sites[0].m_blocks, static_cast<long long>(short_lived));
+  EXPECT_EQ(lifetimes.m_sites[0].m_shortLivedBytes, static_cast<long long>(24U * short_lived));
+  EXPECT_EQ(lifetimes.m_sites[1].m_bytes, 1000LL);
+  EXPECT_EQ(lifetimes.m_sites[1].m_shortLivedBytes, 0LL);
+#endif
+
+  tpmr.print();
+  EXPECT_NE(os.str().find("Arena Candidates"), std::string::npos);
+  EXPECT_NE(os.str().find(std::to_string(24U * short_lived) + " of " + std::to_string(24U * short_lived) + " bytes"),
+    std::string::npos);
+
+  tpmr.set_lifetime_profiling(false);
+  EXPECT_TRUE(tpmr.lifetimes().m_sites.empty());
+}
+
+TEST(StdX_MemoryResource_test_resource, lifetimes__skip_block_allocated_before_profiling)
+{
+  using lifetimes_type = stdx::pmr::test_resource_lifetimes;
+
+  stdx::pmr::test_resource tpmr{ "lifetimes", false };
+
+  // the timestamps of the allocations before the profiling are never kept
+  void* long_lived = tpmr.allocate(1000U, 8U);
+  for (std::size_t i = 0U; i < stdx::pmr::detail::lifetime_stamp_capacity; ++i)
+  {
+    tpmr.deallocate(tpmr.allocate(24U, 8U), 24U, 8U);
+  }
+
+  tpmr.set_lifetime_profiling(true);
+  tpmr.deallocate(long_lived, 1000U, 8U);
+
+  const auto& large = tpmr.lifetimes().m_sizeClasses[lifetimes_type::size_class(1000U)];
+  for (const auto count : large.m_allocations)
+  {
+    EXPECT_EQ(count, 0LL);
+  }
+}
+
+namespace
+{
+  // the upstream resource taking at least 'delay' for every request
+  class slow_resource : public std::pmr::memory_resource
+  {
+  public:
+    explicit slow_resource(std::chrono::microseconds delay) noexcept
+      : m_delay(delay)
+    {}
+
+  private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+      std::this_thread::sleep_for(m_delay);
+      return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+      std::this_thread::sleep_for(m_delay);
+      std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+      return this == &other;
+    }
+
+    std::chrono::microseconds m_delay;
+  };
+}
+
+TEST(StdX_MemoryResource_test_resource, latencies__split_the_upstream_time)
+{
+  constexpr std::uint64_t delay_ns = 200000U;
+  slow_resource upstream{ std::chrono::microseconds(delay_ns / 1000U) };
+  std::ostringstream os;
+  stdx::pmr::detail::stream_test_resource_reporter reporter{ os };
+  stdx::pmr::test_resource tpmr{ "latencies", false, &upstream, &reporter };
+  EXPECT_EQ(tpmr.latencies().m_allocations.m_total.m_count, 0LL);
+
+  tpmr.set_latency_profiling(true);
+  EXPECT_TRUE(tpmr.is_latency_profiling());
+  for (int i = 0; i < 10; ++i)
+  {
+    tpmr.deallocate(tpmr.allocate(64U, 8U), 64U, 8U);
+  }
+
+  const auto latencies = tpmr.latencies();
+  for (const auto* operation : { &latencies.m_allocations, &latencies.m_deallocations })
+  {
+    EXPECT_EQ(operation->m_total.m_count, 10LL);
+    EXPECT_EQ(operation->m_upstream.m_count, 10LL);
+    EXPECT_GE(operation->m_upstream.m_p50, delay_ns);
+    EXPECT_LE(operation->m_upstream.m_p50, operation->m_upstream.m_p99);
+    EXPECT_LE(operation->m_upstream.m_p99, operation->m_upstream.m_p999);
+    EXPECT_LE(operation->m_upstream.m_p999, operation->m_upstream.m_max);
+    EXPECT_LE(operation->m_upstream.m_max, operation->m_total.m_max);
+    EXPECT_LT(operation->m_bookkeeping.m_p50, operation->m_upstream.m_p50);
+  }
+
+  tpmr.print();
+  EXPECT_NE(os.str().find("Latency (ns)"), std::string::npos);
+
+  tpmr.set_latency_profiling(false);
+  EXPECT_EQ(tpmr.latencies().m_allocations.m_total.m_count, 0LL);
+}
+
+TEST(StdX_MemoryResource_test_resource, dump_blocks__lists_every_outstanding_block)
+{
+  stdx::pmr::test_resource tpmr{ "dump", false };
+
+  void* blocks[3];
+  for (auto& block : blocks)
+  {
+    block = tpmr.allocate(32U, 8U);
+  }
+  void* aligned = tpmr.allocate(100U, 64U);
+
+  const auto top = tpmr.top_blocks(1U);
+  ASSERT_EQ(top.size(), 1U);
+  EXPECT_EQ(top[0].m_size, 100U);
+  EXPECT_EQ(top[0].m_blocks, 1LL);
+  EXPECT_EQ(top[0].m_bytes, 100U);
+
+  const auto groups = tpmr.top_blocks(10U);
+  ASSERT_EQ(groups.size(), 2U);
+  EXPECT_EQ(groups[1].m_size, 32U);
+  EXPECT_EQ(groups[1].m_blocks, 3LL);
+  EXPECT_EQ(groups[1].m_bytes, 96U);
+
+  std::ostringstream os;
+  tpmr.dump_blocks(os);
+  const auto dump = os.str();
+
+  std::ostringstream address;
+  address << "0x" << std::hex << reinterpret_cast<std::uintptr_t>(aligned);
+  EXPECT_NE(dump.find("                   3                  100         64          -  " + address.str() + "\n"),
+    std::string::npos);
+  EXPECT_NE(dump.find("                  96                    3                   32          -\n"), std::string::npos);
+
+  // a line per block, the summary of both groups and the headers
+  EXPECT_EQ(std::count(dump.begin(), dump.end(), '\n'), 4 + 2 + 4);
+
+  for (auto* block : blocks)
+  {
+    tpmr.deallocate(block, 32U, 8U);
+  }
+  tpmr.deallocate(aligned, 100U, 64U);
+}
+
+TEST(StdX_MemoryResource_test_resource, latencies__count_the_lock_wait)
+{
+  std::mutex lock;
+  std::atomic_bool locked{ false };
+  std::thread holder([&] {
+    std::lock_guard<std::mutex> guard{ lock };
+    locked = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  });
+  while (!locked)
+  {
+    std::this_thread::yield();
+  }
+
+  const auto before = stdx::pmr::detail::this_thread_latency().m_lockWait;
+  {
+    stdx::pmr::detail::lock_guard_t<true> guard{ lock };
+  }
+  EXPECT_GT(stdx::pmr::detail::this_thread_latency().m_lockWait, before);
+  holder.join();
+}
+
+TEST(StdX_MemoryResource_test_resource, openmetrics__labels_every_resource)
+{
+  stdx::pmr::test_resource first{ "first", false };
+  stdx::pmr::test_resource second{ "say \"hi\"", false };
+  void* p = first.allocate(24U, 8U);
+  void* q = second.allocate(5U, 64U);
+  second.deallocate(q, 5U, 64U);
+
+  const stdx::pmr::test_resource* resources[] = { &first, &second };
+  const stdx::pmr::test_resource_stats stats[] = { first.snapshot(), second.snapshot() };
+  const stdx::pmr::test_resource_histograms histograms[] = { first.histograms(), second.histograms() };
+  char buffer[16384];
+  const std::size_t size = stdx::pmr::write_openmetrics(buffer, sizeof(buffer), resources, stats, histograms, 2U);
+  ASSERT_LE(size, sizeof(buffer));
+  const std::string text(buffer, size);
+
+  EXPECT_NE(text.find("# TYPE test_resource_allocation_requests counter\n"), std::string::npos);
+  EXPECT_NE(text.find("test_resource_allocation_requests_total{name=\"first\"} 1\n"), std::string::npos);
+  EXPECT_NE(text.find("test_resource_bytes_in_use{name=\"first\"} 24\n"), std::string::npos);
+  EXPECT_NE(text.find("test_resource_bytes_in_use{name=\"say \\\"hi\\\"\"} 0\n"), std::string::npos);
+  EXPECT_NE(text.find("test_resource_max_bytes_in_use{name=\"say \\\"hi\\\"\"} 5\n"), std::string::npos);
+  EXPECT_NE(text.find("test_resource_allocation_size_bytes_bucket{name=\"first\",le=\"15\"} 0\n"), std::string::npos);
+  EXPECT_NE(text.find("test_resource_allocation_size_bytes_bucket{name=\"first\",le=\"31\"} 1\n"), std::string::npos);
+  EXPECT_NE(text.find("test_resource_allocation_alignment_bytes_bucket{name=\"say \\\"hi\\\"\",le=\"32\"} 0\n"),
+    std::string::npos);
+  EXPECT_NE(text.find("test_resource_allocation_alignment_bytes_bucket{name=\"say \\\"hi\\\"\",le=\"64\"} 1\n"),
+    std::string::npos);
+  // the histogram with the _count has the _sum too
+  EXPECT_NE(text.find("test_resource_allocation_size_bytes_count{name=\"first\"} 1\n"), std::string::npos);
+  EXPECT_NE(text.find("test_resource_allocation_size_bytes_sum{name=\"first\"} 24\n"), std::string::npos);
+  EXPECT_EQ(text.find("test_resource_allocation_alignment_bytes_count"), std::string::npos);
+  EXPECT_EQ(text.substr(text.size() - 6U), "# EOF\n");
+
+  first.deallocate(p, 24U, 8U);
+}
+
+TEST(StdX_MemoryResource_test_resource, openmetrics__short_buffer_is_not_overrun)
+{
+  stdx::pmr::test_resource tpmr{ "short", false };
+
+  char buffer[64];
+  std::fill(std::begin(buffer), std::end(buffer), '#');
+  const std::size_t size = stdx::pmr::write_openmetrics(buffer, 32U, tpmr);
+  EXPECT_GT(size, 32U);
+  EXPECT_TRUE(std::all_of(buffer + 32, std::end(buffer), [](char c) { return '#' == c; }));
+
+  std::vector<char> text(size);
+  EXPECT_EQ(stdx::pmr::write_openmetrics(text.data(), text.size(), tpmr), size);
+  EXPECT_EQ(std::string(text.data(), 32U), std::string(buffer, 32U));
+}
+
+TEST(StdX_MemoryResource_test_resource, openmetrics__exporter_rewrites_the_file)
+{
+  stdx::pmr::test_resource tpmr{ "exported", false };
+  const auto path = std::filesystem::temp_directory_path() / "test_resource_exporter.prom";
+  {
+    stdx::pmr::test_resource_metrics_exporter exporter{ path, { &tpmr }, std::chrono::milliseconds(10) };
+    void* p = tpmr.allocate(8U);
+    EXPECT_TRUE(exporter.refresh());
+
+    std::ifstream file{ path };
+    const std::string text{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    EXPECT_NE(text.find("test_resource_blocks_in_use{name=\"exported\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("# EOF\n"), std::string::npos);
+    tpmr.deallocate(p, 8U);
+  }
+  std::ifstream file{ path };
+  const std::string text{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+  EXPECT_NE(text.find("test_resource_blocks_in_use{name=\"exported\"} 0\n"), std::string::npos);
+  std::filesystem::remove(path);
+}
+
+#if defined(__linux__)
+TEST(StdX_MemoryResource_test_resource, stats_page__publishes_the_usage_counters)
+{
+  const auto path = std::filesystem::temp_directory_path() / "test_resource_stats_page";
+  ASSERT_TRUE(stdx::pmr::test_resource_stats_page::open(path, 4U));
+  EXPECT_FALSE(stdx::pmr::test_resource_stats_page::open(path, 4U));
+
+  const stdx::pmr::test_resource_stats_page_reader page{ path };
+  ASSERT_TRUE(page.is_open());
+  EXPECT_EQ(page.pid(), static_cast<long long>(::getpid()));
+  {
+    stdx::pmr::test_resource tpmr{ "published", false };
+    void* p = tpmr.allocate(100U);
+    void* q = tpmr.allocate(20U);
+    tpmr.deallocate(q, 20U);
+
+    const auto entries = page.read();
+    ASSERT_EQ(entries.size(), 1U);
+    EXPECT_EQ(entries[0].m_name, "published");
+    EXPECT_EQ(entries[0].m_allocations, 2LL);
+    EXPECT_EQ(entries[0].m_blocksInUse, 1LL);
+    EXPECT_EQ(entries[0].m_bytesInUse, 100LL);
+    EXPECT_EQ(entries[0].m_maxBlocks, 2LL);
+    EXPECT_EQ(entries[0].m_maxBytes, 120LL);
+    EXPECT_EQ(tpmr.snapshot().m_maxBytes, 120LL);
+    tpmr.deallocate(p, 100U);
+  }
+  EXPECT_TRUE(page.read().empty());
+
+  stdx::pmr::test_resource_stats_page::close();
+  EXPECT_FALSE(std::filesystem::exists(path));
+  stdx::pmr::test_resource unpublished{ "unpublished", false };
+  EXPECT_TRUE(page.read().empty());
+}
+#endif
+
+TEST(StdX_MemoryResource_test_resource, trace__records_every_operation)
+{
+  const auto path = std::filesystem::temp_directory_path() / "test_resource_trace.bin";
+  void* blocks[3];
+  void* p = nullptr;
+  void* q = nullptr;
+  void* r = nullptr;
+  {
+    stdx::pmr::test_resource_trace_recorder recorder{ path };
+    ASSERT_TRUE(recorder.is_open());
+    stdx::pmr::test_resource tpmr{ "traced", false };
+    stdx::pmr::stats_test_resource stats{ "traced_stats", false };
+    tpmr.set_trace_recorder(&recorder);
+    stats.set_trace_recorder(&recorder);
+    EXPECT_EQ(tpmr.trace_recorder(), &recorder);
+
+    p = tpmr.allocate(24U, 8U);
+    q = tpmr.allocate(100U, 64U);
+    tpmr.deallocate(p, 24U, 8U);
+    tpmr.allocate_bulk(blocks, 3U, 16U, 16U);
+    tpmr.deallocate_bulk(blocks, 3U, 16U, 16U);
+    tpmr.deallocate(q, 100U, 64U);
+    r = stats.allocate(8U, 8U);
+    stats.deallocate(r, 8U, 8U);
+    tpmr.set_trace_recorder(nullptr);
+    tpmr.deallocate(tpmr.allocate(8U), 8U);
+  }
+
+  stdx::pmr::test_resource_trace_reader reader{ path };
+  ASSERT_TRUE(reader.is_open());
+  EXPECT_EQ(reader.events(), 12U);
+  EXPECT_EQ(reader.dropped(), 0U);
+  EXPECT_EQ(reader.threads(), 1U);
+  EXPECT_GT(reader.ticks_per_second(), 0U);
+
+  using op = stdx::pmr::trace_operation;
+  const struct
+  {
+    op          m_operation;
+    long long   m_index;
+    std::size_t m_bytes;
+    std::size_t m_alignment;
+    const void* m_address;
+  } expected[] = {
+    { op::allocation, 0LL, 24U, 8U, p },
+    { op::allocation, 1LL, 100U, 64U, q },
+    { op::deallocation, 0LL, 24U, 8U, p },
+    { op::allocation, 2LL, 16U, 16U, blocks[0] },
+    { op::allocation, 3LL, 16U, 16U, blocks[1] },
+    { op::allocation, 4LL, 16U, 16U, blocks[2] },
+    { op::deallocation, 2LL, 16U, 16U, blocks[0] },
+    { op::deallocation, 3LL, 16U, 16U, blocks[1] },
+    { op::deallocation, 4LL, 16U, 16U, blocks[2] },
+    { op::deallocation, 1LL, 100U, 64U, q },
+    // the blocks without the header don't know their allocation index
+    { op::allocation, 0LL, 8U, 8U, r },
+    { op::deallocation, -1LL, 8U, 8U, r },
+  };
+  stdx::pmr::test_resource_trace_event event;
+  std::uint64_t timestamp = 0U;
+  for (const auto& e : expected)
+  {
+    ASSERT_TRUE(reader.next(event));
+    EXPECT_EQ(event.m_operation, e.m_operation);
+    EXPECT_EQ(event.m_index, e.m_index);
+    EXPECT_EQ(event.m_bytes, e.m_bytes);
+    EXPECT_EQ(event.m_alignment, e.m_alignment);
+    EXPECT_EQ(event.m_address, reinterpret_cast<std::uintptr_t>(e.m_address));
+    EXPECT_EQ(event.m_thread, 0U);
+    EXPECT_GE(event.m_timestamp, timestamp);
+    timestamp = event.m_timestamp;
+  }
+  EXPECT_FALSE(reader.next(event));
+  std::filesystem::remove(path);
+}
+
+TEST(StdX_MemoryResource_test_resource, trace__keeps_the_streams_of_the_threads)
+{
+  const auto path = std::filesystem::temp_directory_path() / "test_resource_trace_threads.bin";
+  constexpr int thread_count = 4;
+  constexpr int iterations = 2000;
+  long long dropped = 0LL;
+  {
+    stdx::pmr::test_resource_trace_recorder recorder{ path, std::chrono::milliseconds(1), 256U };
+    stdx::pmr::test_resource tpmr{ "traced", false };
+    tpmr.set_trace_recorder(&recorder);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; ++i)
+    {
+      threads.emplace_back([&tpmr] {
+        for (int j = 0; j < iterations; ++j)
+        {
+          tpmr.deallocate(tpmr.allocate(32U), 32U);
+        }
+      });
+    }
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+    recorder.flush();
+    dropped = recorder.dropped();
+    EXPECT_EQ(recorder.events() + dropped, 2LL * thread_count * iterations);
+  }
+
+  stdx::pmr::test_resource_trace_reader reader{ path };
+  ASSERT_TRUE(reader.is_open());
+  EXPECT_EQ(reader.threads(), static_cast<std::uint32_t>(thread_count));
+  EXPECT_EQ(reader.dropped(), static_cast<std::uint64_t>(dropped));
+
+  // the events of every thread keep their order
+  std::vector<std::uint64_t> last(thread_count, 0U);
+  std::uint64_t events = 0U;
+  stdx::pmr::test_resource_trace_event event;
+  while (reader.next(event))
+  {
+    ASSERT_LT(event.m_thread, static_cast<std::uint32_t>(thread_count));
+    EXPECT_GE(event.m_timestamp, last[event.m_thread]);
+    last[event.m_thread] = event.m_timestamp;
+    ++events;
+  }
+  EXPECT_EQ(events, reader.events());
+  std::filesystem::remove(path);
+}
+
+TEST(StdX_MemoryResource_test_resource, trace__half_full_ring_wakes_the_drainer)
+{
+  const auto path = std::filesystem::temp_directory_path() / "test_resource_trace_wakeup.bin";
+  {
+    // the interval alone would not drain the ring during the test
+    stdx::pmr::test_resource_trace_recorder recorder{ path, std::chrono::minutes(10), 256U };
+    stdx::pmr::test_resource tpmr{ "traced", false };
+    tpmr.set_trace_recorder(&recorder);
+    for (int i = 0; i < 64; ++i)
+    {
+      tpmr.deallocate(tpmr.allocate(32U), 32U);
+    }
+    tpmr.set_trace_recorder(nullptr);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (recorder.events() < 128LL && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(recorder.events(), 128LL);
+    EXPECT_EQ(recorder.dropped(), 0LL);
+  }
+  std::filesystem::remove(path);
+}
+
+TEST(StdX_MemoryResource_test_resource, replay__matches_the_recorded_blocks)
+{
+  const auto path = std::filesystem::temp_directory_path() / "test_resource_replay.bin";
+  {
+    stdx::pmr::test_resource tpmr{ "recorded", false };
+    void* early = tpmr.allocate(8U);
+    {
+      stdx::pmr::test_resource_trace_recorder recorder{ path };
+      tpmr.set_trace_recorder(&recorder);
+      void* a = tpmr.allocate(1000U, 64U);
+      void* b = tpmr.allocate(24U);
+      tpmr.deallocate(a, 1000U, 64U);
+      void* c = tpmr.allocate(3000U);
+      tpmr.deallocate(b, 24U);
+      tpmr.deallocate(early, 8U);
+      tpmr.deallocate(c, 3000U);
+      tpmr.set_trace_recorder(nullptr);
+    }
+  }
+
+  const stdx::pmr::test_resource_trace_replay replay{ path };
+  ASSERT_TRUE(replay.is_open());
+  EXPECT_EQ(replay.operations(), 6U);
+  EXPECT_EQ(replay.unmatched(), 1U);
+  EXPECT_EQ(replay.threads(), 1U);
+
+  stdx::pmr::test_resource* replayed = nullptr;
+  const auto result = replay.run([&replayed](std::pmr::memory_resource& upstream) {
+    auto resource = std::make_unique<stdx::pmr::test_resource>("replayed", false, &upstream);
+    replayed = resource.get();
+    return resource;
+  });
+  EXPECT_EQ(result.m_allocations, 3U);
+  EXPECT_EQ(result.m_deallocations, 3U);
+  EXPECT_EQ(result.m_peakBytes, 3024U);
+  EXPECT_GE(result.m_peakFootprint, 3024LL);
+  EXPECT_LE(result.m_allocationLatency.m_p50, result.m_allocationLatency.m_max);
+  EXPECT_GT(result.throughput(), 0.0);
+  EXPECT_NE(replayed, nullptr);
+
+  std::pmr::monotonic_buffer_resource monotonic;
+  const auto threaded = replay.run(monotonic, true);
+  EXPECT_EQ(threaded.m_allocations + threaded.m_deallocations, 6U);
+  EXPECT_EQ(threaded.m_peakFootprint, 0LL);
+
+  // the failed allocations neither leave the replaying thread nor get deallocated
+  stdx::pmr::test_resource limited{ "limited", false };
+  limited.set_allocation_limit(1LL);
+  const auto failed = replay.run(limited, true);
+  EXPECT_EQ(failed.m_allocations, 2U);
+  EXPECT_EQ(failed.m_failedAllocations, 1U);
+  EXPECT_EQ(failed.m_deallocations, 2U);
+  EXPECT_EQ(limited.blocks_in_use(), 0LL);
+  EXPECT_EQ(limited.status(), 0LL);
+  std::filesystem::remove(path);
+}
+
+TEST(StdX_MemoryResource_test_resource, async_reporter__writes_the_stream_reporter_text)
+{
+  std::ostringstream os;
+  stdx::pmr::async_test_resource_reporter reporter{ os };
+  void* p = nullptr;
+  {
+    stdx::pmr::test_resource tpmr{ "async", true, &reporter };
+    p = tpmr.allocate(24U, 8U);
+    tpmr.deallocate(p, 24U, 8U);
+    reporter.flush();
+    EXPECT_EQ(os.str(),
+      "test_resource async [0]: Allocated 24 bytes (aligned 8) at " + stdx::pmr::detail::report_formater<char>::addr2str(p) + ".\n"
+      "test_resource async [0]: Deallocated 24 bytes (aligned 8) at " + stdx::pmr::detail::report_formater<char>::addr2str(p) + ".\n");
+  }
+
+  // the state is written after the queued events
+  EXPECT_NE(os.str().find(".\n\n======================================================\n  TEST RESOURCE async STATE"), std::string::npos);
+  EXPECT_EQ(reporter.dropped(), 0LL);
+}
+
+namespace
+{
+  // the buffer holding back the writer of the reporter at the end of its first batch
+  class gated_buffer : public std::stringbuf
+  {
+  public:
+    std::atomic_bool m_open{ false };
+    std::atomic_bool m_waiting{ false };
+
+  protected:
+    int sync() override
+    {
+      m_waiting = true;
+      while (!m_open)
+      {
+        std::this_thread::yield();
+      }
+      return std::stringbuf::sync();
+    }
+  };
+}
+
+TEST(StdX_MemoryResource_test_resource, async_reporter__drops_the_overflowing_events)
+{
+  gated_buffer buffer;
+  std::ostream os{ &buffer };
+  stdx::pmr::async_test_resource_reporter reporter{ os, 4U, stdx::pmr::async_overflow::drop };
+  stdx::pmr::test_resource tpmr{ "dropping", true, &reporter };
+
+  void* first = tpmr.allocate(8U);
+  while (!buffer.m_waiting)
+  {
+    std::this_thread::yield();
+  }
+
+  void* blocks[10];
+  for (auto& block : blocks)
+  {
+    block = tpmr.allocate(8U);
+  }
+  EXPECT_EQ(reporter.dropped(), 6LL);
+
+  buffer.m_open = true;
+  reporter.flush();
+  const auto text = buffer.str();
+  EXPECT_EQ(std::count(text.begin(), text.end(), '\n'), 1 + 4);
+
+  for (auto* block : blocks)
+  {
+    tpmr.deallocate(block, 8U);
+  }
+  tpmr.deallocate(first, 8U);
+  reporter.flush();
+}
+
+TEST(StdX_MemoryResource_test_resource, buffered_reporter__writes_the_stream_reporter_text_when_flushed)
+{
+  std::ostringstream os;
+  stdx::pmr::buffered_test_resource_reporter reporter{ os, std::chrono::hours(1) };
+  stdx::pmr::test_resource tpmr{ "buffered", true, &reporter };
+
+  void* p = tpmr.allocate(1U, 1U);
+  void* q = tpmr.allocate(24U, 8U);
+  tpmr.deallocate(q, 24U, 8U);
+  EXPECT_TRUE(os.str().empty());
+
+  reporter.flush();
+  EXPECT_EQ(os.str(),
+    "test_resource buffered [0]: Allocated 1 byte (aligned 1) at " + stdx::pmr::detail::report_formater<char>::addr2str(p) + ".\n"
+    "test_resource buffered [1]: Allocated 24 bytes (aligned 8) at " + stdx::pmr::detail::report_formater<char>::addr2str(q) + ".\n"
+    "test_resource buffered [1]: Deallocated 24 bytes (aligned 8) at " + stdx::pmr::detail::report_formater<char>::addr2str(q) + ".\n");
+
+  // the state is written after the buffered events
+  tpmr.deallocate(p, 1U, 1U);
+  tpmr.print();
+  EXPECT_NE(os.str().find(" [0]: Deallocated 1 byte (aligned 1) at " + stdx::pmr::detail::report_formater<char>::addr2str(p) +
+    ".\n\n======================================================\n  TEST RESOURCE buffered STATE"), std::string::npos);
+}
+
+TEST(StdX_MemoryResource_test_resource, mem2str__writes_16_bytes_per_line_in_groups_of_4)
+{
+  using formater = stdx::pmr::detail::report_formater<char>;
+
+  alignas(16) unsigned char bytes[21];
+  for (std::size_t i = 0U; i < sizeof(bytes); ++i)
+  {
+    bytes[i] = static_cast<unsigned char>(0xf0U + i);
+  }
+
+  EXPECT_EQ(formater::mem2str(bytes, sizeof(bytes)),
+    formater::addr2str(bytes) + ":      f0 f1 f2 f3   f4 f5 f6 f7   f8 f9 fa fb   fc fd fe ff \n" +
+    formater::addr2str(bytes + 16) + ":      00 01 02 03   04 \n");
+  EXPECT_EQ(formater::mem2str(bytes, 0U), "\n");
+}
@@ -0,0 +1,119 @@
+#include <memory_resource.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#include <unistd.h>
+
+// Shows the usage counters of the test_resource instances published by
+// another process in its statistics page (see test_resource_stats_page).
+//
+//   test_resource_top [-i milliseconds] [-n refreshes] <pid | path>
+
+namespace
+{
+  void usage()
+  {
+    std::fprintf(stderr, "usage: test_resource_top [-i milliseconds] [-n refreshes] <pid | path>\n");
+  }
+
+  bool is_pid(const char* argument)
+  {
+    return '\0' != *argument && std::strspn(argument, "0123456789") == std::strlen(argument);
+  }
+
+  bool is_running(long long pid)
+  {
+    return 0 == ::kill(static_cast<pid_t>(pid), 0) || EPERM == errno;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  long interval = 1000;
+  long refreshes = 0;
+  int option;
+  while (-1 != (option = ::getopt(argc, argv, "i:n:")))
+  {
+    switch (option)
+    {
+    case 'i':
+      interval = std::strtol(optarg, nullptr, 10);
+      break;
+    case 'n':
+      refreshes = std::strtol(optarg, nullptr, 10);
+      break;
+    default:
+      usage();
+      return EXIT_FAILURE;
+    }
+  }
+  if (optind + 1 != argc || interval <= 0)
+  {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  const std::filesystem::path path = is_pid(argv[optind])
+    ? stdx::pmr::test_resource_stats_page::default_path(std::atoll(argv[optind]))
+    : std::filesystem::path(argv[optind]);
+  const stdx::pmr::test_resource_stats_page_reader page{ path };
+  if (!page.is_open())
+  {
+    std::fprintf(stderr, "test_resource_top: %s is not a statistics page\n", path.c_str());
+    return EXIT_FAILURE;
+  }
+
+  const bool terminal = 0 != ::isatty(STDOUT_FILENO);
+  // the allocations of the previous refresh by the record and its generation
+  std::map<std::pair<std::size_t, std::uint64_t>, long long> previous;
+  for (long refresh = 1; ; ++refresh)
+  {
+    auto entries = page.read();
+    std::sort(entries.begin(), entries.end(), [](const auto& left, const auto& right) {
+      return left.m_bytesInUse > right.m_bytesInUse;
+    });
+
+    if (terminal)
+    {
+      std::fputs("\x1b[H\x1b[2J", stdout);
+    }
+    std::printf("pid %lld, %zu resources\n\n", page.pid(), entries.size());
+    std::printf("%-32s %12s %16s %12s %16s %16s %12s\n",
+      "NAME", "BLOCKS", "BYTES", "MAX BLOCKS", "MAX BYTES", "ALLOCATIONS", "ALLOCS/S");
+
+    std::map<std::pair<std::size_t, std::uint64_t>, long long> current;
+    for (const auto& entry : entries)
+    {
+      const auto key = std::make_pair(entry.m_slot, entry.m_generation);
+      const auto found = previous.find(key);
+      const long long rate = previous.end() != found
+        ? (entry.m_allocations - found->second) * 1000LL / interval
+        : 0LL;
+      current.emplace(key, entry.m_allocations);
+
+      std::printf("%-32.32s %12lld %16lld %12lld %16lld %16lld %12lld\n",
+        entry.m_name.empty() ? "(unnamed)" : entry.m_name.c_str(), entry.m_blocksInUse, entry.m_bytesInUse,
+        entry.m_maxBlocks, entry.m_maxBytes, entry.m_allocations, rate);
+    }
+    std::fflush(stdout);
+    previous = std::move(current);
+
+    if (refresh == refreshes)
+    {
+      break;
+    }
+    if (!is_running(page.pid()))
+    {
+      std::printf("\nprocess %lld has exited\n", page.pid());
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+  }
+  return EXIT_SUCCESS;
+}